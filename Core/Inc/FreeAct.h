@@ -48,7 +48,7 @@ typedef struct {
 typedef struct Active Active; /* forward declaration */
 
 typedef void (*DispatchHandler)(Active * const me, Event const * const e);
-typedef  struct QueueTable {
+struct QueueTable {
  bool (*post)(void *queue, Event const * const e);
  bool (*postFROM_ISR)(void *queue, Event const * const e);
     Event * (*receive)(void *queue);
@@ -75,7 +75,7 @@ void Active_start(Active * const me,
                   uint32_t queueLen,
                   void *stackSto,
                   uint32_t stackSize,
-                    TaskFunction_t task );
+                    TaskFunction_t task ); /* NULL for the default event loop */
 void Active_post(Active * const me, Event const * const e);
 void Active_postFromISR(Active * const me, Event const * const e,
                         BaseType_t *pxHigherPriorityTaskWoken);
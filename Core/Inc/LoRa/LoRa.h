@@ -7,6 +7,8 @@
 // -------------------------------------------------- //
 #pragma once
 
+#include <stdatomic.h>
+
 #include "main.h"
 
 
@@ -19,6 +21,7 @@
 #define TRANSMIT_MODE           3
 #define RXCONTIN_MODE           5
 #define RXSINGLE_MODE           6
+#define CAD_MODE                7
 
 //------- BANDWIDTH -------//
 #define BW_7_8KHz           0
@@ -46,11 +49,26 @@
 #define SF_11               11
 #define SF_12               12
 
+//------ HEADER MODE ------//
+#define EXPLICIT_HEADER         0
+#define IMPLICIT_HEADER         1
+
 //------ POWER GAIN ------//
 #define POWER_11db          0xF6
 #define POWER_14db          0xF9
 #define POWER_17db          0xFC
 #define POWER_20db          0xFF
+#define POWER_PA_BOOST_DBM(dbm) (0xF0 | ((dbm) - 2))    // 2 to 17 dBm on PA_BOOST
+
+//------- FREQUENCY -------//
+#define LORA_FXOSC_HZ           32000000ULL
+#define LORA_FRF(hz)            ((uint32_t)((((uint64_t)(hz)) << 19) / LORA_FXOSC_HZ))
+
+//----- CHANNEL PLAN ------//
+#define LORA_CH_BASE_HZ         433175000UL
+#define LORA_CH_SPACING_HZ      200000UL
+#define LORA_CH_COUNT           8
+#define LORA_CH_HZ(idx)         (LORA_CH_BASE_HZ + (uint32_t)(idx) * LORA_CH_SPACING_HZ)
 
 //------- REGISTERS -------//
 #define RegFiFo             0x00
@@ -65,21 +83,64 @@
 #define RegFiFoTxBaseAddr       0x0E
 #define RegFiFoRxBaseAddr       0x0F
 #define RegFiFoRxCurrentAddr    0x10
+#define RegIrqFlagsMask         0x11
 #define RegIrqFlags             0x12
 #define RegRxNbBytes            0x13
+#define RegPktSnrValue          0x19
 #define RegPktRssiValue         0x1A
+#define RegHopChannel           0x1C
 #define RegModemConfig1         0x1D
 #define RegModemConfig2         0x1E
 #define RegSymbTimeoutL         0x1F
 #define RegPreambleMsb          0x20
 #define RegPreambleLsb          0x21
 #define RegPayloadLength        0x22
+#define RegHopPeriod            0x24
+#define RegFeiMsb               0x28
+#define RegFeiMid               0x29
+#define RegFeiLsb               0x2A
 #define RegModemConfig3         0x26
+#define RegRssiWideband         0x2C
 #define RegSyncWord             0x39
 #define RegDioMapping1          0x40
 #define RegDioMapping2          0x41
 #define RegVersion          0x42
 
+//------- IRQ FLAGS -------//
+#define IRQ_RX_TIMEOUT          0x80
+#define IRQ_RX_DONE             0x40
+#define IRQ_PAYLOAD_CRC_ERROR   0x20
+#define IRQ_VALID_HEADER        0x10
+#define IRQ_TX_DONE             0x08
+#define IRQ_CAD_DONE            0x04
+#define IRQ_FHSS_CHANGE_CHANNEL 0x02
+#define IRQ_CAD_DETECTED        0x01
+#define IRQ_ALL                 0xFF
+
+//------ DIO MAPPING ------//
+// RegDioMapping1 --> | DIO0 | DIO1 | DIO2 | DIO3 |
+#define DIO0_RX_DONE            0x00
+#define DIO0_TX_DONE            0x40
+#define DIO0_CAD_DONE           0x80
+#define DIO1_RX_TIMEOUT         0x00
+#define DIO1_FHSS_CHANGE_CHANNEL 0x10
+#define DIO1_CAD_DETECTED       0x20
+#define DIO2_FHSS_CHANGE_CHANNEL 0x00
+
+//-------- RESET ----------//
+#define LORA_RESET_PULSE_MS     2       // NRESET low, >= 100 us (1 ms tick + slack)
+#define LORA_RESET_READY_MS     6       // NRESET high until SPI works, >= 5 ms (+ slack)
+
+//-------- RX RING --------//
+#define LORA_RX_RING_LEN        4       // power of two
+#define LORA_RX_SLOT_SIZE       64      // an aggregate of 4 mesh frames
+
+//------- SPI STATS -------//
+// build with -DLORA_SPI_STATS=1 to count the SPI traffic of the driver, all radios
+#ifndef LORA_SPI_STATS
+#define LORA_SPI_STATS          0
+#endif
+
 //------ LORA STATUS ------//
 #define LORA_OK             200
 #define LORA_NOT_FOUND          404
@@ -99,39 +160,104 @@ typedef struct LoRa_setting{
 
     // Module settings:
     int         current_mode;
-    int             frequency;
+    uint32_t        frequency;
+    uint32_t        frf;
+    int32_t         frfOffset;          // AFC correction added to every Frf write, Fstep units
+    uint8_t         channel;
     uint8_t         spredingFactor;
     uint8_t         bandWidth;
     uint8_t         crcRate;
     uint16_t        preamble;
     uint8_t         power;
     uint8_t         overCurrentProtection;
+    uint8_t         headerMode;
+    uint8_t         payloadLength;      // fixed frame length in IMPLICIT_HEADER mode
+    struct LoRa_rxRing* rxRing;         // fetched before RX is left, NULL: none
 
 } LoRa;
 
+// link quality of a received packet, read out together with it
+typedef struct LoRa_pktStatus{
+    int16_t         rssi;               // dBm
+    int8_t          snr;                // dB
+    uint8_t         length;             // RegRxNbBytes, bytes on air
+    int32_t         fei;                // carrier offset of the sender, Hz
+} LoRa_pktStatus;
+
+// one received frame: status taken by the DIO0 ISR, payload fetched by the task
+typedef struct LoRa_rxSlot{
+    uint8_t         length;             // bytes copied into data
+    uint8_t         fifoAddr;           // where the packet sits in the module FiFo
+    LoRa_pktStatus  status;
+    uint32_t        timestamp;          // RxDone edge, in the caller's timebase
+    uint8_t         data[LORA_RX_SLOT_SIZE];
+} LoRa_rxSlot;
+
+// single producer (DIO0 ISR) / single consumer (task) ring of received frames,
+// the ISR takes status and FiFo position, the task fetches the payload
+typedef struct LoRa_rxRing{
+    LoRa_rxSlot     slot[LORA_RX_RING_LEN];
+    _Atomic uint8_t head;               // written by the producer only
+    _Atomic uint8_t tail;               // written by the consumer only
+    uint8_t         fetched;            // consumer only, payloads copied up to here
+    uint32_t        dropped;            // frames lost because the ring was full
+} LoRa_rxRing;
+
+// SPI traffic since boot or the last LoRa_resetSpiStats
+typedef struct LoRa_spiStats{
+    uint32_t        transactions;       // NSS low periods
+    uint32_t        bytes;              // bytes clocked, address bytes included
+} LoRa_spiStats;
+
 
 LoRa newLoRa(void);
 void LoRa_reset(LoRa* _LoRa);
+void LoRa_resetAssert(LoRa* _LoRa);
+void LoRa_resetRelease(LoRa* _LoRa);
 void LoRa_readReg(LoRa* _LoRa, uint8_t* address, uint16_t r_length, uint8_t* output, uint16_t w_length);
 void LoRa_writeReg(LoRa* _LoRa, uint8_t* address, uint16_t r_length, uint8_t* values, uint16_t w_length);
 void LoRa_gotoMode(LoRa* _LoRa, int mode);
 uint8_t LoRa_read(LoRa* _LoRa, uint8_t address);
 void LoRa_write(LoRa* _LoRa, uint8_t address, uint8_t value);
 void LoRa_BurstWrite(LoRa* _LoRa, uint8_t address, uint8_t *value, uint8_t length);
+void LoRa_BurstRead(LoRa* _LoRa, uint8_t address, uint8_t *value, uint8_t length);
 uint8_t LoRa_isvalid(LoRa* _LoRa);
+void LoRa_applyConfig(LoRa* _LoRa);
+
+uint32_t LoRa_symbolTime(uint8_t SF, uint8_t BW);
+uint32_t LoRa_timeOnAir(uint8_t SF, uint8_t BW, uint8_t CR, uint16_t preamble, uint8_t length,
+                        uint8_t implicitHeader, uint8_t crcOn, uint8_t LDRO);
+uint32_t LoRa_packetTimeOnAir(LoRa* _LoRa, uint8_t length);
 
 void LoRa_setLowDaraRateOptimization(LoRa* _LoRa, uint8_t value);
 void LoRa_setAutoLDO(LoRa* _LoRa);
-void LoRa_setFrequency(LoRa* _LoRa, int freq);
+void LoRa_setFrequency(LoRa* _LoRa, uint32_t freq);
+uint8_t LoRa_setChannel(LoRa* _LoRa, uint8_t idx);
+void LoRa_setFrequencyOffset(LoRa* _LoRa, int32_t hz);
+void LoRa_setHopPeriod(LoRa* _LoRa, uint8_t symbols);
+void LoRa_hopChannel(LoRa* _LoRa, uint8_t const* sequence, uint8_t length, uint8_t first);
 void LoRa_setSpreadingFactor(LoRa* _LoRa, int SP);
 void LoRa_setPower(LoRa* _LoRa, uint8_t power);
 void LoRa_setOCP(LoRa* _LoRa, uint8_t current);
 void LoRa_setTOMsb_setCRCon(LoRa* _LoRa);
 void LoRa_setSyncWord(LoRa* _LoRa, uint8_t syncword);
 uint8_t LoRa_transmit(LoRa* _LoRa, uint8_t* data, uint8_t length, uint16_t timeout);
+void LoRa_startTransmit(LoRa* _LoRa, uint8_t* data, uint8_t length);
 void LoRa_startReceiving(LoRa* _LoRa);
+void LoRa_startCAD(LoRa* _LoRa);
+uint8_t LoRa_getIrqFlags(LoRa* _LoRa);
+void LoRa_clearIrqFlags(LoRa* _LoRa, uint8_t mask);
+uint32_t LoRa_random(LoRa* _LoRa);
 uint8_t LoRa_receive(LoRa* _LoRa, uint8_t* data, uint8_t length);
-void LoRa_receive_IT(LoRa* _LoRa, uint8_t* data, uint8_t length);
+uint8_t LoRa_receiveToRing(LoRa* _LoRa, LoRa_rxRing* ring, uint32_t timestamp);
+void LoRa_rxRingFetch(LoRa* _LoRa, LoRa_rxRing* ring);
+LoRa_rxSlot* LoRa_rxRingFront(LoRa_rxRing* ring);
+void LoRa_rxRingPop(LoRa_rxRing* ring);
 int LoRa_getRSSI(LoRa* _LoRa);
-void short_delay_ms(uint32_t ms);
+void LoRa_getPacketStatus(LoRa* _LoRa, LoRa_pktStatus* status);
 uint16_t LoRa_init(LoRa* _LoRa);
+void LoRa_spiLockIrq(IRQn_Type irq);
+#if LORA_SPI_STATS
+void LoRa_getSpiStats(LoRa_spiStats* stats);
+void LoRa_resetSpiStats(void);
+#endif
@@ -9,8 +9,30 @@
 #include "LoRa.h"
 #include "semphr.h"
 
+/* wiring of every SX127x on the board, index is the radio number */
+typedef struct {
+    GPIO_TypeDef *CS_port;
+    uint16_t CS_pin;
+    GPIO_TypeDef *reset_port;
+    uint16_t reset_pin;
+    GPIO_TypeDef *DIO0_port;
+    uint16_t DIO0_pin;
+    GPIO_TypeDef *DIO2_port; /* FhssChangeChannel, NULL when not wired */
+    uint16_t DIO2_pin;
+    SPI_HandleTypeDef *hSPIx;
+} LoRa_hw;
 
-LoRa* LoRa_Startup();
+/* a second radio is built in once CubeMX has its pins */
+#if defined(NSS2_Pin) && defined(RESET2_Pin) && defined(DID0_2_Pin)
+#define LORA_RADIO_COUNT 2U
+#else
+#define LORA_RADIO_COUNT 1U
+#endif
+
+extern const LoRa_hw LoRa_radios[LORA_RADIO_COUNT];
+
+void LoRa_attach(LoRa *lora_instance, uint8_t radio);
+LoRa* LoRa_Startup(LoRa *lora_instance, uint8_t radio);
 uint8_t LoRa_receive_safe(LoRa *lora, uint8_t *data, uint8_t length, SemaphoreHandle_t lora_mutex_handle);
 uint8_t LoRa_transmit_safe(uint8_t *data, uint8_t length, uint16_t timeout);
 
@@ -0,0 +1,86 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef ARQ_H
+#define ARQ_H
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "packet_t.h"
+
+/*
+ * End-to-end selective-repeat ARQ, one window per peer. A reliable frame
+ * (requires_ack) starts its payload with [seq, cumulative ack], so every data
+ * frame piggybacks the ack of the opposite direction (flags.ack). When no data
+ * goes back within ARQ_ACK_DELAY_MS a standalone ACK (flags.ack alone) carries
+ * [cumulative ack, 32-bit map of the frames received past it].
+ * Every transmission, retransmissions included, gets a fresh msg_id so the relays'
+ * duplicate caches let it through; seq is what the peers match.
+ * Peers forget each other (ARQ_PEERS, reboots): a sender restarts at seq 0 with
+ * flags.syn set until its first ack, a receiver that sees a syn after plain frames,
+ * or a seq far outside its window, restarts from there.
+ */
+#define ARQ_PEERS 4U
+#define ARQ_WINDOW 4U /* frames in flight per peer, a full window fits in a radio's interactive queue */
+#define ARQ_DATA_LEN (MESH_MAX_PAYLOAD - 2U)
+#define ARQ_MAX_TRIES 5U
+#define ARQ_ACK_DELAY_MS 150UL
+
+/* retransmission timeout, Jacobson/Karels over the measured round trips */
+#define ARQ_RTO_INIT_MS 3000UL
+#define ARQ_RTO_MIN_MS 500UL
+#define ARQ_RTO_MAX_MS 20000UL
+
+typedef struct arq_tx {
+    uint8_t data[ARQ_DATA_LEN];
+    uint32_t sent; /* ms, last transmission */
+    uint8_t tries; /* transmissions so far, 0: not sent yet */
+    bool acked;
+} arq_tx_t;
+
+typedef struct arq_peer {
+    uint8_t peer; /* MESH_BROADCAST_ID: free */
+    uint32_t last_active; /* ms */
+    /* sending */
+    uint8_t tx_base; /* oldest seq not acked */
+    uint8_t tx_next; /* seq of the next new frame */
+    arq_tx_t tx[ARQ_WINDOW]; /* indexed by seq % ARQ_WINDOW */
+    uint32_t srtt; /* ms * 8, 0: no sample yet */
+    uint32_t rttvar; /* ms * 4 */
+    uint32_t rto; /* ms */
+    uint32_t failed; /* frames given up after ARQ_MAX_TRIES */
+    bool tx_synced; /* the peer acked this run of seqs, no more syn */
+    /* receiving */
+    uint8_t rx_next; /* every seq before it arrived */
+    uint32_t rx_map; /* bit i: rx_next + 1 + i arrived */
+    bool rx_syn; /* in the peer's syn phase */
+    bool ack_pending;
+    uint32_t ack_due; /* ms */
+} arq_peer_t;
+
+void arq_init(void);
+
+/* the state kept for 'peer', a new one (replacing the longest idle) when 'create' */
+arq_peer_t *arq_find(uint8_t peer, bool create, uint32_t now);
+
+/* sending: queue data[ARQ_DATA_LEN] under a new seq, false while the window is full */
+bool arq_tx_push(arq_peer_t *p, uint8_t const *data, uint8_t *seq, uint32_t now);
+void arq_tx_sent(arq_peer_t *p, uint8_t seq, uint32_t now);
+void arq_rx_ack(arq_peer_t *p, uint8_t cum, uint32_t map, uint32_t now);
+
+/* receiving: true if seq is new and has to be delivered */
+bool arq_rx_data(arq_peer_t *p, uint8_t seq, bool syn, uint32_t now);
+/* ack to send now, piggybacked or standalone; clears the pending one */
+void arq_ack_take(arq_peer_t *p, uint8_t *cum, uint32_t *map);
+
+/* the frame of p due for (re)transmission, false if none; gives up after ARQ_MAX_TRIES */
+bool arq_tx_due(arq_peer_t *p, uint8_t *seq, uint32_t now);
+
+/* i-th peer slot, NULL when free */
+arq_peer_t *arq_at(uint8_t i);
+
+/* ms until the next retransmission or standalone ACK of any peer, UINT32_MAX if none */
+uint32_t arq_next_deadline(uint32_t now);
+
+#endif //ARQ_H
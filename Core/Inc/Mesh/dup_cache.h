@@ -0,0 +1,27 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef DUP_CACHE_H
+#define DUP_CACHE_H
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Frames seen recently, keyed by (src_id, msg_id), so a flooded frame is handled
+ * once however many copies we hear. msg_id is the 16-bit one packet_msg_id_expand
+ * gives back, not the byte on the wire. Open addressing over a fixed array: a key
+ * lives within DUP_CACHE_PROBES slots of its hash, so a lookup touches at most that
+ * many adjacent 8-byte entries. Entries older than DUP_CACHE_AGE_MS count as free.
+ */
+#define DUP_CACHE_BITS 5
+#define DUP_CACHE_SIZE (1U << DUP_CACHE_BITS)
+#define DUP_CACHE_PROBES 8U
+#define DUP_CACHE_AGE_MS 30000UL /* longer than a flood takes to die out */
+
+void dup_cache_init(void);
+
+/* true if (src_id, msg_id) was seen within DUP_CACHE_AGE_MS, otherwise records it */
+bool dup_cache_check(uint8_t src_id, uint16_t msg_id, uint32_t now);
+
+#endif //DUP_CACHE_H
@@ -0,0 +1,95 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef FRAG_H
+#define FRAG_H
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "packet_t.h"
+
+/*
+ * Fragmentation of unicast messages longer than MESH_MAX_PAYLOAD. Every fragment
+ * is a frame with flags.fragment set and the payload [tag, index, ...]:
+ *   index 0:        [tag, 0, length LE16, CRC-16 of the whole message LE16]
+ *   index 1..count: [tag, index, FRAG_DATA_LEN bytes of the message]
+ * The receiver reassembles into one of FRAG_RX_SLOTS static buffers, running the
+ * CRC over the fragments as they line up, and answers with a status frame
+ * (flags.fragment and flags.ack): [tag, base, map LE32], bit i of map set when
+ * fragment base + i is still missing, base the first missing one. A zero map
+ * means the message arrived. Status goes out FRAG_GAP_MS after the last fragment
+ * heard, at once when the message completes or a header comes again.
+ * The sender sends FRAG_TX_BURST fragments every FRAG_TX_PACE_MS (the radios
+ * queue RA02_TXQ_BULK_LEN of them), then only what status frames ask for. Without
+ * an answer within FRAG_STATUS_TIMEOUT_MS it probes with the header again and
+ * gives up after FRAG_MAX_PROBES.
+ */
+#define FRAG_DATA_LEN (MESH_MAX_PAYLOAD - 2U)
+#define FRAG_MAX_LEN 512U /* bytes per message, RAM: one TX and FRAG_RX_SLOTS RX buffers */
+#define FRAG_MAX_COUNT ((FRAG_MAX_LEN + FRAG_DATA_LEN - 1U) / FRAG_DATA_LEN)
+#define FRAG_MAP_BYTES ((FRAG_MAX_COUNT + 1U + 7U) / 8U) /* one bit per fragment, header included */
+#define FRAG_RX_SLOTS 2U
+#define FRAG_RX_TIMEOUT_MS 30000UL /* a message that stops making progress is dropped */
+#define FRAG_GAP_MS 1000UL
+#define FRAG_TX_BURST 2U
+#define FRAG_TX_PACE_MS 250UL
+#define FRAG_STATUS_TIMEOUT_MS 5000UL
+#define FRAG_MAX_PROBES 4U
+
+typedef struct frag_tx {
+    _Atomic bool busy; /* set by frag_tx_start, cleared by the router once the message is acked or given up */
+    uint8_t dest;
+    uint8_t tag;
+    uint16_t length;
+    uint16_t crc;
+    uint8_t count; /* data fragments */
+    uint8_t pending[FRAG_MAP_BYTES]; /* fragments still to (re)send */
+    uint8_t burst; /* sent in the running FRAG_TX_PACE_MS */
+    uint8_t probes; /* headers sent without an answer */
+    uint32_t due; /* ms, next burst, else the status timeout */
+    uint32_t sent; /* messages acked */
+    uint32_t failed; /* messages given up */
+    uint8_t data[FRAG_MAX_LEN];
+} frag_tx_t;
+
+typedef struct frag_rx {
+    uint8_t src; /* MESH_BROADCAST_ID: free */
+    uint8_t tag;
+    bool header; /* length and crc known */
+    bool done; /* delivered, kept to answer late probes */
+    uint16_t length;
+    uint16_t crc;
+    uint16_t crc_run; /* over the data fragments before crc_next */
+    uint8_t crc_next;
+    uint8_t count;
+    uint8_t received[FRAG_MAP_BYTES];
+    bool status_pending;
+    uint32_t status_due; /* ms */
+    uint32_t last_active; /* ms */
+    uint8_t data[FRAG_MAX_COUNT * FRAG_DATA_LEN];
+} frag_rx_t;
+
+void frag_init(void);
+
+/*
+ * sending, one message at a time. frag_tx_start belongs to the application task, it
+ * fails while a message is in flight or length is out of range. The rest belongs to
+ * the router and does nothing while no message is in flight.
+ */
+bool frag_tx_start(uint8_t dest, uint8_t const *data, uint16_t length, uint32_t now);
+/* next fragment to send now, false if none; gives up after FRAG_MAX_PROBES */
+bool frag_tx_next(uint8_t *dest, uint8_t *payload, uint32_t now);
+/* a status frame from src */
+void frag_tx_status(uint8_t src, uint8_t const *payload, uint32_t now);
+
+/* receiving: a fragment from src, the slot holding the message once it is complete and checked, else NULL */
+frag_rx_t const *frag_rx(uint8_t src, uint8_t const *payload, uint32_t now);
+/* status frame to send now, false if none */
+bool frag_status_take(uint8_t *dest, uint8_t *payload, uint32_t now);
+
+/* ms until the next burst, probe or status, UINT32_MAX if none */
+uint32_t frag_next_deadline(uint32_t now);
+
+#endif //FRAG_H
@@ -0,0 +1,50 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef NEIGHBOR_TABLE_H
+#define NEIGHBOR_TABLE_H
+#include <stdbool.h>
+#include <stdint.h>
+
+#define NEIGHBOR_TABLE_SIZE 16
+#define NEIGHBOR_EWMA_SHIFT 3 /* new sample weighs 1/8 */
+
+/*
+ * Link cost for routing, an ETX-like estimate from the SNR margin: 1 for a link
+ * that hardly loses frames, doubling as the margin shrinks. The floor is the one
+ * of the network SF (SF7, -7.5 dB).
+ */
+#define NEIGHBOR_SNR_FLOOR (-120) /* dB * 16 */
+#define NEIGHBOR_MIN_FRAMES 3U /* heard at full power before the link is used */
+#define NEIGHBOR_MAX_AGE_MS 180000UL /* silent for longer: link is gone */
+#define NEIGHBOR_COST_UNUSABLE 0xFFU
+
+/*
+ * Link quality of a node we hear directly. Every frame counts as a sign of life,
+ * only frames sent at full power (broadcasts, ADR trims unicast frames) go into
+ * RSSI and SNR: the trim is the sender's choice, not the link's.
+ */
+typedef struct neighbor {
+    uint8_t id;
+    uint8_t rx_count; /* frames heard, saturates at 255 */
+    uint8_t link_count; /* of them sent at full power, saturates at 255 */
+    int16_t rssi; /* EWMA of packet RSSI at full power, dBm * 16 */
+    int16_t snr; /* EWMA of packet SNR at full power, dB * 16 */
+    uint32_t last_seen; /* ms */
+    int16_t carrier; /* EWMA of its carrier against our uncorrected synthesizer, Hz */
+} neighbor_t;
+
+#define NEIGHBOR_CARRIER_UNKNOWN INT16_MIN /* no broadcast frame heard yet */
+
+/*
+ * One table for all radios: the radio AOs write it, the Router reads it. Every call
+ * is one short scan with the scheduler suspended, entries only leave it as copies.
+ */
+void neighbor_table_init(void);
+bool neighbor_table_update(uint8_t id, int16_t rssi, int8_t snr, bool full_power, uint32_t now);
+bool neighbor_table_find(uint8_t id, neighbor_t *out);
+void neighbor_table_carrier(uint8_t id, int32_t carrier_hz);
+uint8_t neighbor_table_cost(neighbor_t const *n, uint32_t now);
+
+#endif //NEIGHBOR_TABLE_H
@@ -0,0 +1,48 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef ROUTE_TABLE_H
+#define ROUTE_TABLE_H
+#include <stdint.h>
+
+#include "packet_t.h"
+
+/*
+ * Distance vector: every node advertises its routes as (dest, cost) pairs in
+ * connected_nodes_info frames, a neighbor's route costs its advertised cost plus
+ * our link cost to it. The route through the current next hop always follows
+ * that hop's adverts, another one only takes over when it is cheaper.
+ * A route that is lost (its next hop advertises it unreachable, or it ages out)
+ * is poisoned rather than forgotten: it stays in the table at ROUTE_COST_INFINITE
+ * for ROUTE_HOLDDOWN_MS, advertised like that so the nodes routing through us drop
+ * it too, and only a direct link to dest replaces it meanwhile. Without that a
+ * neighbor still advertising the old route would sell it back to us and the two
+ * count to infinity.
+ */
+#define ROUTE_TABLE_SIZE 16
+#define ROUTE_COST_INFINITE 16U /* bounds counting to infinity */
+#define ROUTE_MAX_AGE_MS 180000UL /* three missed adverts */
+#define ROUTE_HOLDDOWN_MS 150000UL /* a full advert round, so the poison goes out at least once */
+#define ROUTE_ADVERT_PAIRS (MESH_MAX_PAYLOAD / 2) /* per frame, the table rotates */
+
+typedef struct route {
+    uint8_t dest; /* MESH_BROADCAST_ID: free */
+    uint8_t next_hop;
+    uint8_t cost; /* ROUTE_COST_INFINITE: poisoned, held down */
+    uint32_t updated; /* ms, since when it is poisoned */
+} route_t;
+
+void route_table_init(void);
+void route_table_update(uint8_t dest, uint8_t next_hop, uint32_t cost, uint32_t now);
+
+/* next hop towards dest, MESH_BROADCAST_ID if there is no route */
+uint8_t route_table_next_hop(uint8_t dest, uint32_t now);
+
+/* an advert payload from neighbor 'src', reached at 'link_cost' */
+void route_table_advert_rx(uint8_t src, uint8_t link_cost, uint8_t const payload[MESH_MAX_PAYLOAD], uint32_t now);
+
+/* the next ROUTE_ADVERT_PAIRS routes from *cursor on, poisoned ones included, unused pairs are MESH_BROADCAST_ID */
+void route_table_advert_tx(uint8_t payload[MESH_MAX_PAYLOAD], uint8_t *cursor, uint32_t now);
+
+#endif //ROUTE_TABLE_H
@@ -4,22 +4,33 @@
 
 #ifndef PACKET_H
 #define PACKET_H
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 
 #define MESH_MAX_PAYLOAD 6
-#define MESH_MAX_HOPS 5
+#define MESH_MAX_HOPS 5 /* every frame starts out with it, but adverts and beacons (0, never relayed) */
 #define  MESH_BROADCAST_ID 255U
 
+#ifndef MESH_NODE_ID
+#define MESH_NODE_ID 1U /* this node, set per board at build time */
+#endif
+
 typedef struct  __attribute__((packed)) flags {
 uint8_t requires_ack:1;
 uint8_t broadcasting:1;
 uint8_t needs_forwarding:1;
 uint8_t connected_nodes_info:1;
+uint8_t beacon:1; /* TDMA superframe beacon, payload is the slot table */
+uint8_t ack:1; /* carries an ARQ ack, see Mesh/arq.h */
+uint8_t syn:1; /* ARQ: the sender restarted its seqs */
+uint8_t fragment:1; /* piece of a long unicast message, see Mesh/frag.h */
 
 }flags;
 
 
+/* a frame in memory, between the AOs; on air it goes in the wire format below */
 typedef struct __attribute__((packed))  packet_t {
 
 uint8_t src_id;
@@ -28,9 +39,136 @@ flags flags;
 uint8_t max_hops;
 uint16_t msg_id;
 uint8_t payload[MESH_MAX_PAYLOAD];
-uint16_t crc;
-uint16_t padding;
+uint8_t next_hop; /* relay that should pass it on, MESH_BROADCAST_ID floods; per hop */
 }packet_t;
+
+/*
+ * CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF, no reflection, no final XOR).
+ * CRC16_IMPL picks speed against flash: a byte table (512 B), a nibble table
+ * (32 B, two lookups per byte) or the plain shift loop. All give the same CRC.
+ * The F103 CRC unit only does CRC-32, so it is no use here.
+ */
+#define CRC16_BITWISE 0
+#define CRC16_NIBBLE 1
+#define CRC16_TABLE 2
+
+#ifndef CRC16_IMPL
+#define CRC16_IMPL CRC16_TABLE
+#endif
+
+#define CRC16_INIT 0xFFFFU
+
+/* continues crc over data, start from CRC16_INIT; for frames that come in pieces */
+uint16_t crc16_update(uint16_t crc, const uint8_t *data, uint16_t length);
 uint16_t crc16(const uint8_t *data, uint16_t length);
-int build_packet(packet_t *pkt ,const uint8_t src_id ,const uint8_t dest_id ,const flags flags ,const uint8_t max_hops ,const uint16_t msg_id ,const uint8_t *payload );
+/*
+ * Wire format, version 1, 6 to 14 bytes:
+ *   [ver:2 | bcast:1 | routed:1 | length:3 | 0:1]   length: payload bytes on air
+ *   [kind:3 | syn:1 | 0:1 | max_hops:3]
+ *   src_id, dest_id (not when bcast), msg_id low byte, next_hop (only when routed),
+ *   payload, CRC-16 LE over all of it
+ * The flags travel as a kind, one of the combinations the mesh uses; broadcasting
+ * and needs_forwarding follow from the destination (broadcast, unicast): every
+ * unicast frame may be relayed, flooded where no route is known. Trailing
+ * zero bytes of the payload stay off the air. msg_id goes as its low byte and a
+ * decoded frame carries only that. The router, the one owner for both radios,
+ * puts the other byte back with packet_msg_id_expand before the duplicate cache.
+ */
+#define PACKET_WIRE_VERSION 1U
+#define PACKET_WIRE_MIN 6U
+#define PACKET_WIRE_MAX (PACKET_WIRE_MIN + 2U + MESH_MAX_PAYLOAD)
+
+/* last msg_id expanded per source, the oldest source is forgotten first */
+#define PACKET_MSG_REFS 32U
+/* a frame this many ids behind the last one of its source still expands backwards */
+#define PACKET_MSG_REORDER 32U
+
+typedef struct packet_msg_refs {
+    uint8_t src[PACKET_MSG_REFS]; /* MESH_BROADCAST_ID: free */
+    uint16_t msg_id[PACKET_MSG_REFS];
+    uint8_t next; /* replaced next */
+} packet_msg_refs_t;
+
+void packet_msg_refs_init(packet_msg_refs_t *refs);
+
+/*
+ * the 16-bit msg_id ending in low, nearest the last one from src_id: up to
+ * PACKET_MSG_REORDER behind it, up to 255 - PACKET_MSG_REORDER ahead. Only a
+ * newer id moves the reference, a late frame leaves it where it is.
+ */
+uint16_t packet_msg_id_expand(packet_msg_refs_t *refs, uint8_t src_id, uint8_t low);
+
+/*
+ * Read access to a frame in memory. The wire format is too packed to read in
+ * place: packet_decode checks a received frame and expands it into a packet_t
+ * form buffer, one copy, and the accessors read the fields out of that buffer.
+ * The buffer has to outlive the view.
+ */
+typedef enum {
+    PACKET_OK,
+    PACKET_BAD_LENGTH,
+    PACKET_BAD_CRC,
+    PACKET_BAD_VERSION,
+    PACKET_BAD_HOPS,
+    PACKET_BAD_FLAGS, /* unknown kind or reserved bits, syn outside ARQ data */
+    PACKET_BAD_ADDRESS /* from the broadcast address or to itself */
+} packet_status_t;
+
+typedef struct packet_view_t {
+    const uint8_t *raw; /* sizeof(packet_t) bytes, packet_t layout */
+} packet_view_t;
+
+/* encodes the frame in memory for the air, returns its length, 0 if its flags have no kind */
+uint8_t packet_encode(uint8_t *wire, const uint8_t *frame);
+
+/* checks wire[length] and decodes it into frame[sizeof(packet_t)] */
+packet_status_t packet_decode(packet_view_t *view, uint8_t *frame, const uint8_t *wire, uint16_t length);
+
+/* length of the frame wire starts with, for implicit header mode where the PHY does not tell */
+uint8_t packet_wire_length(const uint8_t *wire);
+
+static inline uint8_t packet_view_src(packet_view_t const *view) {
+    return view->raw[offsetof(packet_t, src_id)];
+}
+
+static inline uint8_t packet_view_dest(packet_view_t const *view) {
+    return view->raw[offsetof(packet_t, dest_id)];
+}
+
+static inline flags packet_view_flags(packet_view_t const *view) {
+    flags f;
+    (void)memcpy(&f, &view->raw[offsetof(packet_t, flags)], sizeof(f));
+    return f;
+}
+
+static inline uint8_t packet_view_max_hops(packet_view_t const *view) {
+    return view->raw[offsetof(packet_t, max_hops)];
+}
+
+static inline uint16_t packet_view_msg_id(packet_view_t const *view) {
+    return (uint16_t)(view->raw[offsetof(packet_t, msg_id)]
+                      | ((uint16_t)view->raw[offsetof(packet_t, msg_id) + 1U] << 8));
+}
+
+static inline const uint8_t *packet_view_payload(packet_view_t const *view) {
+    return &view->raw[offsetof(packet_t, payload)];
+}
+
+static inline uint8_t packet_view_next_hop(packet_view_t const *view) {
+    return view->raw[offsetof(packet_t, next_hop)];
+}
+
+/* route a built frame */
+static inline void packet_set_next_hop(uint8_t *buf, uint8_t next_hop) {
+    buf[offsetof(packet_t, next_hop)] = next_hop;
+}
+
+static inline void packet_set_msg_id(uint8_t *buf, uint16_t msg_id) {
+    buf[offsetof(packet_t, msg_id)] = (uint8_t)msg_id;
+    buf[offsetof(packet_t, msg_id) + 1U] = (uint8_t)(msg_id >> 8);
+}
+
+/* builds a flooded frame in memory straight into buf (e.g. a TX request), returns its length */
+uint8_t packet_write(uint8_t *buf, uint8_t src_id, uint8_t dest_id, flags flags, uint8_t max_hops, uint16_t msg_id,
+                     const uint8_t *payload);
 #endif //PACKET_H
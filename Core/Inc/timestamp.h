@@ -0,0 +1,22 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+#include <stdint.h>
+
+/*
+ * Free-running 1 MHz timebase built on the DWT cycle counter, for stamping
+ * radio IRQ edges. The CPU clock is counted, so the resolution is one cycle
+ * (125 ns at 8 MHz) rounded down to the microsecond.
+ *
+ * The result wraps after 2^32 us (~71 min); compare stamps by unsigned
+ * subtraction. CYCCNT itself wraps much sooner (536 s at 8 MHz), so
+ * timestamp_now_us() must run at least that often - the HAL tick does it.
+ */
+
+void timestamp_init(void);
+uint32_t timestamp_now_us(void); /* safe from tasks and ISRs */
+
+#endif //TIMESTAMP_H
@@ -45,11 +45,17 @@ void Active_start(Active * const me,
     uint32_t stk_depth = (stackSize / sizeof(StackType_t));
 
     // (void)opt; /* unused parameter */
-//TODO init the queue
+    if (me->queue == (void *)0) {       /* no custom queue - use FreeRTOS */
+        me->queue = xQueueCreateStatic(
+                  queueLen,             /* queue length - provided by user */
+                  sizeof(Event *),      /* item size */
+                  (uint8_t *)queueSto,  /* queue storage - provided by user */
+                  &me->queue_cb);       /* queue control block */
+    }
     configASSERT(me->queue);            /* queue must be created */
 
     me->thread = xTaskCreateStatic(
-              task,        /* the thread function */
+              task != NULL ? task : &Active_eventLoop, /* the thread function */
               "AO" ,                    /* the name of the task */
               stk_depth,                /* stack depth */
               me,                       /* the 'pvParameters' parameter */
@@ -62,16 +68,18 @@ void Active_start(Active * const me,
 
 /*..........................................................................*/
 void Active_post(Active * const me, Event const * const e) {
-   //TODO add to queue
-    // configASSERT(status == pdTRUE);
+    BaseType_t status = xQueueSendToBack(me->queue, (void const *)&e,
+                                         (TickType_t)0);
+    configASSERT(status == pdTRUE);
 }
 
 /*..........................................................................*/
 void Active_postFromISR(Active * const me, Event const * const e,
                         BaseType_t *pxHigherPriorityTaskWoken)
 {
-//todo : add to queue from ISR
-    // configASSERT(status == pdTRUE);
+    BaseType_t status = xQueueSendToBackFromISR(me->queue, (void const *)&e,
+                                                pxHigherPriorityTaskWoken);
+    configASSERT(status == pdTRUE);
 }
 
 /*--------------------------------------------------------------------------*/
@@ -1,5 +1,169 @@
 #include "../../Inc/LoRa/LoRa.h"
 
+#include "FreeRTOS.h"
+#include "task.h"
+
+// SPI transactions come from the tasks and from the DIO ISRs, keep each one whole
+#define LORA_SPI_LOCK()         uint32_t lock = LoRa_spiLock()
+#define LORA_SPI_UNLOCK()       LoRa_spiUnlock(lock)
+
+#define LORA_LOCK_IRQ_MAX       4
+
+static IRQn_Type LoRa_lockIrq[LORA_LOCK_IRQ_MAX];
+static uint8_t   LoRa_lockIrqCount;
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_spiLockIrq
+
+        description : register an interrupt whose handler talks to a radio (its DIO
+                                    EXTI lines). The SPI lock holds exactly these off, SysTick
+                                    and the HAL tick keep running through a transaction.
+
+        arguments   :
+            IRQn_Type irq --> NVIC line, registering it twice does no harm
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_spiLockIrq(IRQn_Type irq){
+    for(uint8_t i=0; i<LoRa_lockIrqCount; i++)
+        if(LoRa_lockIrq[i] == irq)
+            return;
+
+    configASSERT(LoRa_lockIrqCount < LORA_LOCK_IRQ_MAX);
+    LoRa_lockIrq[LoRa_lockIrqCount++] = irq;
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_spiLock
+
+        description : start of a transaction: hold off the radio interrupts and, in a
+                                    task, the scheduler so the AO of another radio on the same
+                                    bus cannot cut in. Ticks that come meanwhile are counted
+                                    once the scheduler resumes.
+
+        returns     : what LoRa_spiUnlock needs to undo it
+\* ----------------------------------------------------------------------------- */
+static uint32_t LoRa_spiLock(void){
+    uint32_t lock = 0;
+
+    if(__get_IPSR() == 0 && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING){
+        vTaskSuspendAll();
+        lock = 1UL << LORA_LOCK_IRQ_MAX;
+    }
+    for(uint8_t i=0; i<LoRa_lockIrqCount; i++){
+        if(NVIC_GetEnableIRQ(LoRa_lockIrq[i])){
+            NVIC_DisableIRQ(LoRa_lockIrq[i]);
+            lock |= 1UL << i;
+        }
+    }
+    return lock;
+}
+
+static void LoRa_spiUnlock(uint32_t lock){
+    for(uint8_t i=0; i<LoRa_lockIrqCount; i++)
+        if(lock & (1UL << i))
+            NVIC_EnableIRQ(LoRa_lockIrq[i]);
+
+    if(lock & (1UL << LORA_LOCK_IRQ_MAX))
+        (void)xTaskResumeAll();
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_delay
+
+        description : blocking delay for the blocking API (LoRa_reset, LoRa_transmit):
+                                    yields to other tasks once the scheduler runs, HAL tick
+                                    before that. The RA02 AO never blocks, it runs
+                                    LoRa_resetAssert / LoRa_resetRelease / LoRa_init off
+                                    TimeEvents.
+
+        arguments   :
+            uint32_t ms --> milliseconds
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+static void LoRa_delay(uint32_t ms){
+    if(xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+        vTaskDelay(pdMS_TO_TICKS(ms) > 0 ? pdMS_TO_TICKS(ms) : 1);
+    else
+        HAL_Delay(ms);
+}
+
+#if LORA_SPI_STATS
+static LoRa_spiStats LoRa_spiStat;
+#endif
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_spiTransfer
+
+        description : the only place the driver touches the SPI bus and NSS, one whole
+                                    transaction: address bytes out, then data in or out.
+                                    LoRa_readReg, LoRa_writeReg and the bursts all end up here.
+
+        arguments   :
+            LoRa* LoRa        --> LoRa object handler
+            uint8_t* address  --> address bytes, R/W bit already set
+            uint16_t a_length --> number of address bytes
+            uint8_t* data     --> data to send, or where to store the data read
+            uint16_t d_length --> number of data bytes
+            uint8_t read      --> 1 to clock data in, 0 to send it
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+static void LoRa_spiTransfer(LoRa* _LoRa, uint8_t* address, uint16_t a_length,
+                             uint8_t* data, uint16_t d_length, uint8_t read){
+    LORA_SPI_LOCK();
+    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_RESET);
+    HAL_SPI_Transmit(_LoRa->hSPIx, address, a_length, TRANSMIT_TIMEOUT);
+    while (HAL_SPI_GetState(_LoRa->hSPIx) != HAL_SPI_STATE_READY)
+        ;
+    if(read)
+        HAL_SPI_Receive(_LoRa->hSPIx, data, d_length, RECEIVE_TIMEOUT);
+    else
+        HAL_SPI_Transmit(_LoRa->hSPIx, data, d_length, TRANSMIT_TIMEOUT);
+    while (HAL_SPI_GetState(_LoRa->hSPIx) != HAL_SPI_STATE_READY)
+        ;
+    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_SET);
+#if LORA_SPI_STATS
+    LoRa_spiStat.transactions++;
+    LoRa_spiStat.bytes += (uint32_t)a_length + d_length;
+#endif
+    LORA_SPI_UNLOCK();
+}
+
+#if LORA_SPI_STATS
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_getSpiStats
+
+        description : copy the SPI counters, consistent even against the DIO0 ISR
+
+        arguments   :
+            LoRa_spiStats* stats --> where to store them
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_getSpiStats(LoRa_spiStats* stats){
+    LORA_SPI_LOCK();
+    *stats = LoRa_spiStat;
+    LORA_SPI_UNLOCK();
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_resetSpiStats
+
+        description : zero the SPI counters, e.g. before the code under measurement
+
+        arguments   : Nothing
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_resetSpiStats(void){
+    LORA_SPI_LOCK();
+    LoRa_spiStat.transactions = 0;
+    LoRa_spiStat.bytes = 0;
+    LORA_SPI_UNLOCK();
+}
+#endif
 
 /* ----------------------------------------------------------------------------- *\
         name        : newLoRa
@@ -20,20 +184,26 @@
 LoRa newLoRa(){
     LoRa new_LoRa;
 
-    new_LoRa.frequency             = 433       ;
+    new_LoRa.frequency             = 433000000 ;
+    new_LoRa.channel               = LORA_CH_COUNT; // off-plan until LoRa_setChannel
     new_LoRa.spredingFactor        = SF_7      ;
     new_LoRa.bandWidth             = BW_125KHz ;
     new_LoRa.crcRate               = CR_4_5    ;
     new_LoRa.power                 = POWER_20db;
     new_LoRa.overCurrentProtection = 100       ;
     new_LoRa.preamble              = 8         ;
+    new_LoRa.headerMode            = EXPLICIT_HEADER;
+    new_LoRa.payloadLength         = 0         ;
+    new_LoRa.frfOffset             = 0         ;
+    new_LoRa.current_mode          = STNBY_MODE; // where a reset leaves the chip
+    new_LoRa.rxRing                = NULL      ;
 
     return new_LoRa;
 }
 /* ----------------------------------------------------------------------------- *\
         name        : LoRa_reset
 
-        description : reset module
+        description : reset module, blocks for LORA_RESET_PULSE_MS + LORA_RESET_READY_MS
 
         arguments   :
             LoRa* LoRa --> LoRa object handler
@@ -41,16 +211,48 @@ LoRa newLoRa(){
         returns     : Nothing
 \* ----------------------------------------------------------------------------- */
 void LoRa_reset(LoRa* _LoRa){
+    LoRa_resetAssert(_LoRa);
+    LoRa_delay(LORA_RESET_PULSE_MS);
+    LoRa_resetRelease(_LoRa);
+    LoRa_delay(LORA_RESET_READY_MS);
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_resetAssert
+
+        description : first step of a reset: pull NRESET low, release it with
+                                    LoRa_resetRelease no sooner than LORA_RESET_PULSE_MS later
+
+        arguments   :
+            LoRa* LoRa --> LoRa object handler
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_resetAssert(LoRa* _LoRa){
     HAL_GPIO_WritePin(_LoRa->reset_port, _LoRa->reset_pin, GPIO_PIN_RESET);
-    short_delay_ms(1);
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_resetRelease
+
+        description : second step of a reset: release NRESET, the chip takes SPI
+                                    commands LORA_RESET_READY_MS later
+
+        arguments   :
+            LoRa* LoRa --> LoRa object handler
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_resetRelease(LoRa* _LoRa){
     HAL_GPIO_WritePin(_LoRa->reset_port, _LoRa->reset_pin, GPIO_PIN_SET);
-    short_delay_ms(100);
 }
 
 /* ----------------------------------------------------------------------------- *\
         name        : LoRa_gotoMode
 
-        description : set LoRa Op mode
+        description : set LoRa Op mode. Leaving RXCONTINUOUS goes through standby first
+                                    and fetches the payloads still in the FiFo into rxRing,
+                                    the next RX, TX or sleep would overwrite or clear them.
 
         arguments   :
             LoRa* LoRa    --> LoRa object handler
@@ -65,6 +267,14 @@ void LoRa_gotoMode(LoRa* _LoRa, int mode){
     read = LoRa_read(_LoRa, RegOpMode);
     data = read;
 
+    if(_LoRa->current_mode == RXCONTIN_MODE && mode != RXCONTIN_MODE && _LoRa->rxRing != NULL){
+        read = (read & 0xF8) | 0x01;
+        _LoRa->current_mode = STNBY_MODE;
+        LoRa_write(_LoRa, RegOpMode, read);
+        LoRa_rxRingFetch(_LoRa, _LoRa->rxRing);
+        data = read;
+    }
+
     if(mode == SLEEP_MODE){
         data = (read & 0xF8) | 0x00;
         _LoRa->current_mode = SLEEP_MODE;
@@ -80,10 +290,12 @@ void LoRa_gotoMode(LoRa* _LoRa, int mode){
     }else if (mode == RXSINGLE_MODE){
         data = (read & 0xF8) | 0x06;
         _LoRa->current_mode = RXSINGLE_MODE;
+    }else if (mode == CAD_MODE){
+        data = (read & 0xF8) | 0x07;
+        _LoRa->current_mode = CAD_MODE;
     }
 
     LoRa_write(_LoRa, RegOpMode, data);
-    //HAL_Delay(10);
 }
 
 
@@ -103,14 +315,7 @@ void LoRa_gotoMode(LoRa* _LoRa, int mode){
         returns     : Nothing
 \* ----------------------------------------------------------------------------- */
 void LoRa_readReg(LoRa* _LoRa, uint8_t* address, uint16_t r_length, uint8_t* output, uint16_t w_length){
-    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(_LoRa->hSPIx, address, r_length, TRANSMIT_TIMEOUT);
-    while (HAL_SPI_GetState(_LoRa->hSPIx) != HAL_SPI_STATE_READY)
-        ;
-    HAL_SPI_Receive(_LoRa->hSPIx, output, w_length, RECEIVE_TIMEOUT);
-    while (HAL_SPI_GetState(_LoRa->hSPIx) != HAL_SPI_STATE_READY)
-        ;
-    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_SET);
+    LoRa_spiTransfer(_LoRa, address, r_length, output, w_length, 1);
 }
 
 /* ----------------------------------------------------------------------------- *\
@@ -129,14 +334,87 @@ void LoRa_readReg(LoRa* _LoRa, uint8_t* address, uint16_t r_length, uint8_t* out
         returns     : Nothing
 \* ----------------------------------------------------------------------------- */
 void LoRa_writeReg(LoRa* _LoRa, uint8_t* address, uint16_t r_length, uint8_t* values, uint16_t w_length){
-    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(_LoRa->hSPIx, address, r_length, TRANSMIT_TIMEOUT);
-    while (HAL_SPI_GetState(_LoRa->hSPIx) != HAL_SPI_STATE_READY)
-        ;
-    HAL_SPI_Transmit(_LoRa->hSPIx, values, w_length, TRANSMIT_TIMEOUT);
-    while (HAL_SPI_GetState(_LoRa->hSPIx) != HAL_SPI_STATE_READY)
-        ;
-    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_SET);
+    LoRa_spiTransfer(_LoRa, address, r_length, values, w_length, 0);
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_bwDiv
+
+        description : every LoRa bandwidth is 500 kHz / LoRa_bwDiv[BW], which keeps the
+                                    symbol time an exact integer number of microseconds:
+                                    Tsym = 2^SF / BW = 2^SF * 2 * LoRa_bwDiv[BW] us
+\* ----------------------------------------------------------------------------- */
+static const uint8_t LoRa_bwDiv[] = {64, 48, 32, 24, 16, 12, 8, 4, 2, 1};
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_symbolTime
+
+        description : duration of one LoRa symbol
+
+        arguments   :
+            uint8_t SF          --> spreading factor, 6 to 12
+            uint8_t BW          --> bandwidth e.g BW_125KHz
+
+        returns     : symbol time in microseconds
+\* ----------------------------------------------------------------------------- */
+uint32_t LoRa_symbolTime(uint8_t SF, uint8_t BW){
+    return (1UL << SF) * 2UL * LoRa_bwDiv[BW];
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_timeOnAir
+
+        description : time on air of one packet, Semtech SX1276/77/78/79 datasheet 4.1.1.7:
+                                    Tpacket  = (Npreamble + 4.25) * Tsym + Npayload * Tsym
+                                    Npayload = 8 + max(ceil((8PL - 4SF + 28 + 16CRC - 20IH)
+                                                      / (4(SF - 2DE))) * (CR + 4), 0)
+
+        arguments   :
+            uint8_t  SF             --> spreading factor, 6 to 12
+            uint8_t  BW             --> bandwidth e.g BW_125KHz
+            uint8_t  CR             --> coding rate e.g CR_4_5
+            uint16_t preamble       --> programmed preamble length in symbols
+            uint8_t  length         --> payload length in bytes
+            uint8_t  implicitHeader --> 1 for implicit header mode, 0 for explicit
+            uint8_t  crcOn          --> 1 if the payload CRC is enabled
+            uint8_t  LDRO           --> 1 if low data rate optimization is enabled
+
+        returns     : time on air in microseconds
+\* ----------------------------------------------------------------------------- */
+uint32_t LoRa_timeOnAir(uint8_t SF, uint8_t BW, uint8_t CR, uint16_t preamble, uint8_t length,
+                        uint8_t implicitHeader, uint8_t crcOn, uint8_t LDRO){
+    int32_t  num;
+    int32_t  den;
+    uint32_t symbols;
+
+    num = 8 * (int32_t)length - 4 * (int32_t)SF + 28 + (crcOn ? 16 : 0) - (implicitHeader ? 20 : 0);
+    den = 4 * ((int32_t)SF - (LDRO ? 2 : 0));
+
+    symbols = 8;
+    if(num > 0)
+        symbols += (uint32_t)((num + den - 1) / den) * (CR + 4U);
+
+    // (Npreamble + 4.25 + Npayload) * Tsym, in quarter symbols to stay integer
+    return (uint32_t)(((uint64_t)(4UL * (preamble + symbols) + 17UL) * LoRa_symbolTime(SF, BW)) / 4UL);
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_packetTimeOnAir
+
+        description : time on air of a packet with the current LoRa object settings
+                                    (CRC on, automatic LDO)
+
+        arguments   :
+            LoRa*   LoRa        --> LoRa object handler
+            uint8_t length      --> payload length in bytes
+
+        returns     : time on air in microseconds
+\* ----------------------------------------------------------------------------- */
+uint32_t LoRa_packetTimeOnAir(LoRa* _LoRa, uint8_t length){
+    uint8_t LDRO = LoRa_symbolTime(_LoRa->spredingFactor, _LoRa->bandWidth) > 16000UL;
+
+    return LoRa_timeOnAir(_LoRa->spredingFactor, _LoRa->bandWidth, _LoRa->crcRate,
+                          _LoRa->preamble, length, _LoRa->headerMode == IMPLICIT_HEADER, 1, LDRO);
 }
 
 /* ----------------------------------------------------------------------------- *\
@@ -176,67 +454,152 @@ void LoRa_setLowDaraRateOptimization(LoRa* _LoRa, uint8_t value){
         returns     : Nothing
 \* ----------------------------------------------------------------------------- */
 void LoRa_setAutoLDO(LoRa* _LoRa){
-    double BW[] = {7.8, 10.4, 15.6, 20.8, 31.25, 41.7, 62.5, 125.0, 250.0, 500.0};
+    LoRa_setLowDaraRateOptimization(_LoRa, LoRa_symbolTime(_LoRa->spredingFactor, _LoRa->bandWidth) > 16000UL);
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_channelFrf
+
+        description : Frf register values of the channel plan, computed at compile time
+                                    so a channel switch costs nothing but the SPI burst.
+\* ----------------------------------------------------------------------------- */
+static const uint32_t LoRa_channelFrf[LORA_CH_COUNT] = {
+    LORA_FRF(LORA_CH_HZ(0)), LORA_FRF(LORA_CH_HZ(1)),
+    LORA_FRF(LORA_CH_HZ(2)), LORA_FRF(LORA_CH_HZ(3)),
+    LORA_FRF(LORA_CH_HZ(4)), LORA_FRF(LORA_CH_HZ(5)),
+    LORA_FRF(LORA_CH_HZ(6)), LORA_FRF(LORA_CH_HZ(7)),
+};
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_writeFrf
+
+        description : write RegFrMsb, RegFrMid and RegFrLsb in a single burst. The chip
+                                    latches the new carrier when FrLsb is written, so the
+                                    three bytes always take effect together. The AFC
+                                    correction (frfOffset) is added here, for every channel.
+
+        arguments   :
+            LoRa*    LoRa     --> LoRa object handler
+            uint32_t frf      --> 24 bit Frf value (Fstep = 32 MHz / 2^19), uncorrected
 
-    LoRa_setLowDaraRateOptimization(_LoRa, (long)((1 << _LoRa->spredingFactor) / ((double)BW[_LoRa->bandWidth])) > 16.0);
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+static void LoRa_writeFrf(LoRa* _LoRa, uint32_t frf){
+    uint8_t data[3];
+
+    frf += (uint32_t)_LoRa->frfOffset;
+
+    data[0] = (uint8_t)(frf >> 16);
+    data[1] = (uint8_t)(frf >> 8);
+    data[2] = (uint8_t)(frf >> 0);
+    LoRa_BurstWrite(_LoRa, RegFrMsb, data, 3);
+    _LoRa->frf = frf;
 }
 
 /* ----------------------------------------------------------------------------- *\
         name        : LoRa_setFrequency
 
-        description : set carrier frequency e.g 433 MHz
+        description : set carrier frequency e.g 433175000 Hz
 
         arguments   :
-            LoRa* LoRa        --> LoRa object handler
-            int   freq        --> desired frequency in MHz unit, e.g 434
-
-        returns     : Nothing
-\* ----------------------------------------------------------------------------- */
-//void LoRa_setFrequency(LoRa* _LoRa, int freq){
-//    uint8_t  data;
-//    uint32_t F;
-//    F = (freq * 524288)>>5;
-//
-//    // write Msb:
-//    data = F >> 16;
-//    LoRa_write(_LoRa, RegFrMsb, data);
-//    HAL_Delay(5);
-//
-//    // write Mid:
-//    data = F >> 8;
-//    LoRa_write(_LoRa, RegFrMid, data);
-//    HAL_Delay(5);
-//
-//    // write Lsb:
-//    data = F >> 0;
-//    LoRa_write(_LoRa, RegFrLsb, data);
-//    HAL_Delay(5);
-//}
-
-void LoRa_setFrequency(LoRa* _LoRa, int freq){
-    uint8_t data;
-    uint32_t F = (freq * 524288) >> 5;
+            LoRa*    LoRa     --> LoRa object handler
+            uint32_t freq     --> desired frequency in Hz unit, e.g 434000000
 
-    // Write MSB
-    data = F >> 16;
-    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(_LoRa->hSPIx, &data, 1, 100);
-    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_SET);
-    for(volatile int i=0;i<8000;i++); // ~5 ms crude delay
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_setFrequency(LoRa* _LoRa, uint32_t freq){
+    _LoRa->frequency = freq;
+    LoRa_writeFrf(_LoRa, LORA_FRF(freq));
+}
 
-    // Write MID
-    data = F >> 8;
-    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(_LoRa->hSPIx, &data, 1, 100);
-    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_SET);
-    for(volatile int i=0;i<8000;i++);
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_setChannel
 
-    // Write LSB
-    data = F >> 0;
-    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_RESET);
-    HAL_SPI_Transmit(_LoRa->hSPIx, &data, 1, 100);
-    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_SET);
-    for(volatile int i=0;i<8000;i++);
+        description : retune to a channel of the precomputed channel plan
+                                    (LORA_CH_BASE_HZ + idx * LORA_CH_SPACING_HZ)
+
+        arguments   :
+            LoRa*   LoRa        --> LoRa object handler
+            uint8_t idx         --> channel index, 0 .. LORA_CH_COUNT-1
+
+        returns     : 1 in case of success, 0 if idx is out of the channel plan
+\* ----------------------------------------------------------------------------- */
+uint8_t LoRa_setChannel(LoRa* _LoRa, uint8_t idx){
+    if(idx >= LORA_CH_COUNT)
+        return 0;
+
+    _LoRa->channel   = idx;
+    _LoRa->frequency = LORA_CH_HZ(idx);
+    LoRa_writeFrf(_LoRa, LoRa_channelFrf[idx]);
+    return 1;
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_setFrequencyOffset
+
+        description : automatic frequency correction: move the synthesizer by 'hz' on
+                                    every channel, e.g. to follow the carrier of the other
+                                    nodes measured with FEI. Takes effect at once on the
+                                    current channel, with one Frf burst.
+
+        arguments   :
+            LoRa*   LoRa        --> LoRa object handler
+            int32_t hz          --> correction in Hz, Fstep (61 Hz) resolution
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_setFrequencyOffset(LoRa* _LoRa, int32_t hz){
+    uint32_t frf = _LoRa->frf - (uint32_t)_LoRa->frfOffset;
+    int32_t  steps = (int32_t)(((int64_t)hz * (1LL << 19)) / (int64_t)LORA_FXOSC_HZ);
+
+    if(steps == _LoRa->frfOffset)
+        return;
+
+    _LoRa->frfOffset = steps;
+    LoRa_writeFrf(_LoRa, frf);
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_setHopPeriod
+
+        description : intra-packet frequency hopping, the chip raises FhssChangeChannel
+                                    (DIO2) every 'symbols' symbols after the header and
+                                    LoRa_hopChannel has to retune it. Every node of the
+                                    network needs the same period.
+
+        arguments   :
+            LoRa*   LoRa        --> LoRa object handler
+            uint8_t symbols     --> hop period in symbols, 0 disables hopping
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_setHopPeriod(LoRa* _LoRa, uint8_t symbols){
+    LoRa_write(_LoRa, RegHopPeriod, symbols);
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_hopChannel
+
+        description : FhssChangeChannel (DIO2) ISR side: one burst to Frf with the next
+                                    channel of the hop sequence, then clear the IRQ.
+                                    FhssPresentChannel counts the hops of the current
+                                    packet, the packet started on sequence[first].
+                                    _LoRa->channel is left alone, it stays the channel
+                                    to come back to once the packet is over.
+
+        arguments   :
+            LoRa*          LoRa     --> LoRa object handler
+            uint8_t const* sequence --> hop sequence, channel plan indexes
+            uint8_t        length   --> number of entries in sequence
+            uint8_t        first    --> position of the packet's first channel
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_hopChannel(LoRa* _LoRa, uint8_t const* sequence, uint8_t length, uint8_t first){
+    uint8_t hops = LoRa_read(_LoRa, RegHopChannel) & 0x3F;
+
+    LoRa_writeFrf(_LoRa, LoRa_channelFrf[sequence[(first + hops + 1) % length]]);
+    LoRa_clearIrqFlags(_LoRa, IRQ_FHSS_CHANGE_CHANNEL);
 }
 
 
@@ -347,7 +710,6 @@ void LoRa_setTOMsb_setCRCon(LoRa* _LoRa){
 \* ----------------------------------------------------------------------------- */
 void LoRa_setSyncWord(LoRa* _LoRa, uint8_t syncword){
     LoRa_write(_LoRa, RegSyncWord, syncword);
-    HAL_Delay(10);
 }
 
 /* ----------------------------------------------------------------------------- *\
@@ -410,20 +772,28 @@ void LoRa_BurstWrite(LoRa* _LoRa, uint8_t address, uint8_t *value, uint8_t lengt
     uint8_t addr;
     addr = address | 0x80;
 
-    //NSS = 1
-    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_RESET);
+    LoRa_writeReg(_LoRa, &addr, 1, value, length);
+}
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_BurstRead
 
-    HAL_SPI_Transmit(_LoRa->hSPIx, &addr, 1, TRANSMIT_TIMEOUT);
-    while (HAL_SPI_GetState(_LoRa->hSPIx) != HAL_SPI_STATE_READY)
-        ;
-    //Write data in FiFo
-    HAL_SPI_Transmit(_LoRa->hSPIx, value, length, TRANSMIT_TIMEOUT);
-    while (HAL_SPI_GetState(_LoRa->hSPIx) != HAL_SPI_STATE_READY)
-        ;
-    //NSS = 0
-    //HAL_Delay(5);
-    HAL_GPIO_WritePin(_LoRa->CS_port, _LoRa->CS_pin, GPIO_PIN_SET);
+        description : read a set of consecutive registers, or the FiFo, in one transaction
+
+        arguments   :
+            LoRa*   LoRa        --> LoRa object handler
+            uint8_t address     --> address of the first register e.g 0x19
+            uint8_t *value      --> where to store the values
+            uint8_t length      --> number of registers to read
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_BurstRead(LoRa* _LoRa, uint8_t address, uint8_t *value, uint8_t length){
+    uint8_t addr;
+
+    addr = address & 0x7F;
+    LoRa_readReg(_LoRa, &addr, 1, value, length);
 }
+
 /* ----------------------------------------------------------------------------- *\
         name        : LoRa_isvalid
 
@@ -439,6 +809,48 @@ uint8_t LoRa_isvalid(LoRa* _LoRa){
     return 1;
 }
 
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_applyConfig
+
+        description : write the modem settings of the LoRa object. RegModemConfig1 up to
+                                    RegPayloadLength are consecutive, so bandwidth, coding rate,
+                                    header mode, spreading factor, CRC, symbol timeout, preamble
+                                    and payload length go out in one burst; LDO follows in
+                                    RegModemConfig3, read-modify-write. The module should be
+                                    in sleep or standby.
+
+        arguments   :
+            LoRa* LoRa        --> LoRa object handler
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_applyConfig(LoRa* _LoRa){
+    uint8_t data[6];
+    uint8_t SF = _LoRa->spredingFactor;
+
+    if(SF>12)
+        SF = 12;
+    if(SF<7)
+        SF = 7;
+
+    // 8 bit RegModemConfig1 --> | X | X | X | X | X | X | X | X |
+    //        bits represent --> |   bandwidth   |     CR    |I/E|
+    data[0] = (_LoRa->bandWidth << 4) + (_LoRa->crcRate << 1) + (_LoRa->headerMode == IMPLICIT_HEADER);
+    // RegModemConfig2: spreading factor, CRC on, timeout Msb
+    data[1] = (SF << 4) | 0x07;
+    // RegSymbTimeoutL
+    data[2] = 0xFF;
+    // RegPreambleMsb, RegPreambleLsb
+    data[3] = _LoRa->preamble >> 8;
+    data[4] = _LoRa->preamble >> 0;
+    // RegPayloadLength, only used by the receiver in implicit header mode
+    data[5] = _LoRa->headerMode == IMPLICIT_HEADER ? _LoRa->payloadLength : 0x01;
+    LoRa_BurstWrite(_LoRa, RegModemConfig1, data, 6);
+
+    // RegModemConfig3: only LowDataRateOptimize, AgcAutoOn stays as it is
+    LoRa_setLowDaraRateOptimization(_LoRa, LoRa_symbolTime(SF, _LoRa->bandWidth) > 16000UL);
+}
+
 /* ----------------------------------------------------------------------------- *\
         name        : LoRa_transmit
 
@@ -474,14 +886,43 @@ uint8_t LoRa_transmit(LoRa* _LoRa, uint8_t* data, uint8_t length, uint16_t timeo
                 return 0;
             }
         }
-        HAL_Delay(1);
+        LoRa_delay(1);
     }
 }
 
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_startTransmit
+
+        description : Start a transmission and return at once. DIO0 is mapped to TxDone,
+                                    the module goes back to standby by itself when the
+                                    packet is out; the caller clears IRQ_TX_DONE.
+
+        arguments   :
+            LoRa*    LoRa     --> LoRa object handler
+            uint8_t  data           --> A pointer to the data you wanna send
+            uint8_t  length   --> Size of your data in Bytes
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_startTransmit(LoRa* _LoRa, uint8_t* data, uint8_t length){
+    uint8_t read;
+
+    LoRa_gotoMode(_LoRa, STNBY_MODE);
+    read = LoRa_read(_LoRa, RegFiFoTxBaseAddr);
+    LoRa_write(_LoRa, RegFiFoAddPtr, read);
+    LoRa_write(_LoRa, RegPayloadLength, length);
+    LoRa_BurstWrite(_LoRa, RegFiFo, data, length);
+    LoRa_write(_LoRa, RegDioMapping1, DIO0_TX_DONE | DIO2_FHSS_CHANGE_CHANNEL);
+    LoRa_gotoMode(_LoRa, TRANSMIT_MODE);
+}
+
 /* ----------------------------------------------------------------------------- *\
         name        : LoRa_startReceiving
 
-        description : Start receiving continuously
+        description : Start receiving continuously. Every IRQ flag is cleared before DIO0
+                                    is mapped back to RxDone: an RxDone latched while the
+                                    module was out of RX would hold DIO0 high, and the rising
+                                    edge the DIO0 ISR waits for would never come again.
 
         arguments   :
             LoRa*    LoRa     --> LoRa object handler
@@ -489,13 +930,164 @@ uint8_t LoRa_transmit(LoRa* _LoRa, uint8_t* data, uint8_t length, uint16_t timeo
         returns     : Nothing
 \* ----------------------------------------------------------------------------- */
 void LoRa_startReceiving(LoRa* _LoRa){
+    LoRa_write(_LoRa, RegIrqFlags, IRQ_ALL);
+    LoRa_write(_LoRa, RegDioMapping1, DIO0_RX_DONE | DIO2_FHSS_CHANGE_CHANNEL);
     LoRa_gotoMode(_LoRa, RXCONTIN_MODE);
 }
 
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_startCAD
+
+        description : Start a Channel Activity Detection. DIO0 is mapped to CadDone and
+                                    DIO1 to CadDetected; the chip falls back to standby by
+                                    itself once the CAD is over. Read the result with
+                                    LoRa_getIrqFlags (IRQ_CAD_DETECTED) after DIO0 fires.
+
+        arguments   :
+            LoRa*    LoRa     --> LoRa object handler
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_startCAD(LoRa* _LoRa){
+    LoRa_gotoMode(_LoRa, STNBY_MODE);
+    LoRa_write(_LoRa, RegIrqFlags, IRQ_CAD_DONE | IRQ_CAD_DETECTED);
+    LoRa_write(_LoRa, RegDioMapping1, DIO0_CAD_DONE | DIO1_CAD_DETECTED);
+    LoRa_gotoMode(_LoRa, CAD_MODE);
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_getIrqFlags
+
+        description : read RegIrqFlags
+
+        arguments   :
+            LoRa*    LoRa     --> LoRa object handler
+
+        returns     : IRQ flags, test them against the IRQ_xxx masks
+\* ----------------------------------------------------------------------------- */
+uint8_t LoRa_getIrqFlags(LoRa* _LoRa){
+    return LoRa_read(_LoRa, RegIrqFlags);
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_clearIrqFlags
+
+        description : clear IRQ flags, flags are cleared by writing 1 to them
+
+        arguments   :
+            LoRa*    LoRa     --> LoRa object handler
+            uint8_t  mask     --> flags to clear e.g IRQ_CAD_DONE | IRQ_CAD_DETECTED
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_clearIrqFlags(LoRa* _LoRa, uint8_t mask){
+    LoRa_write(_LoRa, RegIrqFlags, mask);
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_random
+
+        description : gather 32 random bits from the LSB of the wideband RSSI. The module
+                                    has to be in receive mode for the RSSI to be live.
+
+        arguments   :
+            LoRa*    LoRa     --> LoRa object handler
+
+        returns     : 32 bit random value, good enough to seed a PRNG
+\* ----------------------------------------------------------------------------- */
+uint32_t LoRa_random(LoRa* _LoRa){
+    uint32_t value = 0;
+
+    for(int i=0; i<32; i++)
+        value = (value << 1) | (LoRa_read(_LoRa, RegRssiWideband) & 0x01);
+
+    return value;
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_decodeStatus
+
+        description : packet status out of the raw registers: RegPktSnrValue, RegPktRssiValue
+                                    and RegFeiMsb..Lsb (FreqError, 20 bit two's complement,
+                                    Ferr = FreqError * 2^24 / Fxosc * BW / 500 kHz)
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+static void LoRa_decodeStatus(LoRa* _LoRa, uint8_t snrReg, uint8_t rssiReg, uint8_t const* fei,
+                              LoRa_pktStatus* status){
+    int8_t  snr4 = (int8_t)snrReg;          // two's complement, 0.25 dB steps
+    int32_t freqError;
+
+    status->snr  = snr4 / 4;
+    status->rssi = -164 + rssiReg;
+    if(snr4 < 0)
+        status->rssi += snr4 / 4;           // below the noise floor (LF port)
+
+    freqError = (int32_t)((((uint32_t)fei[0] & 0x0F) << 28) | ((uint32_t)fei[1] << 20) | ((uint32_t)fei[2] << 12)) >> 12;
+    status->fei = (int32_t)(((int64_t)freqError * (1LL << 24)) /
+                            ((int64_t)LORA_FXOSC_HZ * LoRa_bwDiv[_LoRa->bandWidth]));
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_takePacket
+
+        description : take the RxDone of the last received packet without leaving
+                                    RXCONTINUOUS and find it in the FiFo. In continuous mode
+                                    the modem appends every packet after the previous one and
+                                    wraps at the end of the 256 byte FiFo, so the FiFo is a
+                                    ring and each packet stays at its own RegFiFoRxCurrentAddr
+                                    while the next one may already be coming in behind it.
+                                    RegFiFoRxCurrentAddr..RegPktRssiValue come in one burst
+                                    with the IRQ flags, FEI in a second one: a single burst up
+                                    to RegFeiLsb would clock 27 bytes to use 8.
+
+        arguments   :
+            LoRa*    LoRa     --> LoRa object handler
+            uint8_t* fifoAddr --> where the packet starts in the FiFo
+            LoRa_pktStatus* status --> filled with the packet status, may be NULL
+
+        returns     : The number of bytes received, 0 if no valid packet was pending
+\* ----------------------------------------------------------------------------- */
+static uint8_t LoRa_takePacket(LoRa* _LoRa, uint8_t* fifoAddr, LoRa_pktStatus* status){
+    uint8_t regs[RegPktRssiValue - RegFiFoRxCurrentAddr + 1];
+    uint8_t fei[3];
+
+    LoRa_BurstRead(_LoRa, RegFiFoRxCurrentAddr, regs, sizeof(regs));
+    if((regs[RegIrqFlags - RegFiFoRxCurrentAddr] & IRQ_RX_DONE) == 0)
+        return 0;
+
+    LoRa_write(_LoRa, RegIrqFlags, IRQ_RX_DONE | IRQ_PAYLOAD_CRC_ERROR | IRQ_VALID_HEADER);
+    if((regs[RegIrqFlags - RegFiFoRxCurrentAddr] & IRQ_PAYLOAD_CRC_ERROR) != 0)
+        return 0;
+
+    if(status != NULL){
+        LoRa_BurstRead(_LoRa, RegFeiMsb, fei, 3);
+        LoRa_decodeStatus(_LoRa, regs[RegPktSnrValue - RegFiFoRxCurrentAddr],
+                          regs[RegPktRssiValue - RegFiFoRxCurrentAddr], fei, status);
+        status->length = regs[RegRxNbBytes - RegFiFoRxCurrentAddr];
+    }
+
+    *fifoAddr = regs[0];
+    return regs[RegRxNbBytes - RegFiFoRxCurrentAddr];
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_readFifo
+
+        description : copy 'length' bytes out of the FiFo from 'addr' on, the modem
+                                    keeps receiving meanwhile
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+static void LoRa_readFifo(LoRa* _LoRa, uint8_t addr, uint8_t* data, uint8_t length){
+    LoRa_write(_LoRa, RegFiFoAddPtr, addr);
+    LoRa_BurstRead(_LoRa, RegFiFo, data, length);
+}
+
 /* ----------------------------------------------------------------------------- *\
         name        : LoRa_Receive
 
-        description : Read received data from module
+        description : Read received data from module, the module stays in RXCONTINUOUS
 
         arguments   :
             LoRa*    LoRa     --> LoRa object handler
@@ -505,26 +1097,129 @@ void LoRa_startReceiving(LoRa* _LoRa){
         returns     : The number of bytes received
 \* ----------------------------------------------------------------------------- */
 uint8_t LoRa_receive(LoRa* _LoRa, uint8_t* data, uint8_t length){
-    uint8_t read;
-    uint8_t number_of_bytes;
-    uint8_t min = 0;
+    uint8_t addr;
+    uint8_t received;
 
     for(int i=0; i<length; i++)
         data[i]=0;
 
-    LoRa_gotoMode(_LoRa, STNBY_MODE);
-    read = LoRa_read(_LoRa, RegIrqFlags);
-    if((read & 0x40) != 0){
-        LoRa_write(_LoRa, RegIrqFlags, 0xFF);
-        number_of_bytes = LoRa_read(_LoRa, RegRxNbBytes);
-        read = LoRa_read(_LoRa, RegFiFoRxCurrentAddr);
-        LoRa_write(_LoRa, RegFiFoAddPtr, read);
-        min = length >= number_of_bytes ? number_of_bytes : length;
-        for(int i=0; i<min; i++)
-            data[i] = LoRa_read(_LoRa, RegFiFo);
+    received = LoRa_takePacket(_LoRa, &addr, NULL);
+    if(received > length)
+        received = length;
+    if(received > 0)
+        LoRa_readFifo(_LoRa, addr, data, received);
+    return received;
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_receiveToRing
+
+        description : DIO0 (RxDone) ISR side of the receive path: take the packet's
+                                    status and FiFo position into the next free slot of the
+                                    ring. The payload stays in the FiFo for LoRa_rxRingFetch,
+                                    so the ISR clocks 18 bytes whatever the packet length.
+                                    Leaves the FiFo alone unless the module is in RXCONTINUOUS,
+                                    so a task that left RX mode owns the FiFo pointer alone.
+                                    When the ring is full, or RxDone came outside RXCONTINUOUS,
+                                    the packet is dropped, but its IRQ is still cleared so DIO0
+                                    falls and reception goes on.
+
+        arguments   :
+            LoRa*        LoRa     --> LoRa object handler
+            LoRa_rxRing* ring     --> ring the frame is pushed into
+            uint32_t timestamp --> time of the DIO0 edge, stored with the frame
+
+        returns     : 1 if a frame was pushed, 0 otherwise
+\* ----------------------------------------------------------------------------- */
+uint8_t LoRa_receiveToRing(LoRa* _LoRa, LoRa_rxRing* ring, uint32_t timestamp){
+    uint8_t      head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint8_t      tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    LoRa_rxSlot* slot;
+    uint8_t      received;
+
+    if(_LoRa->current_mode != RXCONTIN_MODE){
+        LoRa_clearIrqFlags(_LoRa, IRQ_RX_DONE | IRQ_PAYLOAD_CRC_ERROR | IRQ_VALID_HEADER);
+        return 0;
     }
-    LoRa_gotoMode(_LoRa, RXCONTIN_MODE);
-    return min;
+
+    if((uint8_t)(head - tail) >= LORA_RX_RING_LEN){
+        LoRa_clearIrqFlags(_LoRa, IRQ_RX_DONE | IRQ_PAYLOAD_CRC_ERROR | IRQ_VALID_HEADER);
+        ring->dropped++;
+        return 0;
+    }
+
+    slot = &ring->slot[head & (LORA_RX_RING_LEN - 1)];
+    received = LoRa_takePacket(_LoRa, &slot->fifoAddr, &slot->status);
+    if(received == 0)
+        return 0;
+
+    slot->length = received < LORA_RX_SLOT_SIZE ? received : LORA_RX_SLOT_SIZE;
+    slot->timestamp = timestamp;
+    atomic_store_explicit(&ring->head, (uint8_t)(head + 1), memory_order_release);
+    return 1;
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_rxRingFetch
+
+        description : task side: copy the payloads of the frames the ISR took out of the
+                                    FiFo. LoRa_gotoMode calls it when RX is left, before
+                                    anything writes the FiFo (TX) or clears it (sleep).
+                                    A frame the ring had no room for still lands in the FiFo
+                                    and can overwrite one not fetched yet, the frame CRC
+                                    catches that.
+
+        arguments   :
+            LoRa*        LoRa     --> LoRa object handler
+            LoRa_rxRing* ring     --> ring filled by LoRa_receiveToRing
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_rxRingFetch(LoRa* _LoRa, LoRa_rxRing* ring){
+    uint8_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    while(ring->fetched != head){
+        LoRa_rxSlot* slot = &ring->slot[ring->fetched & (LORA_RX_RING_LEN - 1)];
+
+        LoRa_readFifo(_LoRa, slot->fifoAddr, slot->data, slot->length);
+        ring->fetched++;
+    }
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_rxRingFront
+
+        description : oldest frame of the ring, consumer side, once LoRa_rxRingFetch
+                                    copied it
+
+        arguments   :
+            LoRa_rxRing* ring     --> ring filled by LoRa_receiveToRing
+
+        returns     : the frame, or NULL if the ring is empty
+\* ----------------------------------------------------------------------------- */
+LoRa_rxSlot* LoRa_rxRingFront(LoRa_rxRing* ring){
+    uint8_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if(ring->fetched == tail)
+        return NULL;
+
+    return &ring->slot[tail & (LORA_RX_RING_LEN - 1)];
+}
+
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_rxRingPop
+
+        description : release the frame returned by LoRa_rxRingFront
+
+        arguments   :
+            LoRa_rxRing* ring     --> ring filled by LoRa_receiveToRing
+
+        returns     : Nothing
+\* ----------------------------------------------------------------------------- */
+void LoRa_rxRingPop(LoRa_rxRing* ring){
+    uint8_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&ring->tail, (uint8_t)(tail + 1), memory_order_release);
 }
 
 /* ----------------------------------------------------------------------------- *\
@@ -544,42 +1239,56 @@ int LoRa_getRSSI(LoRa* _LoRa){
 }
 
 /* ----------------------------------------------------------------------------- *\
-        name        : LoRa_init
+        name        : LoRa_getPacketStatus
 
-        description : initialize and set the right setting according to LoRa sruct vars
+        description : RSSI, SNR, length and frequency error of the last received packet,
+                                    for callers of LoRa_receive; the ring gets them with the
+                                    packet already.
 
         arguments   :
-            LoRa* LoRa        --> LoRa object handler
+            LoRa*           LoRa     --> LoRa object handler
+            LoRa_pktStatus* status   --> filled with the packet status
 
         returns     : Nothing
 \* ----------------------------------------------------------------------------- */
-void short_delay_ms(uint32_t ms) {
-    volatile uint32_t count;
-    while (ms--) {
-        count = 8000; // tweak for ~1 ms
-        while (count--);
-    }
+void LoRa_getPacketStatus(LoRa* _LoRa, LoRa_pktStatus* status){
+    uint8_t data[2];
+    uint8_t fei[3];
+
+    LoRa_BurstRead(_LoRa, RegPktSnrValue, data, 2);
+    LoRa_BurstRead(_LoRa, RegFeiMsb, fei, 3);
+    LoRa_decodeStatus(_LoRa, data[0], data[1], fei, status);
+    status->length = LoRa_read(_LoRa, RegRxNbBytes);
 }
 
+/* ----------------------------------------------------------------------------- *\
+        name        : LoRa_init
+
+        description : initialize and set the right setting according to LoRa sruct vars.
+                                    Needs a reset chip (LoRa_reset) and does not wait for
+                                    anything, the AO calls it once LORA_RESET_READY_MS passed.
+
+        arguments   :
+            LoRa* LoRa        --> LoRa object handler
+
+        returns     : LORA_OK, LORA_NOT_FOUND if the chip does not answer as an SX127x,
+                                    LORA_UNAVAILABLE if the handler is incomplete
+\* ----------------------------------------------------------------------------- */
 uint16_t LoRa_init(LoRa* _LoRa){
-    uint8_t    data;
     uint8_t    read;
 
     if(LoRa_isvalid(_LoRa)){
-        // goto sleep mode:
+        // wrong wiring or a chip still in reset reads 0x00 or 0xFF, skip the setup:
+            read = LoRa_read(_LoRa, RegVersion);
+            if(read != 0x12)
+                return LORA_NOT_FOUND;
+
+        // goto sleep mode, LongRangeMode can only be changed there:
             LoRa_gotoMode(_LoRa, SLEEP_MODE);
-            // HAL_Delay(10);
-        short_delay_ms(10);
 
         // turn on LoRa mode:
             read = LoRa_read(_LoRa, RegOpMode);
-            // HAL_Delay(10);
-        short_delay_ms(10);
-
-            data = read | 0x80;
-            LoRa_write(_LoRa, RegOpMode, data);
-            // HAL_Delay(100);
-        short_delay_ms(100);
+            LoRa_write(_LoRa, RegOpMode, read | 0x80);
 
         // set frequency:
             LoRa_setFrequency(_LoRa, _LoRa->frequency);
@@ -593,47 +1302,15 @@ uint16_t LoRa_init(LoRa* _LoRa){
         // set LNA gain:
             LoRa_write(_LoRa, RegLna, 0x23);
 
-        // set spreading factor, CRC on, and Timeout Msb:
-            LoRa_setTOMsb_setCRCon(_LoRa);
-            LoRa_setSpreadingFactor(_LoRa, _LoRa->spredingFactor);
-
-        // set Timeout Lsb:
-            LoRa_write(_LoRa, RegSymbTimeoutL, 0xFF);
-
-        // set bandwidth, coding rate and expilicit mode:
-            // 8 bit RegModemConfig --> | X | X | X | X | X | X | X | X |
-            //       bits represent --> |   bandwidth   |     CR    |I/E|
-            data = 0;
-            data = (_LoRa->bandWidth << 4) + (_LoRa->crcRate << 1);
-            LoRa_write(_LoRa, RegModemConfig1, data);
-            LoRa_setAutoLDO(_LoRa);
-
-        // set preamble:
-            LoRa_write(_LoRa, RegPreambleMsb, _LoRa->preamble >> 8);
-            LoRa_write(_LoRa, RegPreambleLsb, _LoRa->preamble >> 0);
-
-        // DIO mapping:   --> DIO: RxDone
-        //     read = LoRa_read(_LoRa, RegDioMapping1);  // DEFAULT RESET TO THIS IF I FUCKED UP
-        //     data = read | 0x3F;
-        //     LoRa_write(_LoRa, RegDioMapping1, data);
-        // // LoRa_write(_LoRa, RegDioMapping1, 0x00);
-
-
-        LoRa_write(_LoRa, RegDioMapping1, 0x00); // DIO0–DIO3 = RxDone
-
+        // set bandwidth, coding rate, header mode, spreading factor, CRC on,
+        // timeout, preamble, payload length and LDO:
+            LoRa_applyConfig(_LoRa);
 
+        LoRa_write(_LoRa, RegDioMapping1, 0x00); // DIO0 = RxDone, DIO2 = FhssChangeChannel
 
         // goto standby mode:
             LoRa_gotoMode(_LoRa, STNBY_MODE);
-            _LoRa->current_mode = STNBY_MODE;
-            // HAL_Delay(10);
-        short_delay_ms(10);
-
-            read = LoRa_read(_LoRa, RegVersion);
-            if(read == 0x12)
-                return LORA_OK;
-            else
-                return LORA_NOT_FOUND;
+            return LORA_OK;
     }
     else {
         return LORA_UNAVAILABLE;
@@ -11,30 +11,78 @@
 
 
 
+#ifndef LORA_RADIO2_SPI
+#define LORA_RADIO2_SPI hspi2 /* shares the bus, NSS2 selects it */
+#endif
+
+/* DIO2 only matters for intra-packet frequency hopping */
+#ifdef DID2_Pin
+#define LORA_RADIO1_DIO2 DID2_GPIO_Port, DID2_Pin
+#else
+#define LORA_RADIO1_DIO2 NULL, 0U
+#endif
+#ifdef DID2_2_Pin
+#define LORA_RADIO2_DIO2 DID2_2_GPIO_Port, DID2_2_Pin
+#else
+#define LORA_RADIO2_DIO2 NULL, 0U
+#endif
+
+const LoRa_hw LoRa_radios[LORA_RADIO_COUNT] = {
+    {NSS_GPIO_Port, NSS_Pin, RESET_GPIO_Port, RESET_Pin, DID0_GPIO_Port, DID0_Pin, LORA_RADIO1_DIO2, &hspi2},
+#if LORA_RADIO_COUNT > 1U
+    {NSS2_GPIO_Port, NSS2_Pin, RESET2_GPIO_Port, RESET2_Pin, DID0_2_GPIO_Port, DID0_2_Pin, LORA_RADIO2_DIO2,
+     &LORA_RADIO2_SPI},
+#endif
+};
+
 /**
- * @brief Initializes the LoRa module and prepares it for reception.
- *
- * Creates a mutex for thread-safe access, configures GPIO and SPI settings,
- * resets and initializes the LoRa module, and starts continuous reception.
- *
- * @return 1 if initialization succeeds, 0 if it fails.
+ * @brief EXTI interrupt of a GPIO pin, lines 5..9 and 10..15 share one.
  */
+static IRQn_Type LoRa_extiIrq(uint16_t pin) {
+    uint8_t line = 0U;
 
-LoRa * LoRa_Startup(LoRa * lora_instance) {
+    while ((pin >> line) > 1U) {
+        line++;
+    }
+    if (line < 5U) {
+        return (IRQn_Type)(EXTI0_IRQn + line);
+    }
+    return line < 10U ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+}
 
-     // LoRa myLora = newLoRa();
-    // lora_instance=&myLora;
+/**
+ * @brief Binds a LoRa handler to the pins and SPI of a radio of LoRa_radios.
+ */
+void LoRa_attach(LoRa * lora_instance, uint8_t radio) {
+    const LoRa_hw *hw = &LoRa_radios[radio];
+
+    lora_instance->CS_port = hw->CS_port;
+    lora_instance->CS_pin = hw->CS_pin;
+    lora_instance->reset_port = hw->reset_port;
+    lora_instance->reset_pin = hw->reset_pin;
+    lora_instance->DIO0_port = hw->DIO0_port;
+    lora_instance->DIO0_pin = hw->DIO0_pin;
+    lora_instance->power = POWER_17db;
+    lora_instance->hSPIx = hw->hSPIx;
 
+    /* the DIO handlers talk SPI, the SPI lock holds them off */
+    LoRa_spiLockIrq(LoRa_extiIrq(hw->DIO0_pin));
+    if (hw->DIO2_port != NULL) {
+        LoRa_spiLockIrq(LoRa_extiIrq(hw->DIO2_pin));
+    }
+}
 
+/**
+ * @brief Initializes a LoRa module and prepares it for reception, blocking.
+ *
+ * Resets and initializes the module, and starts continuous reception. The
+ * RA02 AO runs the same steps off TimeEvents instead.
+ *
+ * @return the instance if initialization succeeds, NULL if it fails.
+ */
 
-    lora_instance->CS_port = NSS_GPIO_Port;
-    lora_instance->CS_pin = NSS_Pin;
-    lora_instance->reset_port = RESET_GPIO_Port;
-    lora_instance->reset_pin = RESET_Pin;
-    lora_instance->DIO0_port = DID0_GPIO_Port;
-    lora_instance->DIO0_pin = DID0_Pin;
-    lora_instance->power = POWER_17db;
-    lora_instance->hSPIx = &hspi2;
+LoRa * LoRa_Startup(LoRa * lora_instance, uint8_t radio) {
+    LoRa_attach(lora_instance, radio);
     LoRa_reset(lora_instance);
 
     if (LoRa_init(lora_instance) !=LORA_OK) {
@@ -43,13 +91,5 @@ LoRa * LoRa_Startup(LoRa * lora_instance) {
 
     LoRa_startReceiving(lora_instance);
 
-
-
-
-
     return lora_instance;
 }
-
-
-
-
@@ -0,0 +1,240 @@
+//
+// Created on 10/19/26.
+//
+
+#include "Mesh/arq.h"
+
+#include <string.h>
+
+static arq_peer_t peers[ARQ_PEERS];
+
+static void arq_reset(arq_peer_t *p, uint8_t peer, uint32_t now) {
+    (void)memset(p, 0, sizeof(*p));
+    p->peer = peer;
+    p->last_active = now;
+    p->rto = ARQ_RTO_INIT_MS;
+}
+
+void arq_init(void) {
+    for (uint8_t i = 0U; i < ARQ_PEERS; i++) {
+        arq_reset(&peers[i], MESH_BROADCAST_ID, 0U);
+    }
+}
+
+static bool arq_idle(arq_peer_t const *p) {
+    return p->tx_base == p->tx_next && !p->ack_pending;
+}
+
+arq_peer_t *arq_find(uint8_t peer, bool create, uint32_t now) {
+    arq_peer_t *victim = NULL;
+
+    if (peer == MESH_BROADCAST_ID) {
+        return NULL;
+    }
+
+    for (uint8_t i = 0U; i < ARQ_PEERS; i++) {
+        arq_peer_t *p = &peers[i];
+
+        if (p->peer == peer) {
+            p->last_active = now;
+            return p;
+        }
+        /* free first, else the longest idle; never one with frames in flight */
+        if (p->peer == MESH_BROADCAST_ID || arq_idle(p)) {
+            if (victim == NULL || p->peer == MESH_BROADCAST_ID
+                || (victim->peer != MESH_BROADCAST_ID && (now - p->last_active) > (now - victim->last_active))) {
+                victim = p;
+            }
+        }
+    }
+    if (!create || victim == NULL) {
+        return NULL;
+    }
+    arq_reset(victim, peer, now);
+    return victim;
+}
+
+/*..........................................................................................*/
+
+bool arq_tx_push(arq_peer_t *p, uint8_t const *data, uint8_t *seq, uint32_t now) {
+    arq_tx_t *t;
+
+    if ((uint8_t)(p->tx_next - p->tx_base) >= ARQ_WINDOW) {
+        return false;
+    }
+    t = &p->tx[p->tx_next % ARQ_WINDOW];
+    (void)memcpy(t->data, data, ARQ_DATA_LEN);
+    t->tries = 0U;
+    t->acked = false;
+    *seq = p->tx_next++;
+    p->last_active = now;
+    return true;
+}
+
+void arq_tx_sent(arq_peer_t *p, uint8_t seq, uint32_t now) {
+    arq_tx_t *t = &p->tx[seq % ARQ_WINDOW];
+
+    t->tries++;
+    t->sent = now;
+}
+
+/* one RTT sample, RFC 6298 with the usual fixed point */
+static void arq_rtt_sample(arq_peer_t *p, uint32_t rtt) {
+    if (p->srtt == 0U) {
+        p->srtt = rtt * 8U;
+        p->rttvar = rtt * 2U;
+    } else {
+        int32_t err = (int32_t)rtt - (int32_t)(p->srtt / 8U);
+
+        p->srtt = (uint32_t)((int32_t)p->srtt + err);
+        p->rttvar = (uint32_t)((int32_t)p->rttvar + ((err < 0 ? -err : err) - (int32_t)(p->rttvar / 4U)));
+    }
+    p->rto = p->srtt / 8U + p->rttvar;
+    if (p->rto < ARQ_RTO_MIN_MS) {
+        p->rto = ARQ_RTO_MIN_MS;
+    } else if (p->rto > ARQ_RTO_MAX_MS) {
+        p->rto = ARQ_RTO_MAX_MS;
+    }
+}
+
+static void arq_tx_acked(arq_peer_t *p, uint8_t seq, uint32_t now) {
+    arq_tx_t *t = &p->tx[seq % ARQ_WINDOW];
+
+    if ((uint8_t)(seq - p->tx_base) >= (uint8_t)(p->tx_next - p->tx_base) || t->acked || t->tries == 0U) {
+        return; /* outside the window, old news or not sent yet */
+    }
+    t->acked = true;
+    p->tx_synced = true;
+    if (t->tries == 1U) {
+        arq_rtt_sample(p, now - t->sent); /* Karn: only frames sent once */
+    }
+}
+
+void arq_rx_ack(arq_peer_t *p, uint8_t cum, uint32_t map, uint32_t now) {
+    /* everything before cum, if cum lies in the window at all */
+    if ((uint8_t)(cum - p->tx_base) <= (uint8_t)(p->tx_next - p->tx_base)) {
+        for (uint8_t seq = p->tx_base; seq != cum; seq++) {
+            arq_tx_acked(p, seq, now);
+        }
+    }
+    for (uint8_t i = 0U; i < 32U && map != 0U; i++, map >>= 1) {
+        if (map & 1U) {
+            arq_tx_acked(p, (uint8_t)(cum + 1U + i), now);
+        }
+    }
+    while (p->tx_base != p->tx_next && p->tx[p->tx_base % ARQ_WINDOW].acked) {
+        p->tx_base++;
+    }
+    p->last_active = now;
+}
+
+bool arq_tx_due(arq_peer_t *p, uint8_t *seq, uint32_t now) {
+    bool oldest = true;
+
+    for (uint8_t s = p->tx_base; s != p->tx_next; s++) {
+        arq_tx_t *t = &p->tx[s % ARQ_WINDOW];
+
+        if (t->acked) {
+            continue;
+        }
+        if (t->tries != 0U && (now - t->sent) < p->rto) {
+            oldest = false;
+            continue;
+        }
+        if (t->tries >= ARQ_MAX_TRIES) {
+            t->acked = true; /* given up, the window moves on */
+            p->failed++;
+            continue;
+        }
+        /* back off once per timeout, on the oldest frame, not once per frame of the window */
+        if (t->tries != 0U && oldest) {
+            p->rto = p->rto * 2U < ARQ_RTO_MAX_MS ? p->rto * 2U : ARQ_RTO_MAX_MS;
+        }
+        *seq = s;
+        return true;
+    }
+    while (p->tx_base != p->tx_next && p->tx[p->tx_base % ARQ_WINDOW].acked) {
+        p->tx_base++;
+    }
+    return false;
+}
+
+/*..........................................................................................*/
+
+bool arq_rx_data(arq_peer_t *p, uint8_t seq, bool syn, uint32_t now) {
+    uint8_t ahead;
+    bool fresh = false;
+
+    if (syn && !p->rx_syn) {
+        p->rx_next = 0U; /* the peer started over */
+        p->rx_map = 0U;
+    }
+    p->rx_syn = syn;
+
+    ahead = (uint8_t)(seq - p->rx_next);
+    if (ahead > 32U && ahead < (uint8_t)(256U - ARQ_WINDOW)) {
+        p->rx_next = seq; /* neither new nor a late copy: we lost the peer's state */
+        p->rx_map = 0U;
+        ahead = 0U;
+    }
+
+    if (ahead == 0U) {
+        fresh = true;
+        p->rx_next++;
+        /* slide over everything that already arrived past the gap */
+        while (p->rx_map & 1U) {
+            p->rx_map >>= 1;
+            p->rx_next++;
+        }
+        p->rx_map >>= 1;
+    } else if (ahead <= 32U) {
+        fresh = (p->rx_map & (1UL << (ahead - 1U))) == 0U;
+        p->rx_map |= 1UL << (ahead - 1U);
+    }
+    /* duplicates are acked again, our previous ack may have been lost */
+    if (!p->ack_pending) {
+        p->ack_pending = true;
+        p->ack_due = now + ARQ_ACK_DELAY_MS;
+    }
+    p->last_active = now;
+    return fresh;
+}
+
+void arq_ack_take(arq_peer_t *p, uint8_t *cum, uint32_t *map) {
+    *cum = p->rx_next;
+    *map = p->rx_map;
+    p->ack_pending = false;
+}
+
+arq_peer_t *arq_at(uint8_t i) {
+    return peers[i].peer != MESH_BROADCAST_ID ? &peers[i] : NULL;
+}
+
+uint32_t arq_next_deadline(uint32_t now) {
+    uint32_t next = UINT32_MAX;
+
+    for (uint8_t i = 0U; i < ARQ_PEERS; i++) {
+        arq_peer_t const *p = &peers[i];
+
+        if (p->peer == MESH_BROADCAST_ID) {
+            continue;
+        }
+        if (p->ack_pending) {
+            uint32_t left = (int32_t)(p->ack_due - now) > 0 ? p->ack_due - now : 0U;
+            next = left < next ? left : next;
+        }
+        for (uint8_t s = p->tx_base; s != p->tx_next; s++) {
+            arq_tx_t const *t = &p->tx[s % ARQ_WINDOW];
+            uint32_t left = 0U;
+
+            if (t->acked) {
+                continue;
+            }
+            if (t->tries != 0U && (now - t->sent) < p->rto) {
+                left = p->rto - (now - t->sent);
+            }
+            next = left < next ? left : next;
+        }
+    }
+    return next;
+}
@@ -0,0 +1,53 @@
+//
+// Created on 10/19/26.
+//
+
+#include "Mesh/dup_cache.h"
+
+#include <string.h>
+
+typedef struct dup_entry {
+    uint32_t seen; /* ms */
+    uint16_t msg_id;
+    uint8_t src_id;
+    uint8_t used;
+} dup_entry_t;
+
+static dup_entry_t dup_cache[DUP_CACHE_SIZE];
+
+void dup_cache_init(void) {
+    (void)memset(dup_cache, 0, sizeof(dup_cache));
+}
+
+/* Fibonacci hashing of the 24-bit key, the top bits are the well mixed ones */
+static uint32_t dup_hash(uint8_t src_id, uint16_t msg_id) {
+    uint32_t key = ((uint32_t)src_id << 16) | msg_id;
+
+    return (key * 2654435761UL) >> (32U - DUP_CACHE_BITS);
+}
+
+bool dup_cache_check(uint8_t src_id, uint16_t msg_id, uint32_t now) {
+    uint32_t idx = dup_hash(src_id, msg_id);
+    dup_entry_t *victim = NULL;
+    bool victim_live = true;
+
+    for (uint32_t i = 0U; i < DUP_CACHE_PROBES; i++) {
+        dup_entry_t *e = &dup_cache[(idx + i) & (DUP_CACHE_SIZE - 1U)];
+        bool live = e->used && (now - e->seen) < DUP_CACHE_AGE_MS;
+
+        if (live && e->src_id == src_id && e->msg_id == msg_id) {
+            return true;
+        }
+        /* free or expired slot first, else the oldest entry of the window */
+        if (victim == NULL || (victim_live && (!live || (now - e->seen) > (now - victim->seen)))) {
+            victim = e;
+            victim_live = live;
+        }
+    }
+
+    victim->seen = now;
+    victim->msg_id = msg_id;
+    victim->src_id = src_id;
+    victim->used = 1U;
+    return false;
+}
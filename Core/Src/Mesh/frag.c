@@ -0,0 +1,332 @@
+//
+// Created on 10/19/26.
+//
+
+#include "Mesh/frag.h"
+
+#include <string.h>
+
+_Static_assert(MESH_MAX_PAYLOAD >= 6U, "no room for the fragment header");
+_Static_assert(FRAG_MAX_COUNT < 255U, "fragment index is one byte");
+
+static frag_tx_t tx;
+static frag_rx_t rx[FRAG_RX_SLOTS];
+
+static bool frag_bit(uint8_t const *map, uint8_t i) {
+    return ((map[i / 8U] >> (i % 8U)) & 1U) != 0U;
+}
+
+static void frag_bit_set(uint8_t *map, uint8_t i) {
+    map[i / 8U] |= (uint8_t)(1U << (i % 8U));
+}
+
+static void frag_bit_clear(uint8_t *map, uint8_t i) {
+    map[i / 8U] &= (uint8_t)~(1U << (i % 8U));
+}
+
+/* bytes of the message in data fragment 'index' */
+static uint8_t frag_data_len(uint16_t length, uint8_t index) {
+    uint16_t rest = (uint16_t)(length - (index - 1U) * FRAG_DATA_LEN);
+
+    return (uint8_t)(rest < FRAG_DATA_LEN ? rest : FRAG_DATA_LEN);
+}
+
+static void frag_rx_reset(frag_rx_t *r, uint8_t src, uint8_t tag) {
+    (void)memset(r, 0, sizeof(*r));
+    r->src = src;
+    r->tag = tag;
+}
+
+void frag_init(void) {
+    (void)memset(&tx, 0, sizeof(tx));
+    atomic_store_explicit(&tx.busy, false, memory_order_relaxed);
+    for (uint8_t i = 0U; i < FRAG_RX_SLOTS; i++) {
+        frag_rx_reset(&rx[i], MESH_BROADCAST_ID, 0U);
+    }
+}
+
+/*..........................................................................................*/
+
+bool frag_tx_start(uint8_t dest, uint8_t const *data, uint16_t length, uint32_t now) {
+    if (atomic_load_explicit(&tx.busy, memory_order_acquire)
+        || dest == MESH_BROADCAST_ID || length == 0U || length > FRAG_MAX_LEN) {
+        return false;
+    }
+    (void)memcpy(tx.data, data, length);
+    tx.dest = dest;
+    tx.tag++;
+    tx.length = length;
+    tx.crc = crc16(data, length);
+    tx.count = (uint8_t)((length + FRAG_DATA_LEN - 1U) / FRAG_DATA_LEN);
+    (void)memset(tx.pending, 0, sizeof(tx.pending));
+    for (uint8_t i = 0U; i <= tx.count; i++) {
+        frag_bit_set(tx.pending, i);
+    }
+    tx.burst = 0U;
+    tx.probes = 0U;
+    tx.due = now;
+    atomic_store_explicit(&tx.busy, true, memory_order_release);
+    return true;
+}
+
+/* first fragment still to send, count + 1 if none */
+static uint8_t frag_tx_first(void) {
+    uint8_t i = 0U;
+
+    while (i <= tx.count && !frag_bit(tx.pending, i)) {
+        i++;
+    }
+    return i;
+}
+
+static void frag_tx_done(bool acked) {
+    if (acked) {
+        tx.sent++;
+    } else {
+        tx.failed++;
+    }
+    atomic_store_explicit(&tx.busy, false, memory_order_release);
+}
+
+bool frag_tx_next(uint8_t *dest, uint8_t *payload, uint32_t now) {
+    uint8_t i;
+
+    if (!atomic_load_explicit(&tx.busy, memory_order_acquire) || (int32_t)(now - tx.due) < 0) {
+        return false;
+    }
+
+    i = frag_tx_first();
+    if (i > tx.count) {
+        /* all out and no status within FRAG_STATUS_TIMEOUT_MS: ask again with the header */
+        if (tx.probes >= FRAG_MAX_PROBES) {
+            frag_tx_done(false);
+            return false;
+        }
+        tx.probes++;
+        i = 0U;
+    }
+    frag_bit_clear(tx.pending, i);
+
+    *dest = tx.dest;
+    payload[0] = tx.tag;
+    payload[1] = i;
+    if (i == 0U) {
+        payload[2] = (uint8_t)tx.length;
+        payload[3] = (uint8_t)(tx.length >> 8);
+        payload[4] = (uint8_t)tx.crc;
+        payload[5] = (uint8_t)(tx.crc >> 8);
+    } else {
+        uint8_t n = frag_data_len(tx.length, i);
+
+        (void)memset(&payload[2], 0, MESH_MAX_PAYLOAD - 2U);
+        (void)memcpy(&payload[2], &tx.data[(i - 1U) * FRAG_DATA_LEN], n);
+    }
+
+    if (frag_tx_first() > tx.count) {
+        tx.burst = 0U;
+        tx.due = now + FRAG_STATUS_TIMEOUT_MS;
+    } else if (++tx.burst >= FRAG_TX_BURST) {
+        tx.burst = 0U;
+        tx.due = now + FRAG_TX_PACE_MS;
+    }
+    return true;
+}
+
+void frag_tx_status(uint8_t src, uint8_t const *payload, uint32_t now) {
+    uint32_t map = (uint32_t)payload[2] | ((uint32_t)payload[3] << 8)
+                   | ((uint32_t)payload[4] << 16) | ((uint32_t)payload[5] << 24);
+    uint8_t base = payload[1];
+    bool waiting;
+
+    if (!atomic_load_explicit(&tx.busy, memory_order_acquire) || src != tx.dest || payload[0] != tx.tag) {
+        return;
+    }
+    tx.probes = 0U;
+    if (map == 0U) {
+        frag_tx_done(true);
+        return;
+    }
+
+    waiting = frag_tx_first() > tx.count;
+    for (uint8_t i = 0U; i < 32U && map != 0U; i++, map >>= 1) {
+        if ((map & 1U) != 0U && (uint16_t)base + i <= tx.count) {
+            frag_bit_set(tx.pending, (uint8_t)(base + i));
+        }
+    }
+    /* only the status timeout was running, the holes go out right away */
+    if (waiting) {
+        tx.burst = 0U;
+        tx.due = now;
+    }
+}
+
+/*..........................................................................................*/
+
+/* free or timed out slots go first, then delivered ones; messages in progress stay */
+static uint8_t frag_rx_rank(frag_rx_t const *r, uint32_t now) {
+    if (r->src == MESH_BROADCAST_ID || (now - r->last_active) >= FRAG_RX_TIMEOUT_MS) {
+        return 0U;
+    }
+    return r->done ? 1U : 2U;
+}
+
+static frag_rx_t *frag_rx_slot(uint8_t src, uint8_t tag, uint32_t now) {
+    frag_rx_t *victim = NULL;
+    uint8_t victim_rank = 2U;
+
+    for (uint8_t i = 0U; i < FRAG_RX_SLOTS; i++) {
+        frag_rx_t *r = &rx[i];
+        uint8_t rank = frag_rx_rank(r, now);
+
+        if (r->src == src && r->tag == tag) {
+            if (rank == 0U) {
+                frag_rx_reset(r, src, tag);
+            }
+            return r;
+        }
+        if (rank < victim_rank
+            || (victim != NULL && rank == victim_rank && (now - r->last_active) > (now - victim->last_active))) {
+            victim = r;
+            victim_rank = rank;
+        }
+    }
+    if (victim != NULL) {
+        frag_rx_reset(victim, src, tag);
+    }
+    return victim;
+}
+
+/* run the CRC over the data fragments that lined up behind the last one it took */
+static void frag_rx_advance(frag_rx_t *r) {
+    while (r->header && r->crc_next <= r->count && frag_bit(r->received, r->crc_next)) {
+        r->crc_run = crc16_update(r->crc_run, &r->data[(r->crc_next - 1U) * FRAG_DATA_LEN],
+                                  frag_data_len(r->length, r->crc_next));
+        r->crc_next++;
+    }
+}
+
+static void frag_rx_header(frag_rx_t *r, uint8_t const *payload) {
+    r->header = true;
+    r->length = (uint16_t)(payload[2] | ((uint16_t)payload[3] << 8));
+    r->crc = (uint16_t)(payload[4] | ((uint16_t)payload[5] << 8));
+    r->count = (uint8_t)((r->length + FRAG_DATA_LEN - 1U) / FRAG_DATA_LEN);
+    r->crc_run = CRC16_INIT;
+    r->crc_next = 1U;
+    frag_bit_set(r->received, 0U);
+}
+
+frag_rx_t const *frag_rx(uint8_t src, uint8_t const *payload, uint32_t now) {
+    uint8_t index = payload[1];
+    bool urgent = false;
+    frag_rx_t *r;
+
+    if (index > FRAG_MAX_COUNT) {
+        return NULL;
+    }
+    if (index == 0U) {
+        uint16_t length = (uint16_t)(payload[2] | ((uint16_t)payload[3] << 8));
+
+        if (length == 0U || length > FRAG_MAX_LEN) {
+            return NULL;
+        }
+    }
+    r = frag_rx_slot(src, payload[0], now);
+    if (r == NULL) {
+        return NULL; /* every slot busy, the sender probes again */
+    }
+    r->last_active = now;
+
+    if (index == 0U) {
+        /* another message under a tag we still remember: the sender restarted */
+        if (r->header && (payload[2] != (uint8_t)r->length || payload[3] != (uint8_t)(r->length >> 8)
+                          || payload[4] != (uint8_t)r->crc || payload[5] != (uint8_t)(r->crc >> 8))) {
+            frag_rx_reset(r, src, payload[0]);
+            r->last_active = now;
+        }
+        if (r->header) {
+            urgent = true; /* a probe */
+        } else {
+            frag_rx_header(r, payload);
+        }
+    } else if (r->done) {
+        urgent = true; /* our status got lost */
+    } else if (!r->header || index <= r->count) {
+        (void)memcpy(&r->data[(index - 1U) * FRAG_DATA_LEN], &payload[2], FRAG_DATA_LEN);
+        frag_bit_set(r->received, index);
+    }
+
+    if (!r->done) {
+        frag_rx_advance(r);
+        if (r->header && r->crc_next > r->count) {
+            if (r->crc_run == r->crc) {
+                r->done = true;
+                r->status_pending = true;
+                r->status_due = now;
+                return r;
+            }
+            /* damaged on the way, start over on the data */
+            (void)memset(r->received, 0, sizeof(r->received));
+            frag_bit_set(r->received, 0U);
+            r->crc_run = CRC16_INIT;
+            r->crc_next = 1U;
+            urgent = true;
+        }
+    }
+    r->status_pending = true;
+    r->status_due = urgent ? now : now + FRAG_GAP_MS;
+    return NULL;
+}
+
+bool frag_status_take(uint8_t *dest, uint8_t *payload, uint32_t now) {
+    for (uint8_t i = 0U; i < FRAG_RX_SLOTS; i++) {
+        frag_rx_t *r = &rx[i];
+        uint8_t last;
+        uint8_t base = 0U;
+        uint32_t map = 0U;
+
+        if (!r->status_pending || (int32_t)(now - r->status_due) < 0) {
+            continue;
+        }
+        r->status_pending = false;
+
+        if (!r->done) {
+            last = r->header ? r->count : (uint8_t)FRAG_MAX_COUNT;
+            while (base <= last && frag_bit(r->received, base)) {
+                base++;
+            }
+            for (uint8_t j = 0U; j < 32U && (uint16_t)base + j <= last; j++) {
+                if (!frag_bit(r->received, (uint8_t)(base + j))) {
+                    map |= 1UL << j;
+                }
+            }
+        }
+        *dest = r->src;
+        payload[0] = r->tag;
+        payload[1] = map != 0U ? base : 0U;
+        for (uint8_t j = 0U; j < 4U; j++) {
+            payload[2U + j] = (uint8_t)(map >> (8U * j));
+        }
+        return true;
+    }
+    return false;
+}
+
+/*..........................................................................................*/
+
+static uint32_t frag_until(uint32_t due, uint32_t now) {
+    return (int32_t)(due - now) > 0 ? due - now : 0U;
+}
+
+uint32_t frag_next_deadline(uint32_t now) {
+    uint32_t next = UINT32_MAX;
+
+    if (atomic_load_explicit(&tx.busy, memory_order_acquire)) {
+        next = frag_until(tx.due, now);
+    }
+    for (uint8_t i = 0U; i < FRAG_RX_SLOTS; i++) {
+        if (rx[i].status_pending && frag_until(rx[i].status_due, now) < next) {
+            next = frag_until(rx[i].status_due, now);
+        }
+    }
+    return next;
+}
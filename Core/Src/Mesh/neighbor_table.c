@@ -0,0 +1,138 @@
+//
+// Created on 10/19/26.
+//
+
+#include "Mesh/neighbor_table.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "packet_t.h"
+
+static neighbor_t neighbors[NEIGHBOR_TABLE_SIZE];
+
+void neighbor_table_init(void) {
+    (void)memset(neighbors, 0, sizeof(neighbors));
+    for (uint8_t i = 0U; i < NEIGHBOR_TABLE_SIZE; i++) {
+        neighbors[i].id = MESH_BROADCAST_ID; /* free slot */
+    }
+}
+
+static neighbor_t *neighbor_lookup(uint8_t id) {
+    for (uint8_t i = 0U; i < NEIGHBOR_TABLE_SIZE; i++) {
+        if (neighbors[i].id == id && id != MESH_BROADCAST_ID) {
+            return &neighbors[i];
+        }
+    }
+    return NULL;
+}
+
+/* copy of the entry of 'id', false if there is none */
+bool neighbor_table_find(uint8_t id, neighbor_t *out) {
+    neighbor_t const *n;
+
+    vTaskSuspendAll();
+    n = neighbor_lookup(id);
+    if (n != NULL) {
+        *out = *n;
+    }
+    (void)xTaskResumeAll();
+    return n != NULL;
+}
+
+static int16_t ewma(int16_t avg, int16_t sample) {
+    return (int16_t)(avg + (sample - avg) / (1 << NEIGHBOR_EWMA_SHIFT));
+}
+
+/*
+ * record a frame heard from 'id', the least recently heard entry makes room for new
+ * ones. A new entry starts from whatever frame came first, the first one sent at
+ * full power replaces it.
+ */
+bool neighbor_table_update(uint8_t id, int16_t rssi, int8_t snr, bool full_power, uint32_t now) {
+    neighbor_t *n;
+
+    if (id == MESH_BROADCAST_ID) {
+        return false;
+    }
+
+    vTaskSuspendAll();
+    n = neighbor_lookup(id);
+    if (n == NULL) {
+        n = &neighbors[0];
+        for (uint8_t i = 0U; i < NEIGHBOR_TABLE_SIZE; i++) {
+            if (neighbors[i].id == MESH_BROADCAST_ID) {
+                n = &neighbors[i];
+                break;
+            }
+            if ((now - neighbors[i].last_seen) > (now - n->last_seen)) {
+                n = &neighbors[i];
+            }
+        }
+        n->id = id;
+        n->rx_count = 0U;
+        n->link_count = 0U;
+        n->rssi = (int16_t)(rssi * 16);
+        n->snr = (int16_t)(snr * 16);
+        n->carrier = NEIGHBOR_CARRIER_UNKNOWN;
+    }
+
+    if (full_power) {
+        n->rssi = n->link_count == 0U ? (int16_t)(rssi * 16) : ewma(n->rssi, (int16_t)(rssi * 16));
+        n->snr = n->link_count == 0U ? (int16_t)(snr * 16) : ewma(n->snr, (int16_t)(snr * 16));
+        if (n->link_count < UINT8_MAX) {
+            n->link_count++;
+        }
+    }
+    if (n->rx_count < UINT8_MAX) {
+        n->rx_count++;
+    }
+    n->last_seen = now;
+    (void)xTaskResumeAll();
+    return true;
+}
+
+/* feed the carrier offset measured on a frame of 'id' (FEI plus our own correction) */
+void neighbor_table_carrier(uint8_t id, int32_t carrier_hz) {
+    neighbor_t *n;
+
+    if (carrier_hz > INT16_MAX) {
+        carrier_hz = INT16_MAX;
+    } else if (carrier_hz <= INT16_MIN) {
+        carrier_hz = INT16_MIN + 1;
+    }
+
+    vTaskSuspendAll();
+    n = neighbor_lookup(id);
+    if (n != NULL) {
+        n->carrier = n->carrier == NEIGHBOR_CARRIER_UNKNOWN ? (int16_t)carrier_hz
+                                                            : ewma(n->carrier, (int16_t)carrier_hz);
+    }
+    (void)xTaskResumeAll();
+}
+
+/* 1, 2, 4 or 8 for a margin above the floor of 10, 5, 0 or -2.5 dB, unusable below or when stale */
+uint8_t neighbor_table_cost(neighbor_t const *n, uint32_t now) {
+    int16_t margin;
+
+    if (n == NULL || n->link_count < NEIGHBOR_MIN_FRAMES || (now - n->last_seen) > NEIGHBOR_MAX_AGE_MS) {
+        return NEIGHBOR_COST_UNUSABLE;
+    }
+
+    margin = (int16_t)(n->snr - NEIGHBOR_SNR_FLOOR);
+    if (margin >= 10 * 16) {
+        return 1U;
+    }
+    if (margin >= 5 * 16) {
+        return 2U;
+    }
+    if (margin >= 0) {
+        return 4U;
+    }
+    if (margin >= -40) {
+        return 8U;
+    }
+    return NEIGHBOR_COST_UNUSABLE;
+}
@@ -0,0 +1,127 @@
+//
+// Created on 10/19/26.
+//
+
+#include "Mesh/route_table.h"
+
+#include <stddef.h>
+
+static route_t routes[ROUTE_TABLE_SIZE];
+
+void route_table_init(void) {
+    for (uint8_t i = 0U; i < ROUTE_TABLE_SIZE; i++) {
+        routes[i].dest = MESH_BROADCAST_ID;
+    }
+}
+
+/* a route not refreshed for ROUTE_MAX_AGE_MS is poisoned, a poisoned one is freed after ROUTE_HOLDDOWN_MS */
+static void route_expire(route_t *r, uint32_t now) {
+    if (r->dest == MESH_BROADCAST_ID) {
+        return;
+    }
+    if (r->cost != ROUTE_COST_INFINITE && (now - r->updated) > ROUTE_MAX_AGE_MS) {
+        r->cost = ROUTE_COST_INFINITE;
+        r->updated += ROUTE_MAX_AGE_MS;
+    }
+    if (r->cost == ROUTE_COST_INFINITE && (now - r->updated) > ROUTE_HOLDDOWN_MS) {
+        r->dest = MESH_BROADCAST_ID;
+    }
+}
+
+/* the entry for dest, poisoned or not */
+static route_t *route_find(uint8_t dest, uint32_t now) {
+    for (uint8_t i = 0U; i < ROUTE_TABLE_SIZE; i++) {
+        if (routes[i].dest == dest && dest != MESH_BROADCAST_ID) {
+            route_expire(&routes[i], now);
+            return routes[i].dest == dest ? &routes[i] : NULL;
+        }
+    }
+    return NULL;
+}
+
+void route_table_update(uint8_t dest, uint8_t next_hop, uint32_t cost, uint32_t now) {
+    route_t *r = route_find(dest, now);
+
+    if (dest == MESH_NODE_ID || dest == MESH_BROADCAST_ID) {
+        return;
+    }
+    if (cost > ROUTE_COST_INFINITE) {
+        cost = ROUTE_COST_INFINITE;
+    }
+
+    if (r != NULL) {
+        if (r->cost == ROUTE_COST_INFINITE && next_hop != dest) {
+            return; /* held down, a route offered now may still run through the lost one */
+        }
+        if (r->next_hop != next_hop && cost >= r->cost) {
+            return; /* ours is as good, keep it */
+        }
+        if (cost == ROUTE_COST_INFINITE) {
+            /* our next hop lost it, tell the ones routing through us */
+            r->cost = ROUTE_COST_INFINITE;
+            r->updated = now;
+            return;
+        }
+    } else {
+        if (cost == ROUTE_COST_INFINITE) {
+            return;
+        }
+        /* free or aged slot, else the most expensive route makes room if it costs more */
+        for (uint8_t i = 0U; i < ROUTE_TABLE_SIZE; i++) {
+            route_t *c = &routes[i];
+
+            route_expire(c, now);
+            if (c->dest == MESH_BROADCAST_ID) {
+                r = c;
+                break;
+            }
+            if (c->cost > cost && (r == NULL || c->cost > r->cost)) {
+                r = c;
+            }
+        }
+        if (r == NULL) {
+            return;
+        }
+    }
+
+    r->dest = dest;
+    r->next_hop = next_hop;
+    r->cost = (uint8_t)cost;
+    r->updated = now;
+}
+
+uint8_t route_table_next_hop(uint8_t dest, uint32_t now) {
+    route_t const *r = route_find(dest, now);
+
+    return r != NULL && r->cost < ROUTE_COST_INFINITE ? r->next_hop : MESH_BROADCAST_ID;
+}
+
+void route_table_advert_rx(uint8_t src, uint8_t link_cost, uint8_t const payload[MESH_MAX_PAYLOAD], uint32_t now) {
+    route_table_update(src, src, link_cost, now);
+    for (uint8_t i = 0U; i < ROUTE_ADVERT_PAIRS; i++) {
+        uint8_t dest = payload[2U * i];
+
+        if (dest != MESH_BROADCAST_ID) {
+            route_table_update(dest, src, (uint32_t)payload[2U * i + 1U] + link_cost, now);
+        }
+    }
+}
+
+void route_table_advert_tx(uint8_t payload[MESH_MAX_PAYLOAD], uint8_t *cursor, uint32_t now) {
+    uint8_t n = 0U;
+
+    for (uint8_t i = 0U; i < MESH_MAX_PAYLOAD; i++) {
+        payload[i] = MESH_BROADCAST_ID;
+    }
+    for (uint8_t i = 0U; i < ROUTE_TABLE_SIZE && n < ROUTE_ADVERT_PAIRS; i++) {
+        route_t *r = &routes[*cursor];
+
+        *cursor = (uint8_t)((*cursor + 1U) % ROUTE_TABLE_SIZE);
+        route_expire(r, now);
+        if (r->dest != MESH_BROADCAST_ID) {
+            payload[2U * n] = r->dest;
+            payload[2U * n + 1U] = r->cost;
+            n++;
+        }
+    }
+}
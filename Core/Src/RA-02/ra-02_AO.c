@@ -5,29 +5,623 @@
 #include "FreeAct.h"
 #include "ra-02_AO.h"
 
+#include <stddef.h>
 #include <string.h>
 
 #include "packet_t.h"
+#include "ra-02_adr.h"
 #include "LoRa/LoRa_Startup.h"
+#include "Mesh/neighbor_table.h"
+#include "Router/router_AO.h"
+#include "timestamp.h"
 
-static LoRa myLoRa;
+static struct RA02 ra02[LORA_RADIO_COUNT];
+Active *const AO_RA02[LORA_RADIO_COUNT] = {
+    &ra02[0].super,
+#if LORA_RADIO_COUNT > 1U
+    &ra02[1].super,
+#endif
+};
 
-static uint8_t rx_buffer[64] = {0};
-static uint8_t tx_buffer[64] = {0};
+/* every RX ring slot can have an event in flight, plus the TimeEvents and a TX request */
+_Static_assert(RA02_QUEUE_LEN >= LORA_RX_RING_LEN + 4U, "RA02 queue shorter than the RX ring");
+_Static_assert(RA02_AGG_MAX <= LORA_RX_SLOT_SIZE, "RX slots shorter than an aggregate");
+_Static_assert(!RA02_AGGREGATE || !RA02_IMPLICIT_HEADER, "aggregates need the explicit header");
+_Static_assert(RA02_TXQ_CONTROL_LEN <= RA02_TX_QUEUE_LEN && RA02_TXQ_INTERACTIVE_LEN <= RA02_TX_QUEUE_LEN
+               && RA02_TXQ_BULK_LEN <= RA02_TX_QUEUE_LEN, "TX queue deeper than its slots");
+_Static_assert(RA02_TXQ_INTERACTIVE_QUANTUM > 0U && RA02_TXQ_BULK_QUANTUM > 0U, "DRR needs a quantum");
 
+static Event const *ra02_queue[LORA_RADIO_COUNT][RA02_QUEUE_LEN];
+static StackType_t ra02_stack[LORA_RADIO_COUNT][RA02_STACK_SIZE];
+
+/* radio behind each EXTI line, indexed by pin number so the ISR needs no search */
+static struct RA02 *ra02_by_exti[16];
+static struct RA02 *ra02_by_dio2[16]; /* FhssChangeChannel lines */
+
+/* DIO0 events, the ISR picks one by the mode the radio was put in */
+static Event const rxDoneEvt = {RECEIVED_TRANSMISSION_EVENT};
+static Event const cadDoneEvt = {CAD_DONE_EVT};
+static Event const txDoneEvt = {TX_DONE_EVT};
+static Event const initEvt = {RA02_INIT_EVT};
+
+/* BEACON_EVT is handled in several states, the beacon itself is built next to TX */
+static void RA02_tdma_beacon(struct RA02 *const me);
+
+
+/*..........................................................................................*/
+
+void RA02_ctor(struct RA02 *const me, uint8_t radio) {
+    Active_ctor(&me->super, IDLE);
+    me->radio = radio;
+    memset(me->txq, 0, sizeof(me->txq));
+    me->drr_turn = RA02_TXQ_INTERACTIVE;
+    ra02_by_exti[__builtin_ctz(LoRa_radios[radio].DIO0_pin)] = me;
+    if (LoRa_radios[radio].DIO2_pin != 0U) {
+        ra02_by_dio2[__builtin_ctz(LoRa_radios[radio].DIO2_pin)] = me;
+    }
+    TimeEvent_ctor(&me->te, BACKOFF_TIMEOUT_EVT, &me->super);
+    TimeEvent_ctor(&me->duty_te, DUTY_TIMEOUT_EVT, &me->super);
+    TimeEvent_ctor(&me->slot_te, TDMA_SLOT_EVT, &me->super);
+    TimeEvent_ctor(&me->beacon_te, BEACON_EVT, &me->super);
+    TimeEvent_ctor(&me->hop_te, HOP_EVT, &me->super);
+    TimeEvent_ctor(&me->wake_te, WAKE_EVT, &me->super);
+    TimeEvent_ctor(&me->boot_te, BOOT_TIMEOUT_EVT, &me->super);
+    TimeEvent_ctor(&me->agg_te, AGG_TIMEOUT_EVT, &me->super);
+    RA02_fhss_init(&me->fhss, RA02_FHSS_SEED);
+    me->mac_mode = RA02_MAC_MODE;
+    me->tx_beacon = false;
+    me->tx_length = 0U;
+    me->tx_frames = 0U;
+    me->tx_class = RA02_TXQ_CONTROL;
+    RA02_afc_init(&me->afc);
+    me->is_initialized = false;
+    me->lbt_attempts = 0U;
+    me->dio0_timeouts = 0U;
+    me->prng = 1U;
+    memset(me->duty_bucket, 0, sizeof(me->duty_bucket));
+    me->duty_epoch = 0U;
+}
+
+void RA02_start(void) {
+    neighbor_table_init(); /* shared, every radio hears the same neighbors */
+
+    for (uint8_t i = 0U; i < LORA_RADIO_COUNT; i++) {
+        RA02_ctor(&ra02[i], i);
+        Active_start(AO_RA02[i],
+                     RA02_PRIORITY,
+                     (Event **) ra02_queue[i],
+                     RA02_QUEUE_LEN,
+                     ra02_stack[i],
+                     sizeof(ra02_stack[i]),
+                     NULL);
+        Active_post(AO_RA02[i], &initEvt);
+    }
+}
+
+/*..........................................................................................*/
+/* xorshift32, only used to spread the LBT backoff of nodes that saw the same busy channel */
+static uint32_t RA02_random(struct RA02 *const me) {
+    uint32_t x = me->prng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    me->prng = x;
+    return x;
+}
+
+/*..........................................................................................*/
+/* random backoff in [1, 2^BE] slots, BE grows with every busy CAD */
+static uint32_t RA02_backoff_ms(struct RA02 *const me) {
+    uint8_t be = me->lbt_attempts < RA02_LBT_MAX_BE ? me->lbt_attempts : RA02_LBT_MAX_BE;
+    uint32_t window = 1UL << be;
+
+    return ((RA02_random(me) & (window - 1U)) + 1U) * RA02_LBT_SLOT_MS;
+}
+
+/*..........................................................................................*/
+static uint32_t RA02_now_ms(void) {
+    return (uint32_t) xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+/* the longest frame, what TDMA slots and the duty-cycle checks are sized for */
+static uint32_t RA02_toa_us(struct RA02 *const me) {
+    return LoRa_packetTimeOnAir(&me->lora, PACKET_WIRE_MAX);
+}
+
+static uint32_t RA02_airtime_ms(struct RA02 *const me) {
+    return (RA02_toa_us(me) + 999UL) / 1000UL;
+}
+
+/* airtime of what tx_buffer holds, an aggregate can be longer than one frame */
+static uint32_t RA02_tx_airtime_ms(struct RA02 *const me) {
+    return (LoRa_packetTimeOnAir(&me->lora, me->tx_length) + 999UL) / 1000UL;
+}
+
+/* longest frame we may hear */
+static uint32_t RA02_max_airtime_ms(struct RA02 *const me) {
+    return (LoRa_packetTimeOnAir(&me->lora, RA02_AGGREGATE ? RA02_AGG_MAX : PACKET_WIRE_MAX) + 999UL) / 1000UL;
+}
+
+/*..........................................................................................*/
+/*
+ * FHSS: tune to the channel of the running TDMA slot and wake up at the next slot
+ * boundary. Outside a known superframe the radio waits for a beacon on the
+ * rendezvous channel. Always rewrites Frf, intra-packet hops may have moved it.
+ */
+static void RA02_fhss_tune(struct RA02 *const me) {
+    uint32_t elapsed_us = timestamp_now_us() - me->tdma.start_us;
+    uint32_t slot;
+
+    if (!RA02_FHSS || me->mac_mode != RA02_MAC_TDMA) {
+        return;
+    }
+
+    me->fhss.pos = 0U;
+    if (me->tdma.synced && elapsed_us < RA02_tdma_superframe_us(&me->tdma)) {
+        slot = elapsed_us / me->tdma.slot_us;
+        me->fhss.pos = RA02_fhss_position(me->tdma.seq, (uint8_t) slot, me->tdma.slot_count);
+        TimeEvent_arm(&me->hop_te, ((slot + 1U) * me->tdma.slot_us - elapsed_us + 999UL) / 1000UL);
+    }
+    (void) LoRa_setChannel(&me->lora, me->fhss.channel[me->fhss.pos]);
+}
+
+/*..........................................................................................*/
+/* slide the duty-cycle window to 'now', emptying the buckets that fell out of it */
+static void RA02_duty_advance(struct RA02 *const me, uint32_t now) {
+    uint32_t epoch = now / RA02_DUTY_BUCKET_MS;
+    uint32_t steps = epoch - me->duty_epoch;
+
+    if (steps > RA02_DUTY_BUCKETS) {
+        steps = RA02_DUTY_BUCKETS;
+    }
+    for (uint32_t i = 1U; i <= steps; i++) {
+        me->duty_bucket[(me->duty_epoch + i) % RA02_DUTY_BUCKETS] = 0U;
+    }
+    me->duty_epoch = epoch;
+}
+
+/*
+ * How long to wait before 'airtime' fits in the budget: 0 to send now,
+ * UINT32_MAX if it never fits.
+ */
+static uint32_t RA02_duty_delay_ms(struct RA02 *const me, uint32_t airtime) {
+    uint32_t now = RA02_now_ms();
+    uint32_t used = 0U;
+
+    if (airtime > RA02_DUTY_BUDGET_MS) {
+        return UINT32_MAX;
+    }
+
+    RA02_duty_advance(me, now);
+    for (uint32_t i = 0U; i < RA02_DUTY_BUCKETS; i++) {
+        used += me->duty_bucket[i];
+    }
+
+    /* oldest buckets leave the window first */
+    for (uint32_t i = 1U; used + airtime > RA02_DUTY_BUDGET_MS; i++) {
+        used -= me->duty_bucket[(me->duty_epoch + i) % RA02_DUTY_BUCKETS];
+        if (used + airtime <= RA02_DUTY_BUDGET_MS) {
+            return (me->duty_epoch + i) * RA02_DUTY_BUCKET_MS - now;
+        }
+    }
+    return 0U;
+}
+
+static void RA02_duty_charge(struct RA02 *const me, uint32_t airtime) {
+    RA02_duty_advance(me, RA02_now_ms());
+    me->duty_bucket[me->duty_epoch % RA02_DUTY_BUCKETS] += airtime;
+}
+
+/*..........................................................................................*/
+/* retune when the target moved far enough, RX is restarted so the PLL relocks */
+static void RA02_afc_apply(struct RA02 *const me) {
+    if (!RA02_afc_retune(&me->afc)) {
+        return;
+    }
+    if (me->lora.current_mode == RXCONTIN_MODE) {
+        LoRa_gotoMode(&me->lora, STNBY_MODE);
+        LoRa_setFrequencyOffset(&me->lora, me->afc.applied_hz);
+        LoRa_startReceiving(&me->lora);
+    } else {
+        LoRa_setFrequencyOffset(&me->lora, me->afc.applied_hz);
+    }
+}
+
+/*..........................................................................................*/
+/*
+ * heard straight from its source: only then do RSSI, SNR and FEI belong to src and
+ * not to the relay. Adverts and beacons are never relayed, every other frame leaves
+ * its source with MESH_MAX_HOPS and loses one per relay.
+ */
+static bool RA02_one_hop(packet_view_t const *pkt) {
+    flags f = packet_view_flags(pkt);
+
+    return f.connected_nodes_info || f.beacon || packet_view_max_hops(pkt) == MESH_MAX_HOPS;
+}
+
+/* sent at the network power: ADR only trims frames for one receiver, see RA02_adr_apply */
+static bool RA02_full_power(packet_view_t const *pkt) {
+    return packet_view_next_hop(pkt) == MESH_BROADCAST_ID && packet_view_dest(pkt) == MESH_BROADCAST_ID;
+}
+
+/* one mesh frame, alone or out of an aggregate: neighbor table, AFC, beacons, router */
+static uint8_t RA02_receive_frame(struct RA02 *const me, LoRa_rxSlot const *slot, uint8_t const *wire,
+                                  uint8_t length) {
+    uint8_t frame[sizeof(packet_t)];
+    packet_view_t pkt;
+
+    /* corrupt frames say nothing reliable about their sender, drop them untouched */
+    if (packet_decode(&pkt, frame, wire, length) != PACKET_OK) {
+        return 0U;
+    }
+
+    if (RA02_one_hop(&pkt)
+        && neighbor_table_update(packet_view_src(&pkt), slot->status.rssi, slot->status.snr,
+                                 RA02_full_power(&pkt), RA02_now_ms())
+        && RA02_AFC && packet_view_dest(&pkt) == MESH_BROADCAST_ID) {
+        neighbor_table_carrier(packet_view_src(&pkt), RA02_afc_sample(&me->afc, slot->status.fei));
+    }
+    if (packet_view_flags(&pkt).beacon) {
+        if (me->mac_mode == RA02_MAC_TDMA && MESH_NODE_ID != RA02_TDMA_COORDINATOR_ID) {
+            RA02_tdma_read_beacon(&me->tdma, packet_view_payload(&pkt));
+            RA02_tdma_sync(&me->tdma, slot->timestamp, RA02_toa_us(me));
+            RA02_fhss_tune(me);
+        }
+        return 0U;
+    }
+    Router_post_frame(me->radio, frame);
+    return 1U;
+}
+
+/* drain the frames the DIO0 ISR took, feeding their RSSI/SNR to the neighbor table */
+static uint8_t RA02_receive(struct RA02 *const me) {
+    uint8_t received_frames = 0U;
+    LoRa_rxSlot *slot;
+
+    LoRa_rxRingFetch(&me->lora, &me->rx_ring);
+    while ((slot = LoRa_rxRingFront(&me->rx_ring)) != NULL) {
+        /* longer than any frame, and 0xA6 would read as wire version 2 */
+        if (slot->length > PACKET_WIRE_MAX && slot->data[0] == RA02_AGG_MAGIC) {
+            /* aggregate: [magic, (length, frame)...], a truncated tail is dropped */
+            for (uint8_t i = 1U; i < slot->length && slot->data[i] < slot->length - i; i += 1U + slot->data[i]) {
+                received_frames += RA02_receive_frame(me, slot, &slot->data[i + 1U], slot->data[i]);
+            }
+        } else {
+            received_frames += RA02_receive_frame(me, slot, slot->data,
+                                                  RA02_IMPLICIT_HEADER ? packet_wire_length(slot->data) : slot->length);
+        }
+        LoRa_rxRingPop(&me->rx_ring);
+    }
+    if (RA02_AFC) {
+        RA02_afc_apply(me);
+    }
+    return received_frames;
+}
+
+/*..........................................................................................*/
+/* per-packet link settings for the receiver of tx_buffer (next hop, else destination): SF and TX power (ADR), carrier (AFC) */
+static void RA02_adr_apply(struct RA02 *const me) {
+    neighbor_t link;
+    neighbor_t const *n = neighbor_table_find(me->tx_link, &link) ? &link : NULL;
+    RA02_adr_t adr;
+
+    RA02_adr_select(n, me->network_sf, &adr);
+
+    if (adr.sf != me->lora.spredingFactor) {
+        me->lora.spredingFactor = adr.sf;
+        LoRa_applyConfig(&me->lora);
+    }
+    LoRa_setPower(&me->lora, adr.power_dbm >= RA02_ADR_MAX_POWER_DBM
+                               ? me->network_power
+                               : POWER_PA_BOOST_DBM(adr.power_dbm));
+
+    /* land on the destination's carrier, broadcasts stay on the network average */
+    if (RA02_AFC && n != NULL && n->carrier != NEIGHBOR_CARRIER_UNKNOWN) {
+        LoRa_setFrequencyOffset(&me->lora, n->carrier);
+    }
+}
+
+/* back to the network SF so we hear everybody again */
+static void RA02_adr_restore(struct RA02 *const me) {
+    if (me->lora.spredingFactor != me->network_sf) {
+        me->lora.spredingFactor = me->network_sf;
+        LoRa_applyConfig(&me->lora);
+    }
+    if (RA02_AFC) {
+        LoRa_setFrequencyOffset(&me->lora, me->afc.applied_hz);
+    }
+}
+
+/*..........................................................................................*/
+/* the node that has to hear a frame: its next hop, else its destination */
+static uint8_t RA02_link_target(uint8_t const *frame) {
+    uint8_t next_hop = frame[offsetof(packet_t, next_hop)];
+
+    return next_hop != MESH_BROADCAST_ID ? next_hop : frame[offsetof(packet_t, dest_id)];
+}
+
+static uint8_t const ra02_txq_depth[RA02_TXQ_CLASSES] = {
+    RA02_TXQ_CONTROL_LEN, RA02_TXQ_INTERACTIVE_LEN, RA02_TXQ_BULK_LEN
+};
+static bool const ra02_txq_head_drop[RA02_TXQ_CLASSES] = {
+    RA02_TXQ_CONTROL_HEAD_DROP, RA02_TXQ_INTERACTIVE_HEAD_DROP, RA02_TXQ_BULK_HEAD_DROP
+};
+
+static RA02_txq_class_t RA02_txq_classify(uint8_t const *frame) {
+    packet_view_t const pkt = {.raw = frame};
+    flags const f = packet_view_flags(&pkt);
+
+    if ((f.ack && !f.requires_ack) || f.connected_nodes_info) {
+        return RA02_TXQ_CONTROL;
+    }
+    if (f.fragment || f.broadcasting) {
+        return RA02_TXQ_BULK;
+    }
+    return RA02_TXQ_INTERACTIVE;
+}
+
+/* entries of queue c in tx_buffer while it is on its way to the air (LBT, TX) */
+static uint8_t RA02_txq_busy(struct RA02 const *me, uint8_t c) {
+    DispatchHandler const state = me->super.dispatch;
+
+    if (me->tx_beacon || me->tx_class != c
+        || (state != RA02_CAD_MODE && state != RA02_BACKOFF_MODE && state != RA02_TX_MODE)) {
+        return 0U;
+    }
+    return me->tx_frames;
+}
+
+/* drop the i-th entry from the head, the ones behind it move up */
+static void RA02_txq_remove(RA02_txq_t *q, uint8_t i) {
+    for (; i + 1U < q->count; i++) {
+        uint8_t to = RA02_txq_at(q, i);
+        uint8_t from = RA02_txq_at(q, i + 1U);
+
+        memcpy(q->frame[to], q->frame[from], q->length[from]);
+        q->length[to] = q->length[from];
+        q->link[to] = q->link[from];
+        q->queued_ms[to] = q->queued_ms[from];
+    }
+    q->count--;
+    q->dropped++;
+}
+
+static void RA02_enqueue_tx(struct RA02 *const me, Event const *const e) {
+    RA02_TRANSMISSION_REQ_Event_t const *p = (RA02_TRANSMISSION_REQ_Event_t const *) e;
+    RA02_txq_class_t c = RA02_txq_classify(p->payload);
+    RA02_txq_t *q = &me->txq[c];
+    uint8_t wire[PACKET_WIRE_MAX];
+    uint8_t length = packet_encode(wire, p->payload);
+    uint8_t tail;
+
+    if (length == 0U) {
+        q->dropped++; /* flags the wire format has no kind for */
+        return;
+    }
+    if (q->count >= ra02_txq_depth[c]) {
+        uint8_t busy = RA02_txq_busy(me, c);
+
+        if (!ra02_txq_head_drop[c] || busy == q->count) {
+            q->dropped++;
+            return;
+        }
+        RA02_txq_remove(q, busy);
+    }
+    tail = RA02_txq_at(q, q->count);
+    memcpy(q->frame[tail], wire, length);
+    q->length[tail] = length;
+    q->link[tail] = RA02_link_target(p->payload);
+    q->queued_ms[tail] = RA02_now_ms();
+    q->count++;
+}
+
+/* entries of queue c from the head on that can share one LoRa frame */
+static uint8_t RA02_agg_run(struct RA02 *const me, uint8_t c) {
+    RA02_txq_t const *q = &me->txq[c];
+    uint8_t n = 1U;
+
+    if (!RA02_AGGREGATE || me->mac_mode == RA02_MAC_TDMA) {
+        return 1U;
+    }
+    while (n < q->count && q->link[RA02_txq_at(q, n)] == q->link[q->head]) {
+        n++;
+    }
+    return n;
+}
+
+/* copy the head of queue c into tx_buffer, aggregated with the 'count' entries behind it */
+static void RA02_tx_build(struct RA02 *const me, uint8_t c, uint8_t count) {
+    RA02_txq_t const *q = &me->txq[c];
+
+    me->tx_class = c;
+    me->tx_link = q->link[q->head];
+    me->tx_frames = count;
+    if (count == 1U) {
+        me->tx_length = q->length[q->head];
+        memcpy(me->tx_buffer, q->frame[q->head], me->tx_length);
+        return;
+    }
+
+    me->tx_buffer[0] = RA02_AGG_MAGIC;
+    me->tx_length = 1U;
+    for (uint8_t i = 0U; i < count; i++) {
+        uint8_t entry = RA02_txq_at(q, i);
+
+        me->tx_buffer[me->tx_length++] = q->length[entry];
+        memcpy(&me->tx_buffer[me->tx_length], q->frame[entry], q->length[entry]);
+        me->tx_length += q->length[entry];
+    }
+}
+
+/* nothing to send: listen, or under LPL put the radio to sleep until the next CAD */
+static void RA02_idle(struct RA02 *const me) {
+    if (me->mac_mode == RA02_MAC_LPL) {
+        LoRa_gotoMode(&me->lora, SLEEP_MODE);
+        TimeEvent_arm(&me->wake_te, RA02_LPL_WAKE_MS);
+        me->super.dispatch = RA02_SLEEP_MODE;
+    } else {
+        me->super.dispatch = RA02_ACTIVE_STATE;
+    }
+}
+
+/* LPL preamble: the wake interval plus the symbols a CAD needs, rounded up */
+static uint16_t RA02_lpl_preamble(LoRa const *lora) {
+    uint32_t tsym_us = LoRa_symbolTime(lora->spredingFactor, lora->bandWidth);
+    uint32_t symbols = (RA02_LPL_WAKE_MS * 1000UL + tsym_us - 1U) / tsym_us + 4U;
+
+    configASSERT(symbols <= UINT16_MAX);
+    return (uint16_t) symbols;
+}
+
+/* CadDone comes from the DIO0 ISR, te catches it never coming */
+static void RA02_cad_start(struct RA02 *const me) {
+    uint32_t tsym_us = LoRa_symbolTime(me->lora.spredingFactor, me->lora.bandWidth);
+
+    LoRa_startCAD(&me->lora);
+    TimeEvent_arm(&me->te, (RA02_CAD_TIMEOUT_SYMBOLS * tsym_us + 999UL) / 1000UL + RA02_TX_TIMEOUT_MARGIN_MS);
+}
+
+/* TDMA: wait for the own slot, or for the next beacon when this superframe has none left */
+static void RA02_tdma_schedule(struct RA02 *const me) {
+    uint32_t delay_us;
+
+    if (RA02_tdma_tx_delay_us(&me->tdma, MESH_NODE_ID, RA02_toa_us(me), timestamp_now_us(), &delay_us)) {
+        TimeEvent_arm(&me->slot_te, (delay_us + 999UL) / 1000UL);
+    }
+    me->super.dispatch = RA02_SLOT_MODE;
+}
+
+/*
+ * Start on the head of the queue whose turn it is: give it RA02_AGG_LATENCY_MS to
+ * collect frames for the same receiver, hold it back while the duty-cycle budget
+ * is spent, otherwise listen before talk.
+ */
+static void RA02_tx_next(Active *const me) {
+    struct RA02 *const ra = (struct RA02 *) me;
+    uint32_t delay;
+    uint8_t c;
+
+    while ((c = RA02_txq_pick(ra->txq, &ra->drr_turn)) < RA02_TXQ_CLASSES) {
+        RA02_txq_t const *q = &ra->txq[c];
+        uint8_t run = RA02_agg_run(ra, c);
+        uint32_t waited = RA02_now_ms() - q->queued_ms[q->head];
+
+        /* only worth waiting while nothing else queues up behind, control never waits */
+        if (RA02_AGGREGATE && ra->mac_mode != RA02_MAC_TDMA && c != RA02_TXQ_CONTROL
+            && run == RA02_txq_total(ra->txq) && run < ra02_txq_depth[c] && waited < RA02_AGG_LATENCY_MS) {
+            TimeEvent_arm(&ra->agg_te, RA02_AGG_LATENCY_MS - waited);
+            break;
+        }
+
+        RA02_tx_build(ra, c, run);
+        delay = RA02_duty_delay_ms(ra, RA02_tx_airtime_ms(ra));
+        if (delay == UINT32_MAX) {
+            /* longer than the whole duty-cycle budget, it would never go out */
+            ra->txq[c].dropped += ra->tx_frames;
+            RA02_txq_dequeue(ra->txq, c, ra->tx_frames);
+            continue;
+        }
+        if (delay > 0U) {
+            TimeEvent_arm(&ra->duty_te, delay);
+            me->dispatch = RA02_DEFER_MODE;
+            return;
+        }
+
+        TimeEvent_disarm(&ra->agg_te);
+        if (ra->mac_mode == RA02_MAC_TDMA) {
+            RA02_tdma_schedule(ra);
+            return;
+        }
+
+        ra->lbt_attempts = 0U;
+        RA02_cad_start(ra);
+        me->dispatch = RA02_CAD_MODE;
+        return;
+    }
+    RA02_idle(ra);
+}
 
 /*..........................................................................................*/
+/* (re)start the radio bring-up: hold it in reset for hold_ms, RA02_RESET_MODE goes on from there */
+static void RA02_reset(struct RA02 *const me, uint32_t hold_ms) {
+    me->is_initialized = false; /* the DIO ISRs leave it alone meanwhile */
+    LoRa_resetAssert(&me->lora);
+    TimeEvent_arm(&me->boot_te, hold_ms);
+    me->super.dispatch = RA02_RESET_MODE;
+}
 
 void IDLE(Active *const me, Event const *const e) {
     switch (e->sig) {
         case RA02_INIT_EVT: {
-            myLoRa = newLoRa();
+            struct RA02 *const ra = (struct RA02 *) me;
 
-            if (LoRa_Startup(&myLoRa) != NULL) {
-                me->dispatch = RA02_ACTIVE_STATE;
-            } else {
-                //TODO : handle failure
+            ra->lora = newLoRa();
+            ra->lora.headerMode = RA02_IMPLICIT_HEADER ? IMPLICIT_HEADER : EXPLICIT_HEADER;
+            ra->lora.payloadLength = PACKET_WIRE_MAX;
+            if (ra->mac_mode == RA02_MAC_LPL) {
+                ra->lora.preamble = RA02_lpl_preamble(&ra->lora);
             }
+            LoRa_attach(&ra->lora, ra->radio);
+            ra->lora.rxRing = &ra->rx_ring;
+
+            RA02_reset(ra, LORA_RESET_PULSE_MS);
+            break;
+        }
+    }
+}
+
+/*..........................................................................................*/
+/* radio bring-up, one step per TimeEvent so the other AOs keep running meanwhile */
+void RA02_RESET_MODE(Active *const me, Event const *const e) {
+    struct RA02 *const ra = (struct RA02 *) me;
+
+    switch (e->sig) {
+        case BOOT_TIMEOUT_EVT: {
+            LoRa_resetRelease(&ra->lora);
+            TimeEvent_arm(&ra->boot_te, LORA_RESET_READY_MS);
+            me->dispatch = RA02_BOOT_MODE;
+            break;
+        }
+
+        case TRANSMISSION_REQ_EVT: {
+            RA02_enqueue_tx(ra, e); /* sent once the radio is up */
+            break;
+        }
+    }
+}
+
+void RA02_BOOT_MODE(Active *const me, Event const *const e) {
+    struct RA02 *const ra = (struct RA02 *) me;
+
+    switch (e->sig) {
+        case BOOT_TIMEOUT_EVT: {
+            if (LoRa_init(&ra->lora) != LORA_OK) {
+                /* not answering, reset it again later */
+                RA02_reset(ra, RA02_BOOT_RETRY_MS);
+                break;
+            }
+            LoRa_startReceiving(&ra->lora);
+
+            ra->network_sf = ra->lora.spredingFactor;
+            ra->network_power = ra->lora.power;
+            ra->prng = LoRa_random(&ra->lora) | 1U;
+            RA02_tdma_init(&ra->tdma, RA02_toa_us(ra));
+            if (RA02_FHSS && RA02_FHSS_HOP_SYMBOLS != 0U) {
+                configASSERT(LoRa_radios[ra->radio].DIO2_pin != 0U);
+                LoRa_setHopPeriod(&ra->lora, RA02_FHSS_HOP_SYMBOLS);
+            }
+            RA02_fhss_tune(ra);
+            if (ra->mac_mode == RA02_MAC_TDMA && MESH_NODE_ID == RA02_TDMA_COORDINATOR_ID) {
+                TimeEvent_arm(&ra->beacon_te, 1U);
+            }
+            ra->is_initialized = true;
+            RA02_tx_next(me); /* what queued up during the bring-up */
+            break;
+        }
+
+        case TRANSMISSION_REQ_EVT: {
+            RA02_enqueue_tx(ra, e);
+            break;
         }
     }
 }
@@ -39,16 +633,29 @@ void RA02_ACTIVE_STATE(Active *const me, Event const *const e) {
     switch (e->sig) {
         case RECEIVED_TRANSMISSION_EVENT: {
             me->dispatch = RA02_RX_MODE;
+            RA02_RX_MODE(me, e);
             break;
         }
 
         case TRANSMISSION_REQ_EVT: {
-            RA02_TRANSMISSION_REQ_Event_t *p = (RA02_TRANSMISSION_REQ_Event_t *) e;
-            memset(tx_buffer, 0, sizeof(packet_t));
-            memcpy(tx_buffer, p->payload, sizeof(packet_t));
+            RA02_enqueue_tx((struct RA02 *) me, e);
+            RA02_tx_next(me);
+            break;
+        }
+
+        case BEACON_EVT: {
+            RA02_tdma_beacon((struct RA02 *) me);
+            break;
+        }
 
+        case HOP_EVT: {
+            RA02_fhss_tune((struct RA02 *) me);
+            break;
+        }
 
-            me->dispatch = RA02_TX_MODE;
+        case AGG_TIMEOUT_EVT: {
+            RA02_tx_next(me);
+            break;
         }
     }
 }
@@ -57,29 +664,402 @@ void RA02_ACTIVE_STATE(Active *const me, Event const *const e) {
 void RA02_RX_MODE(Active *const me, Event const *const e) {
     switch (e->sig) {
         case RECEIVED_TRANSMISSION_EVENT: {
-            uint8_t received_bytes = LoRa_receive(&myLoRa, &rx_buffer, sizeof(packet_t));
+            (void) RA02_receive((struct RA02 *) me);
+            RA02_tx_next(me);
+
+            break;
+        }
+
+        case TRANSMISSION_REQ_EVT: {
+            RA02_enqueue_tx((struct RA02 *) me, e);
+            break;
+        }
+    }
+}
+
+/* hand tx_buffer to the radio, TX_DONE_EVT comes from the DIO0 ISR */
+static void RA02_tx_start(struct RA02 *const me) {
+    uint32_t airtime;
+
+    if (RA02_IMPLICIT_HEADER) {
+        /* the receivers expect the configured payloadLength */
+        memset(&me->tx_buffer[me->tx_length], 0, PACKET_WIRE_MAX - me->tx_length);
+        me->tx_length = PACKET_WIRE_MAX;
+    }
+    RA02_adr_apply(me);
+    airtime = RA02_tx_airtime_ms(me);
+
+    RA02_duty_charge(me, airtime);
+    RA02_fhss_tune(me);
+    LoRa_startTransmit(&me->lora, me->tx_buffer, me->tx_length);
+    TimeEvent_arm(&me->te, airtime + RA02_TX_TIMEOUT_MARGIN_MS);
+    me->super.dispatch = RA02_TX_MODE;
+}
+
+/*..........................................................................................*/
+/* coordinator: send the beacon of the next superframe, in its slot 0 */
+static void RA02_tdma_beacon(struct RA02 *const me) {
+    flags beacon_flags = {0};
+    uint8_t slot_table[MESH_MAX_PAYLOAD] = {0};
+    uint8_t frame[sizeof(packet_t)];
+
+    if (me->super.dispatch == RA02_TX_MODE || RA02_duty_delay_ms(me, RA02_airtime_ms(me)) != 0U) {
+        /* skipped, the nodes stay silent until the next one */
+        TimeEvent_arm(&me->beacon_te, RA02_tdma_superframe_us(&me->tdma) / 1000UL);
+        return;
+    }
+
+    beacon_flags.broadcasting = 1U;
+    beacon_flags.beacon = 1U;
+    me->tdma.seq++; /* the superframe this beacon opens */
+    RA02_tdma_write_beacon(&me->tdma, slot_table);
+    (void) packet_write(frame, MESH_NODE_ID, MESH_BROADCAST_ID, beacon_flags, 0U, me->tdma.seq, slot_table);
+    me->tx_length = packet_encode(me->tx_buffer, frame);
+    me->tx_link = MESH_BROADCAST_ID;
+    me->tx_frames = 0U;
+    me->tx_beacon = true;
+    RA02_tx_start(me);
+}
+
+/* the beacon end starts the superframe clock, the next one is due a superframe later */
+static void RA02_tdma_beacon_done(struct RA02 *const me, bool sent) {
+    uint32_t next_us = RA02_tdma_superframe_us(&me->tdma);
+
+    if (sent) {
+        RA02_tdma_sync(&me->tdma, me->tx_done_us, RA02_toa_us(me));
+        next_us += (me->tdma.slot_us - RA02_toa_us(me)) / 2U; /* centred in slot 0 */
+        next_us -= timestamp_now_us() - me->tdma.start_us;
+        RA02_fhss_tune(me);
+    }
+    TimeEvent_arm(&me->beacon_te, next_us / 1000UL);
+}
+
+/*
+ * no TxDone or CadDone within the time it was due: the radio hangs, bring it up again.
+ * The frames stay queued and go out once it is back, a beacon is not resent.
+ */
+static void RA02_hang(struct RA02 *const me) {
+    me->dio0_timeouts++;
+    me->tx_beacon = false;
+    RA02_adr_restore(me);
+    RA02_reset(me, LORA_RESET_PULSE_MS);
+}
+
+/*
+ * back to RX continuous after a CAD or TX. An RxDone the ISR posted just before the
+ * radio left RX reaches CAD or TX mode, which cannot receive: LoRa_gotoMode fetched
+ * its frame on the way out, it is handled here.
+ */
+static void RA02_listen(struct RA02 *const me) {
+    LoRa_startReceiving(&me->lora);
+    (void) RA02_receive(me);
+}
+
+static void RA02_tx_end(struct RA02 *const me, bool sent) {
+    LoRa_clearIrqFlags(&me->lora, IRQ_TX_DONE);
+    RA02_adr_restore(me);
+    RA02_fhss_tune(me);
+    RA02_listen(me);
+
+    if (me->tx_beacon) {
+        me->tx_beacon = false;
+        RA02_tdma_beacon_done(me, sent);
+    } else {
+        RA02_txq_dequeue(me->txq, me->tx_class, me->tx_frames);
+    }
+    RA02_tx_next(&me->super);
+}
+
+void RA02_TX_MODE(Active *const me, Event const *const e) {
+    struct RA02 *const ra = (struct RA02 *) me;
+
+    switch (e->sig) {
+        case TX_DONE_EVT: {
+            TimeEvent_disarm(&ra->te);
+            ra->lora.current_mode = STNBY_MODE; /* the chip leaves TX by itself */
+            RA02_tx_end(ra, true);
+            break;
+        }
+
+        case BACKOFF_TIMEOUT_EVT: {
+            RA02_hang(ra); /* no TxDone within the airtime plus margin */
+            break;
+        }
 
-            if (received_bytes > (uint8_t) 0) {
-                //TODO : forward to router
-                me->dispatch = RA02_ACTIVE_STATE;
+        case TRANSMISSION_REQ_EVT: {
+            RA02_enqueue_tx(ra, e);
+            break;
+        }
+
+        case BEACON_EVT: {
+            RA02_tdma_beacon(ra);
+            break;
+        }
+    }
+}
+
+/*..........................................................................................*/
+void RA02_CAD_MODE(Active *const me, Event const *const e) {
+    struct RA02 *const ra = (struct RA02 *) me;
+
+    switch (e->sig) {
+        case CAD_DONE_EVT: {
+            uint8_t flags = LoRa_getIrqFlags(&ra->lora);
+            LoRa_clearIrqFlags(&ra->lora, IRQ_CAD_DONE | IRQ_CAD_DETECTED);
+            ra->lora.current_mode = STNBY_MODE; /* the chip leaves CAD by itself */
+            TimeEvent_disarm(&ra->te);
+
+            if ((flags & IRQ_CAD_DETECTED) == 0U) {
+                /* channel is clear */
+                RA02_tx_start(ra);
+                break;
+            }
+
+            RA02_listen(ra);
+            if (++ra->lbt_attempts >= RA02_LBT_MAX_ATTEMPTS) {
+                ra->txq[ra->tx_class].dropped += ra->tx_frames;
+                RA02_txq_dequeue(ra->txq, ra->tx_class, ra->tx_frames);
+                RA02_tx_next(me);
             } else {
-                //TODO : handle rx failure
+                TimeEvent_arm(&ra->te, RA02_backoff_ms(ra));
+                me->dispatch = RA02_BACKOFF_MODE;
             }
+            break;
+        }
+
+        case BACKOFF_TIMEOUT_EVT: {
+            RA02_hang(ra); /* no CadDone */
+            break;
+        }
 
+        case TRANSMISSION_REQ_EVT: {
+            RA02_enqueue_tx((struct RA02 *) me, e);
             break;
         }
     }
 }
 
-void RA02_TX_MODE(Active *const me, Event const *const e) {
-    if (LoRa_transmit(&myLoRa,
-        tx_buffer,
-        sizeof(packet_t),
-        TRANSMISSION_TIMEOUT)) {
-        me->dispatch = RA02_ACTIVE_STATE;
-    }else {
-        //TODO : handle failure
-        me->dispatch= RA02_ACTIVE_STATE;
+/*..........................................................................................*/
+/* channel was busy - keep receiving until the backoff expires, then CAD again */
+void RA02_BACKOFF_MODE(Active *const me, Event const *const e) {
+    switch (e->sig) {
+        case RECEIVED_TRANSMISSION_EVENT: {
+            (void) RA02_receive((struct RA02 *) me);
+            break;
+        }
+
+        case TRANSMISSION_REQ_EVT: {
+            RA02_enqueue_tx((struct RA02 *) me, e);
+            break;
+        }
+
+        case BACKOFF_TIMEOUT_EVT: {
+            RA02_cad_start((struct RA02 *) me);
+            me->dispatch = RA02_CAD_MODE;
+            break;
+        }
+    }
+}
+
+/*..........................................................................................*/
+/* airtime budget is spent - keep receiving until enough of it leaves the window */
+void RA02_DEFER_MODE(Active *const me, Event const *const e) {
+    switch (e->sig) {
+        case RECEIVED_TRANSMISSION_EVENT: {
+            (void) RA02_receive((struct RA02 *) me);
+            break;
+        }
+
+        case TRANSMISSION_REQ_EVT: {
+            RA02_enqueue_tx((struct RA02 *) me, e);
+            break;
+        }
+
+        case DUTY_TIMEOUT_EVT: {
+            RA02_tx_next(me);
+            break;
+        }
+
+        case BEACON_EVT: {
+            RA02_tdma_beacon((struct RA02 *) me);
+            break;
+        }
+
+        case HOP_EVT: {
+            RA02_fhss_tune((struct RA02 *) me);
+            break;
+        }
+    }
+}
+
+/*..........................................................................................*/
+/* TDMA: frames are queued, keep receiving until the own slot comes */
+void RA02_SLOT_MODE(Active *const me, Event const *const e) {
+    struct RA02 *const ra = (struct RA02 *) me;
+
+    switch (e->sig) {
+        case RECEIVED_TRANSMISSION_EVENT: {
+            (void) RA02_receive(ra);
+            RA02_tx_next(me); /* a beacon may have moved the slot */
+            break;
+        }
+
+        case TRANSMISSION_REQ_EVT: {
+            RA02_enqueue_tx(ra, e);
+            break;
+        }
+
+        case TDMA_SLOT_EVT: {
+            uint32_t delay_us;
+
+            /* the tick can be a little early or the AO late, only go while the slot lasts */
+            if (RA02_tdma_tx_delay_us(&ra->tdma, MESH_NODE_ID, RA02_toa_us(ra), timestamp_now_us(), &delay_us)
+                && delay_us < 1000UL) {
+                RA02_tx_build(ra, RA02_txq_pick(ra->txq, &ra->drr_turn), 1U);
+                RA02_tx_start(ra);
+            } else {
+                RA02_tx_next(me);
+            }
+            break;
+        }
+
+        case BEACON_EVT: {
+            RA02_tdma_beacon(ra);
+            break;
+        }
+
+        case HOP_EVT: {
+            RA02_fhss_tune(ra);
+            break;
+        }
+    }
+}
+
+/*..........................................................................................*/
+/* LPL: radio asleep, wake up for a CAD now and then */
+void RA02_SLEEP_MODE(Active *const me, Event const *const e) {
+    struct RA02 *const ra = (struct RA02 *) me;
+
+    switch (e->sig) {
+        case RECEIVED_TRANSMISSION_EVENT: {
+            (void) RA02_receive(ra); /* posted before the radio went to sleep, fetched on the way */
+            break;
+        }
+
+        case WAKE_EVT: {
+            RA02_cad_start(ra);
+            me->dispatch = RA02_SNIFF_MODE;
+            break;
+        }
+
+        case TRANSMISSION_REQ_EVT: {
+            TimeEvent_disarm(&ra->wake_te);
+            RA02_enqueue_tx(ra, e);
+            RA02_tx_next(me);
+            break;
+        }
+
+        case AGG_TIMEOUT_EVT: {
+            TimeEvent_disarm(&ra->wake_te);
+            RA02_tx_next(me);
+            break;
+        }
+    }
+}
+
+/* LPL: one CAD, a preamble on the air means a frame is coming */
+void RA02_SNIFF_MODE(Active *const me, Event const *const e) {
+    struct RA02 *const ra = (struct RA02 *) me;
+
+    switch (e->sig) {
+        case CAD_DONE_EVT: {
+            uint8_t flags = LoRa_getIrqFlags(&ra->lora);
+            LoRa_clearIrqFlags(&ra->lora, IRQ_CAD_DONE | IRQ_CAD_DETECTED);
+            ra->lora.current_mode = STNBY_MODE; /* the chip leaves CAD by itself */
+            TimeEvent_disarm(&ra->te);
+
+            if ((flags & IRQ_CAD_DETECTED) != 0U) {
+                /* the preamble may have just started, wait for all of it */
+                LoRa_startReceiving(&ra->lora);
+                TimeEvent_arm(&ra->wake_te, RA02_max_airtime_ms(ra) + RA02_TX_TIMEOUT_MARGIN_MS);
+                me->dispatch = RA02_LPL_RX_MODE;
+            } else {
+                RA02_tx_next(me);
+            }
+            break;
+        }
+
+        case BACKOFF_TIMEOUT_EVT: {
+            RA02_hang(ra); /* no CadDone */
+            break;
+        }
+
+        case TRANSMISSION_REQ_EVT: {
+            RA02_enqueue_tx(ra, e);
+            break;
+        }
+    }
+}
+
+/* LPL: woken by a preamble, receive the frame behind it or give up after one airtime */
+void RA02_LPL_RX_MODE(Active *const me, Event const *const e) {
+    struct RA02 *const ra = (struct RA02 *) me;
+
+    switch (e->sig) {
+        case RECEIVED_TRANSMISSION_EVENT: {
+            TimeEvent_disarm(&ra->wake_te);
+            (void) RA02_receive(ra);
+            RA02_tx_next(me);
+            break;
+        }
+
+        case WAKE_EVT: {
+            RA02_tx_next(me);
+            break;
+        }
+
+        case TRANSMISSION_REQ_EVT: {
+            RA02_enqueue_tx(ra, e);
+            break;
+        }
+    }
+}
+
+/*..........................................................................................*/
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+    uint32_t now = timestamp_now_us(); /* first, before any SPI traffic */
+    struct RA02 *const ra = ra02_by_exti[__builtin_ctz(GPIO_Pin)];
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    Event const *e;
+
+    if (ra02_by_dio2[__builtin_ctz(GPIO_Pin)] != NULL) {
+        struct RA02 *const hop = ra02_by_dio2[__builtin_ctz(GPIO_Pin)];
+
+        LoRa_hopChannel(&hop->lora, hop->fhss.channel, LORA_CH_COUNT, hop->fhss.pos);
+        return;
+    }
+
+    if (ra == NULL || !ra->is_initialized) {
+        return;
+    }
+
+    if (ra->lora.current_mode == CAD_MODE) {
+        e = &cadDoneEvt;
+    } else if (ra->lora.current_mode == TRANSMIT_MODE) {
+        ra->tx_done_us = now;
+        e = &txDoneEvt;
+    } else {
+        uint8_t received = LoRa_receiveToRing(&ra->lora, &ra->rx_ring, now);
+
+        if (RA02_FHSS && RA02_FHSS_HOP_SYMBOLS != 0U) {
+            (void) LoRa_setChannel(&ra->lora, ra->lora.channel); /* back from the last hop */
+        }
+        if (!received) {
+            return;
+        }
+        e = &rxDoneEvt; /* the frame's status is in the ring, the AO fetches the payload */
     }
 
+    Active_postFromISR(&ra->super, e, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
@@ -7,29 +7,131 @@
 #include <stdbool.h>
 
 #include "FreeAct.h"
-
-#define TRANSMISSION_TIMEOUT 300
-
-#define RA02_STACK_SIZE 128
+#include "packet_t.h"
+#include "LoRa/LoRa.h"
+#include "LoRa/LoRa_Startup.h"
+#include "ra-02_afc.h"
+#include "ra-02_fhss.h"
+#include "ra-02_tdma.h"
+#include "ra-02_txq.h"
+
+/* TX timeout is the packet time on air plus this margin (PLL lock, polling) */
+#define RA02_TX_TIMEOUT_MARGIN_MS 50U
+
+#define RA02_STACK_SIZE 256 /* StackType_t words per radio */
 #define RA02_PRIORITY 2
+#define RA02_QUEUE_LEN 10U
+#define RA02_BOOT_RETRY_MS 1000U /* next reset when the radio did not answer */
+
+/*
+ * Network-wide PHY header mode, every node of a network must agree on it.
+ * Implicit header mode drops the PHY header but needs a fixed length, so every
+ * frame is padded to PACKET_WIRE_MAX: worth it only when most frames are that
+ * long anyway. No aggregation then.
+ */
+#define RA02_IMPLICIT_HEADER 0
+
+/* medium access, see ra-02_tdma.h for the TDMA superframe */
+typedef enum {
+    RA02_MAC_ALOHA, /* listen before talk, at any time */
+    RA02_MAC_TDMA, /* only in the own slot of a beaconed superframe */
+    RA02_MAC_LPL /* ALOHA with the radio asleep, see RA02_LPL_WAKE_MS */
+} RA02_mac_mode_t;
+
+#define RA02_MAC_MODE RA02_MAC_ALOHA
+
+/*
+ * Low-power listening: the radio sleeps and wakes every RA02_LPL_WAKE_MS for one
+ * CAD. Every frame gets a preamble longer than the wake interval so a sleeping
+ * receiver always catches part of it. Shorter intervals cost the receivers more
+ * CADs, longer ones cost the senders airtime.
+ */
+#define RA02_LPL_WAKE_MS 1000U
+
+/* listen-before-talk: CAD before every TX, binary exponential backoff when busy */
+#define RA02_LBT_MAX_ATTEMPTS 6 /* CADs per TX request before it is dropped */
+#define RA02_LBT_MAX_BE 5 /* backoff window is capped at 2^5 slots */
+#define RA02_LBT_SLOT_MS 10
+/* CadDone is due two symbols after the CAD starts, past this many the radio hangs */
+#define RA02_CAD_TIMEOUT_SYMBOLS 8U
+
+/*
+ * Aggregation: consecutive frames of one queue for the same receiver (next hop, else
+ * destination) leave as one LoRa frame [RA02_AGG_MAGIC, (length, frame)...] and
+ * share one preamble and PHY header. The head of the queue waits up to
+ * RA02_AGG_LATENCY_MS for company. Needs the explicit header (variable length)
+ * and stays off under TDMA, whose slots fit one frame. Pays off on fragments, which
+ * queue together; frames arriving seconds apart rarely find company, see
+ * test/sim_agg.c.
+ */
+#define RA02_AGGREGATE 1
+#define RA02_AGG_MAGIC 0xA6U
+#define RA02_AGG_LATENCY_MS 100U
+#define RA02_AGG_MAX (1U + RA02_TX_QUEUE_LEN * (1U + PACKET_WIRE_MAX))
+
+/* duty-cycle limiter: airtime budget over a sliding window, kept in buckets */
+#define RA02_DUTY_WINDOW_MS 3600000UL /* 1 hour */
+#define RA02_DUTY_PERMILLE 10UL /* 1 % of the window */
+#define RA02_DUTY_BUCKETS 16U
+#define RA02_DUTY_BUCKET_MS (RA02_DUTY_WINDOW_MS / RA02_DUTY_BUCKETS)
+#define RA02_DUTY_BUDGET_MS (RA02_DUTY_WINDOW_MS * RA02_DUTY_PERMILLE / 1000UL)
 
 typedef enum {
     INIT_EVT = 2,
     RECEIVED_TRANSMISSION_EVENT,
     RX_DONE_EVT,
     TRANSMISSION_REQ_EVT,
-    TX_DONE_EVT
+    TX_DONE_EVT,
+    CAD_DONE_EVT,
+    BACKOFF_TIMEOUT_EVT,
+    DUTY_TIMEOUT_EVT,
+    TDMA_SLOT_EVT,
+    BEACON_EVT,
+    HOP_EVT,
+    WAKE_EVT,
+    BOOT_TIMEOUT_EVT,
+    AGG_TIMEOUT_EVT
 } RA_02_EventTypes;
 
-typedef struct RA02 {
+struct RA02 {
     Active super;
-    TimeEvent te;
+    uint8_t radio; /* index in LoRa_radios */
+    LoRa lora;
+    LoRa_rxRing rx_ring; /* filled by the DIO0 ISR, drained by the AO */
+    uint8_t tx_buffer[RA02_AGG_MAX];
+    uint8_t tx_length; /* bytes in tx_buffer */
+    uint8_t tx_frames; /* entries of txq[tx_class] in tx_buffer, dequeued once it is sent */
+    uint8_t tx_class;
+    uint8_t tx_link; /* receiver of tx_buffer, MESH_BROADCAST_ID for everybody */
+    RA02_txq_t txq[RA02_TXQ_CLASSES];
+    uint8_t drr_turn; /* class the DRR round is at */
+    TimeEvent agg_te; /* end of the aggregation wait */
+    TimeEvent te; /* LBT backoff timer, CadDone and TxDone watchdog */
     bool is_initialized;
+    uint8_t lbt_attempts; /* CADs done for the pending TX request */
+    uint32_t dio0_timeouts; /* TxDone or CadDone never came and the radio was brought up again */
+    uint32_t prng; /* xorshift state for the backoff, seeded from the radio */
+    TimeEvent duty_te; /* wakes the AO when enough airtime left the window */
+    uint32_t duty_bucket[RA02_DUTY_BUCKETS]; /* airtime [ms] spent per bucket */
+    uint32_t duty_epoch; /* index of the current bucket since boot */
+    uint8_t network_sf; /* SF every node listens on */
+    uint8_t network_power; /* RegPaConfig when ADR does not trim the power */
+    uint32_t tx_done_us; /* TxDone edge of the last frame sent, see timestamp.h */
+    RA02_mac_mode_t mac_mode;
+    RA02_tdma_t tdma;
+    TimeEvent slot_te; /* start of the own TDMA slot */
+    TimeEvent beacon_te; /* next beacon, coordinator only */
+    bool tx_beacon; /* tx_buffer holds a beacon, not queued frames */
+    RA02_fhss_t fhss;
+    TimeEvent hop_te; /* next TDMA slot boundary, FHSS only */
+    TimeEvent wake_te; /* LPL: next CAD while asleep, end of the RX window once woken */
+    TimeEvent boot_te; /* steps of the radio bring-up */
+    RA02_afc_t afc;
 };
 
 typedef struct {
     Event super;
-    uint8_t payload[14]; /*  should be the size of a packet_t   */
+    uint8_t payload[sizeof(packet_t)];
 } RA02_TRANSMISSION_REQ_Event_t;
 
 typedef struct {
@@ -44,7 +146,9 @@ typedef struct {
 
 typedef struct {
     Event super;
-    uint8_t payload[14]; /*  should be the size of a packet_t   */
+    uint32_t timestamp; /* us, RxDone edge, see timestamp.h */
+    LoRa_pktStatus status; /* RSSI, SNR, length and FEI, read with the frame */
+    uint8_t payload[sizeof(packet_t)];
 } RA02_RECEIVED_TRANSMISSION_Event_t;
 
 
@@ -57,6 +161,10 @@ typedef struct {
 
 void IDLE(Active *const me, Event const *const e);
 
+void RA02_RESET_MODE(Active *const me, Event const *const e);
+
+void RA02_BOOT_MODE(Active *const me, Event const *const e);
+
 
 void RA02_ACTIVE_STATE(Active *const me, Event const *const e);
 
@@ -64,10 +172,29 @@ void RA02_RX_MODE(Active *const me, Event const *const e);
 
 void RA02_TX_MODE(Active *const me, Event const *const e);
 
+void RA02_CAD_MODE(Active *const me, Event const *const e);
+
+void RA02_BACKOFF_MODE(Active *const me, Event const *const e);
+
+void RA02_DEFER_MODE(Active *const me, Event const *const e);
+
+void RA02_SLOT_MODE(Active *const me, Event const *const e);
+
+void RA02_SLEEP_MODE(Active *const me, Event const *const e);
+
+void RA02_SNIFF_MODE(Active *const me, Event const *const e);
+
+void RA02_LPL_RX_MODE(Active *const me, Event const *const e);
+
 
 /*...................................................................................*/
 
-void RA02_ctor(struct RA02 *const me);
+void RA02_ctor(struct RA02 *const me, uint8_t radio);
+
+/* constructs and starts one AO per radio of LoRa_radios and posts their init */
+void RA02_start(void);
+
+extern Active *const AO_RA02[LORA_RADIO_COUNT];
 
 
 #endif //RA_02_AO_H
@@ -0,0 +1,56 @@
+//
+// Created on 10/19/26.
+//
+
+#include "ra-02_adr.h"
+
+#include <stddef.h>
+
+/* SNR demodulation floor of SF7..SF12, dB * 16 (-7.5 dB .. -20 dB) */
+static const int16_t snr_floor[] = {-120, -160, -200, -240, -280, -320};
+
+/*..........................................................................................*/
+/*
+ * Pick the lowest SF that keeps RA02_ADR_MARGIN_DB above its SNR floor for the
+ * link to 'n', then spend the remaining headroom on TX power. The link is assumed
+ * symmetric: the SNR we measured on n's full-power frames is what n will see of
+ * ours at full power. Trimmed frames stay out of it, or every trim would lower the
+ * estimate the other end trims by and the two would chase each other.
+ * Unknown or barely heard neighbors get the network SF at full power.
+ */
+void RA02_adr_select(neighbor_t const *n, uint8_t network_sf, RA02_adr_t *out) {
+    int16_t headroom = -1;
+    uint8_t sf = network_sf;
+
+    out->sf = network_sf;
+    out->power_dbm = RA02_ADR_MAX_POWER_DBM;
+
+    if (n == NULL || n->link_count < RA02_ADR_MIN_FRAMES) {
+        return;
+    }
+
+#if RA02_ADR_ADAPT_SF
+    for (sf = RA02_ADR_MIN_SF; sf <= RA02_ADR_MAX_SF; sf++) {
+        headroom = (int16_t)(n->snr - snr_floor[sf - 7U] - RA02_ADR_MARGIN_DB * 16);
+        if (headroom >= 0) {
+            break;
+        }
+    }
+    if (sf > RA02_ADR_MAX_SF) {
+        out->sf = RA02_ADR_MAX_SF;
+        return;
+    }
+#else
+    headroom = (int16_t)(n->snr - snr_floor[sf - 7U] - RA02_ADR_MARGIN_DB * 16);
+    if (headroom < 0) {
+        return;
+    }
+#endif
+
+    out->sf = sf;
+    headroom /= 16;
+    if (headroom > (int16_t)(RA02_ADR_MAX_POWER_DBM - RA02_ADR_MIN_POWER_DBM)) {
+        headroom = (int16_t)(RA02_ADR_MAX_POWER_DBM - RA02_ADR_MIN_POWER_DBM);
+    }
+    out->power_dbm = (uint8_t)(RA02_ADR_MAX_POWER_DBM - headroom);
+}
@@ -0,0 +1,35 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef RA_02_ADR_H
+#define RA_02_ADR_H
+#include <stdint.h>
+
+#include "Mesh/neighbor_table.h"
+
+/* link margin kept above the demodulation floor of the chosen SF */
+#define RA02_ADR_MARGIN_DB 10
+/* full-power frames heard from a neighbor before its link estimate is trusted */
+#define RA02_ADR_MIN_FRAMES 3U
+
+#define RA02_ADR_MIN_SF 7U
+#define RA02_ADR_MAX_SF 12U
+#define RA02_ADR_MIN_POWER_DBM 2U
+#define RA02_ADR_MAX_POWER_DBM 17U
+
+/*
+ * An SX127x only demodulates the SF it listens on, so lowering the SF per packet
+ * needs receivers that follow the link SF (multi-SF gateway, SF agreed per slot).
+ * Off: ADR only trims TX power and every frame keeps the network SF.
+ */
+#define RA02_ADR_ADAPT_SF 0
+
+typedef struct {
+    uint8_t sf;
+    uint8_t power_dbm;
+} RA02_adr_t;
+
+void RA02_adr_select(neighbor_t const *n, uint8_t network_sf, RA02_adr_t *out);
+
+#endif //RA_02_ADR_H
@@ -0,0 +1,33 @@
+//
+// Created on 10/19/26.
+//
+
+#include "ra-02_afc.h"
+
+void RA02_afc_init(RA02_afc_t *afc) {
+    afc->hz = 0;
+    afc->applied_hz = 0;
+}
+
+/* the sender's carrier is the FEI measured on top of our own correction */
+int32_t RA02_afc_sample(RA02_afc_t *afc, int32_t fei_hz) {
+    int32_t carrier_hz = afc->applied_hz + fei_hz;
+
+    afc->hz += (carrier_hz - afc->hz) / (1L << RA02_AFC_SHIFT);
+    if (afc->hz > RA02_AFC_MAX_HZ) {
+        afc->hz = RA02_AFC_MAX_HZ;
+    } else if (afc->hz < -RA02_AFC_MAX_HZ) {
+        afc->hz = -RA02_AFC_MAX_HZ;
+    }
+    return carrier_hz;
+}
+
+bool RA02_afc_retune(RA02_afc_t *afc) {
+    int32_t diff = afc->hz - afc->applied_hz;
+
+    if (diff < RA02_AFC_STEP_HZ && diff > -RA02_AFC_STEP_HZ) {
+        return false;
+    }
+    afc->applied_hz = afc->hz;
+    return true;
+}
@@ -0,0 +1,36 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef RA_02_AFC_H
+#define RA_02_AFC_H
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * AFC: the synthesizer follows the average carrier of the neighbors, measured with
+ * FEI on their broadcast frames (unicast frames are pre-corrected for us and say
+ * nothing about the sender). Every node doing the same pulls the network onto one
+ * frequency; unicast frames go out on the carrier of their destination.
+ * FEI is read as the datasheet defines it, the received carrier minus our own:
+ * positive when the sender is above us. sx127x_sim reports it that way and
+ * test_afc checks the loop closes on an offset transmitter; should a chip report
+ * it negated, that test is where to flip it.
+ */
+#define RA02_AFC 1
+#define RA02_AFC_SHIFT 3 /* new sample weighs 1/8 */
+#define RA02_AFC_MAX_HZ 10000L /* ~23 ppm at 433 MHz */
+#define RA02_AFC_STEP_HZ 250L /* retune once the target moved that far */
+
+typedef struct {
+    int32_t hz; /* EWMA of the neighbors' carriers against our uncorrected synthesizer */
+    int32_t applied_hz; /* correction the synthesizer runs with */
+} RA02_afc_t;
+
+void RA02_afc_init(RA02_afc_t *afc);
+/* folds in one FEI, returns the sender's carrier against our uncorrected synthesizer */
+int32_t RA02_afc_sample(RA02_afc_t *afc, int32_t fei_hz);
+/* true when the average moved RA02_AFC_STEP_HZ away from applied_hz, which then takes it */
+bool RA02_afc_retune(RA02_afc_t *afc);
+
+#endif //RA_02_AFC_H
@@ -0,0 +1,37 @@
+//
+// Created on 10/19/26.
+//
+
+#include "ra-02_fhss.h"
+
+/*..........................................................................................*/
+/* Fisher-Yates over the channel plan, driven by xorshift32 so every node gets the same order */
+void RA02_fhss_init(RA02_fhss_t *me, uint32_t seed) {
+    uint32_t x = seed != 0U ? seed : 1U;
+
+    for (uint8_t i = 0U; i < LORA_CH_COUNT; i++) {
+        me->channel[i] = i;
+    }
+    for (uint8_t i = LORA_CH_COUNT - 1U; i > 0U; i--) {
+        uint8_t j;
+        uint8_t tmp;
+
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        j = (uint8_t) (x % (i + 1U));
+
+        tmp = me->channel[i];
+        me->channel[i] = me->channel[j];
+        me->channel[j] = tmp;
+    }
+    me->pos = 0U;
+}
+
+/* position in the sequence of 'slot' in 'superframe', consecutive slots on consecutive hops */
+uint8_t RA02_fhss_position(uint8_t superframe, uint8_t slot, uint8_t slot_count) {
+    if (slot == 0U) {
+        return 0U; /* beacons stay on the rendezvous channel */
+    }
+    return (uint8_t) (((uint32_t) superframe * slot_count + slot) % LORA_CH_COUNT);
+}
@@ -0,0 +1,37 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef RA_02_FHSS_H
+#define RA_02_FHSS_H
+#include <stdint.h>
+
+#include "LoRa/LoRa.h"
+
+/*
+ * Frequency hopping over the LORA_CH_COUNT channels of the plan. Sender and
+ * receiver have to agree on the channel, so hopping runs on the TDMA clock
+ * (RA02_MAC_TDMA): each slot of a superframe sits on the next channel of a
+ * pseudo-random sequence, slot 0 (the beacon) always on sequence[0] so that
+ * unsynchronised nodes know where to listen.
+ */
+#define RA02_FHSS 0
+#define RA02_FHSS_SEED 0x4C6F5261UL /* per network, gives the hop sequence */
+
+/*
+ * Intra-packet hopping on top, every RA02_FHSS_HOP_SYMBOLS symbols after the
+ * header (RegHopPeriod). Needs DIO2 (FhssChangeChannel) wired on every node of
+ * the network; 0 hops only between slots.
+ */
+#define RA02_FHSS_HOP_SYMBOLS 0U
+
+typedef struct {
+    uint8_t channel[LORA_CH_COUNT]; /* hop sequence, a permutation of the plan */
+    uint8_t pos; /* position in channel[] the radio is tuned to */
+} RA02_fhss_t;
+
+void RA02_fhss_init(RA02_fhss_t *me, uint32_t seed);
+
+uint8_t RA02_fhss_position(uint8_t superframe, uint8_t slot, uint8_t slot_count);
+
+#endif //RA_02_FHSS_H
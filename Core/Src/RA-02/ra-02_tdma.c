@@ -0,0 +1,86 @@
+//
+// Created on 10/19/26.
+//
+
+#include "ra-02_tdma.h"
+
+/*..........................................................................................*/
+/*
+ * Coordinator side: slot length for frames of 'toa_us'. The guard depends on the
+ * superframe length, which depends on the guard, so iterate a few times; it
+ * converges fast as long as the drift stays far below 1 / (2 * slot count).
+ */
+void RA02_tdma_init(RA02_tdma_t *me, uint32_t toa_us) {
+    uint32_t slot_us = toa_us + 2UL * RA02_TDMA_GUARD_MIN_US;
+    uint32_t guard_us;
+
+    for (uint8_t i = 0U; i < 4U; i++) {
+        guard_us = RA02_TDMA_GUARD_MIN_US +
+                   (uint32_t) ((uint64_t) slot_us * RA02_TDMA_SLOT_COUNT * RA02_TDMA_DRIFT_PPM / 1000000ULL);
+        slot_us = toa_us + 2UL * guard_us;
+    }
+
+    me->synced = false;
+    me->slot_count = RA02_TDMA_SLOT_COUNT;
+    me->seq = 0U;
+    me->slot_us = (slot_us + 999UL) / 1000UL * 1000UL; /* beaconed in ms */
+    me->start_us = 0U;
+}
+
+uint32_t RA02_tdma_superframe_us(RA02_tdma_t const *me) {
+    return me->slot_us * me->slot_count;
+}
+
+/*..........................................................................................*/
+/* beacon payload: slot count, slot length [ms] little endian, superframe number */
+void RA02_tdma_write_beacon(RA02_tdma_t const *me, uint8_t payload[MESH_MAX_PAYLOAD]) {
+    uint16_t slot_ms = (uint16_t) (me->slot_us / 1000UL);
+
+    payload[0] = me->slot_count;
+    payload[1] = (uint8_t) slot_ms;
+    payload[2] = (uint8_t) (slot_ms >> 8);
+    payload[3] = me->seq;
+    payload[4] = 0U;
+    payload[5] = 0U;
+}
+
+void RA02_tdma_read_beacon(RA02_tdma_t *me, uint8_t const payload[MESH_MAX_PAYLOAD]) {
+    me->slot_count = payload[0];
+    me->slot_us = ((uint32_t) payload[1] | ((uint32_t) payload[2] << 8)) * 1000UL;
+    me->seq = payload[3];
+}
+
+/*..........................................................................................*/
+/* the beacon ended at 'beacon_end_us' and was centred in slot 0 */
+void RA02_tdma_sync(RA02_tdma_t *me, uint32_t beacon_end_us, uint32_t toa_us) {
+    uint32_t guard_us = (me->slot_us - toa_us) / 2U;
+
+    me->start_us = beacon_end_us - toa_us - guard_us;
+    me->synced = me->slot_count > 1U && me->slot_us > toa_us;
+}
+
+static uint8_t RA02_tdma_slot_of(RA02_tdma_t const *me, uint8_t node_id) {
+    return (uint8_t) (1U + node_id % (me->slot_count - 1U));
+}
+
+/*
+ * Time until 'node_id' may start a frame in its slot of the last heard superframe: 0 if the
+ * slot is running and a frame started now still ends in it, false if the slot is
+ * over or the superframe is not known; the next beacon tells.
+ */
+bool RA02_tdma_tx_delay_us(RA02_tdma_t const *me, uint8_t node_id, uint32_t toa_us,
+                           uint32_t now_us, uint32_t *delay_us) {
+    uint32_t guard_us = (me->slot_us - toa_us) / 2U;
+    uint32_t elapsed_us = now_us - me->start_us;
+    uint32_t tx_us;
+
+    if (!me->synced) {
+        return false;
+    }
+    tx_us = RA02_tdma_slot_of(me, node_id) * me->slot_us + guard_us; /* since start_us */
+    if (elapsed_us > tx_us + guard_us) {
+        return false;
+    }
+    *delay_us = elapsed_us < tx_us ? tx_us - elapsed_us : 0U;
+    return true;
+}
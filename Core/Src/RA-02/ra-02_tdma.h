@@ -0,0 +1,52 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef RA_02_TDMA_H
+#define RA_02_TDMA_H
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "packet_t.h"
+
+/*
+ * Beacon-synchronised TDMA. The coordinator sends a beacon in slot 0 of every
+ * superframe with the slot count and length; node n owns slot 1 + n % (count - 1).
+ * Slots fit the longest frame (PACKET_WIRE_MAX), which is centred in its slot, so
+ * the guard on each side is (slot - time on air) / 2. Both ends take the end of the beacon
+ * (TxDone at the coordinator, RxDone at the nodes) as their time reference.
+ */
+#define RA02_TDMA_COORDINATOR_ID 0U /* node that beacons */
+#define RA02_TDMA_SLOT_COUNT 100U /* beacon airtime stays below the 1 % duty cycle */
+
+/*
+ * Guard time is the beacon jitter (one 1 ms TimeEvent tick plus ISR and SPI latency)
+ * plus the worst clock drift between two nodes over a whole superframe, since the
+ * clock is only re-synchronised by the next beacon. 1000 ppm covers two HSIs at
+ * the same temperature, boards with an HSE crystal can go down to ~50 ppm.
+ */
+#define RA02_TDMA_GUARD_MIN_US 1500UL
+#define RA02_TDMA_DRIFT_PPM 1000UL
+
+typedef struct {
+    bool synced; /* heard a beacon, start_us is valid */
+    uint8_t slot_count;
+    uint8_t seq; /* superframe number, counted by the coordinator */
+    uint32_t slot_us;
+    uint32_t start_us; /* local time the last heard superframe started */
+} RA02_tdma_t;
+
+void RA02_tdma_init(RA02_tdma_t *me, uint32_t toa_us);
+
+uint32_t RA02_tdma_superframe_us(RA02_tdma_t const *me);
+
+void RA02_tdma_write_beacon(RA02_tdma_t const *me, uint8_t payload[MESH_MAX_PAYLOAD]);
+
+void RA02_tdma_read_beacon(RA02_tdma_t *me, uint8_t const payload[MESH_MAX_PAYLOAD]);
+
+void RA02_tdma_sync(RA02_tdma_t *me, uint32_t beacon_end_us, uint32_t toa_us);
+
+bool RA02_tdma_tx_delay_us(RA02_tdma_t const *me, uint8_t node_id, uint32_t toa_us,
+                           uint32_t now_us, uint32_t *delay_us);
+
+#endif //RA_02_TDMA_H
@@ -0,0 +1,58 @@
+//
+// Created on 10/19/26.
+//
+
+#include "ra-02_txq.h"
+
+static int16_t const ra02_txq_quantum[RA02_TXQ_CLASSES] = {
+    0, RA02_TXQ_INTERACTIVE_QUANTUM, RA02_TXQ_BULK_QUANTUM /* control does not take part in the DRR */
+};
+
+uint8_t RA02_txq_at(RA02_txq_t const *q, uint8_t i) {
+    return (uint8_t) ((q->head + i) % RA02_TX_QUEUE_LEN);
+}
+
+uint8_t RA02_txq_total(RA02_txq_t const *txq) {
+    uint8_t n = 0U;
+
+    for (uint8_t c = 0U; c < RA02_TXQ_CLASSES; c++) {
+        n += txq[c].count;
+    }
+    return n;
+}
+
+void RA02_txq_dequeue(RA02_txq_t *txq, uint8_t c, uint8_t count) {
+    RA02_txq_t *q = &txq[c];
+
+    for (uint8_t i = 0U; i < count; i++) {
+        if (c != RA02_TXQ_CONTROL) {
+            q->deficit -= q->length[q->head];
+        }
+        q->head = RA02_txq_at(q, 1U);
+        q->count--;
+    }
+    if (q->count == 0U) {
+        q->deficit = 0; /* DRR: an idle queue saves no credit */
+    }
+}
+
+uint8_t RA02_txq_pick(RA02_txq_t *txq, uint8_t *turn) {
+    if (txq[RA02_TXQ_CONTROL].count > 0U) {
+        return RA02_TXQ_CONTROL;
+    }
+    if (RA02_txq_total(txq) == 0U) {
+        return RA02_TXQ_CLASSES;
+    }
+    for (;;) {
+        RA02_txq_t *q = &txq[*turn];
+
+        if (q->count > 0U && q->deficit >= (int16_t) q->length[q->head]) {
+            return *turn;
+        }
+        *turn = *turn + 1U < RA02_TXQ_CLASSES ? *turn + 1U : RA02_TXQ_CONTROL + 1U;
+        q = &txq[*turn];
+        if (q->count > 0U) {
+            q->deficit += ra02_txq_quantum[*turn];
+        }
+    }
+}
@@ -0,0 +1,63 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef RA_02_TXQ_H
+#define RA_02_TXQ_H
+#include <stdint.h>
+
+#include "packet_t.h"
+
+/*
+ * Pending TX requests, kept while LBT or the duty-cycle limiter hold the radio, in
+ * one queue per traffic class. Control frames (standalone ARQ acks, fragment status,
+ * route adverts) always go first so acks stay fast under load. Interactive (unicast
+ * data) and bulk (fragments, broadcast data) share the rest by deficit round robin,
+ * RA02_TXQ_*_QUANTUM bytes per round. A full queue refuses the new frame, or with
+ * head drop gives up its oldest one that is not on the air yet: stale telemetry is
+ * worth less than fresh.
+ */
+typedef enum {
+    RA02_TXQ_CONTROL,
+    RA02_TXQ_INTERACTIVE,
+    RA02_TXQ_BULK,
+    RA02_TXQ_CLASSES
+} RA02_txq_class_t;
+
+#define RA02_TX_QUEUE_LEN 4U /* slots per queue, no queue is deeper */
+#define RA02_TXQ_CONTROL_LEN 2U
+#define RA02_TXQ_INTERACTIVE_LEN 4U
+#define RA02_TXQ_BULK_LEN 4U
+#define RA02_TXQ_CONTROL_HEAD_DROP 0
+#define RA02_TXQ_INTERACTIVE_HEAD_DROP 0
+#define RA02_TXQ_BULK_HEAD_DROP 1
+#define RA02_TXQ_INTERACTIVE_QUANTUM (3U * PACKET_WIRE_MAX)
+#define RA02_TXQ_BULK_QUANTUM PACKET_WIRE_MAX
+
+typedef struct {
+    uint8_t frame[RA02_TX_QUEUE_LEN][PACKET_WIRE_MAX]; /* encoded for the air, head is the oldest */
+    uint8_t length[RA02_TX_QUEUE_LEN];
+    uint8_t link[RA02_TX_QUEUE_LEN]; /* receiver of each one, next hop else destination */
+    uint32_t queued_ms[RA02_TX_QUEUE_LEN];
+    uint8_t head;
+    uint8_t count;
+    int16_t deficit; /* DRR credit [bytes], an aggregate can overdraw it */
+    uint32_t dropped; /* queue full, no wire encoding, over the duty-cycle budget, channel never clear */
+} RA02_txq_t;
+
+/* slot of the i-th entry from the head */
+uint8_t RA02_txq_at(RA02_txq_t const *q, uint8_t i);
+
+/* entries queued over all RA02_TXQ_CLASSES queues of txq[] */
+uint8_t RA02_txq_total(RA02_txq_t const *txq);
+
+/* the 'count' entries at the head of queue c went out (or were given up), charged to its DRR credit */
+void RA02_txq_dequeue(RA02_txq_t *txq, uint8_t c, uint8_t count);
+
+/*
+ * queue to send from next: strict priority for control, deficit round robin for the
+ * others, *turn is the class the round is at. RA02_TXQ_CLASSES when all are empty.
+ */
+uint8_t RA02_txq_pick(RA02_txq_t *txq, uint8_t *turn);
+
+#endif //RA_02_TXQ_H
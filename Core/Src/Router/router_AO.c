@@ -0,0 +1,495 @@
+//
+// Created on 10/19/26.
+//
+
+#include "router_AO.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "Mesh/arq.h"
+#include "Mesh/dup_cache.h"
+#include "Mesh/frag.h"
+#include "Mesh/neighbor_table.h"
+#include "Mesh/route_table.h"
+
+static Router router;
+Active *const AO_Router = &router.super;
+
+/* every inbox and outbox slot and the fragmented message can have an event in flight, plus one per TimeEvent */
+_Static_assert(ROUTER_QUEUE_LEN >= LORA_RADIO_COUNT * ROUTER_INBOX_LEN + ROUTER_OUTBOX_LEN + 1U + ROUTER_PENDING_LEN + 2U,
+               "Router queue shorter than the inboxes");
+_Static_assert(ARQ_DATA_LEN + 2U <= MESH_MAX_PAYLOAD, "no room for the ARQ header");
+_Static_assert(ROUTER_ADVERT_MS * 9U / 8U * ((ROUTE_TABLE_SIZE + ROUTE_ADVERT_PAIRS - 1U) / ROUTE_ADVERT_PAIRS)
+               < ROUTE_MAX_AGE_MS, "routes age out before they are advertised again");
+_Static_assert(ROUTER_ADVERT_MS * 9U / 8U * ((ROUTE_TABLE_SIZE + ROUTE_ADVERT_PAIRS - 1U) / ROUTE_ADVERT_PAIRS)
+               <= ROUTE_HOLDDOWN_MS, "poisoned routes are freed before they are advertised");
+_Static_assert(ROUTER_PRIORITY < RA02_PRIORITY, "Router must run below the radios");
+
+static Event const *router_queue[ROUTER_QUEUE_LEN];
+static StackType_t router_stack[ROUTER_STACK_SIZE];
+
+static Router_deliverFn router_deliver;
+
+static Event const rxEvt = {ROUTER_RX_EVT};
+static Event const sendEvt = {ROUTER_SEND_EVT};
+
+/*..........................................................................................*/
+
+void Router_ctor(Router *const me) {
+    Active_ctor(&me->super, ROUTER_ACTIVE_STATE);
+    for (uint8_t i = 0U; i < ROUTER_PENDING_LEN; i++) {
+        TimeEvent_ctor(&me->pending[i].te, ROUTER_FORWARD_EVT, &me->super);
+        me->pending[i].req.super.sig = TRANSMISSION_REQ_EVT;
+        me->pending[i].busy = false;
+    }
+    TimeEvent_ctor(&me->advert_te, ROUTER_ADVERT_EVT, &me->super);
+    TimeEvent_ctor(&me->arq_te, ROUTER_ARQ_EVT, &me->super);
+    me->tx_req.super.sig = TRANSMISSION_REQ_EVT;
+    me->advert_cursor = 0U;
+    me->msg_id = 0U;
+    packet_msg_refs_init(&me->msg_refs);
+    /* nodes that hear the same frame must not pick the same slots */
+    me->prng = (MESH_NODE_ID * 2654435761UL) | 1UL;
+    me->delivered = 0U;
+    me->undelivered = 0U;
+    me->forwarded = 0U;
+    me->routed = 0U;
+    me->suppressed = 0U;
+    me->expired = 0U;
+}
+
+void Router_start(void) {
+    dup_cache_init();
+    route_table_init();
+    arq_init();
+    frag_init();
+    Router_ctor(&router);
+    Active_start(AO_Router,
+                 ROUTER_PRIORITY,
+                 (Event **) router_queue,
+                 ROUTER_QUEUE_LEN,
+                 router_stack,
+                 sizeof(router_stack),
+                 NULL);
+}
+
+void Router_set_delivery(Router_deliverFn deliver) {
+    router_deliver = deliver;
+}
+
+static uint32_t Router_now_ms(void) {
+    return (uint32_t) xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+/* called from the radio AO's thread, one producer per inbox */
+void Router_post_frame(uint8_t radio, uint8_t const *frame) {
+    Router_inbox *in = &router.inbox[radio];
+    uint8_t head = atomic_load_explicit(&in->head, memory_order_relaxed);
+    uint8_t tail = atomic_load_explicit(&in->tail, memory_order_acquire);
+
+    if ((uint8_t) (head - tail) >= ROUTER_INBOX_LEN) {
+        in->dropped++;
+        return;
+    }
+    memcpy(in->slot[head & (ROUTER_INBOX_LEN - 1U)].frame, frame, sizeof(packet_t));
+    atomic_store_explicit(&in->head, (uint8_t) (head + 1U), memory_order_release);
+    Active_post(AO_Router, &rxEvt);
+}
+
+/* called from the application's thread, the only producer of the outbox */
+bool Router_send_data(uint8_t dest, uint8_t const *data, bool reliable) {
+    Router_outbox *out = &router.outbox;
+    uint8_t head = atomic_load_explicit(&out->head, memory_order_relaxed);
+    uint8_t tail = atomic_load_explicit(&out->tail, memory_order_acquire);
+    Router_outboxSlot *slot;
+
+    if ((uint8_t) (head - tail) >= ROUTER_OUTBOX_LEN || (reliable && dest == MESH_BROADCAST_ID)) {
+        return false;
+    }
+    slot = &out->slot[head & (ROUTER_OUTBOX_LEN - 1U)];
+    slot->dest = dest;
+    slot->reliable = reliable;
+    memcpy(slot->data, data, reliable ? ARQ_DATA_LEN : MESH_MAX_PAYLOAD);
+    atomic_store_explicit(&out->head, (uint8_t) (head + 1U), memory_order_release);
+    Active_post(AO_Router, &sendEvt);
+    return true;
+}
+
+/* called from the application's thread, see Mesh/frag.h */
+bool Router_send_message(uint8_t dest, uint8_t const *data, uint16_t length) {
+    if (!frag_tx_start(dest, data, length, Router_now_ms())) {
+        return false;
+    }
+    Active_post(AO_Router, &sendEvt);
+    return true;
+}
+
+/*..........................................................................................*/
+/* xorshift32 */
+static uint32_t Router_random(Router *const me) {
+    uint32_t x = me->prng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    me->prng = x;
+    return x;
+}
+
+static Router_pending *Router_find_pending(Router *const me, uint8_t src_id, uint16_t msg_id) {
+    for (uint8_t i = 0U; i < ROUTER_PENDING_LEN; i++) {
+        Router_pending *p = &me->pending[i];
+
+        if (p->busy && p->src_id == src_id && p->msg_id == msg_id) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+/* a copy of a frame we already handled: count it against its pending rebroadcast */
+static void Router_overheard(Router *const me, uint8_t src_id, uint16_t msg_id) {
+    Router_pending *p = Router_find_pending(me, src_id, msg_id);
+
+    if (p != NULL && ++p->copies >= ROUTER_SUPPRESS_COPIES) {
+        TimeEvent_disarm(&p->te);
+        p->busy = false;
+        me->suppressed++;
+    }
+}
+
+/* a flood leaves on every radio, each one copies the request right away */
+static void Router_send(RA02_TRANSMISSION_REQ_Event_t const *req) {
+    for (uint8_t i = 0U; i < LORA_RADIO_COUNT; i++) {
+        Active_post(AO_RA02[i], &req->super);
+    }
+}
+
+/*
+ * Pass 'pkt' on with one hop less: to 'next_hop' right away, or flooded
+ * (MESH_BROADCAST_ID) in a random slot.
+ */
+static void Router_forward(Router *const me, packet_view_t const *pkt, uint8_t next_hop) {
+    Router_pending *p = NULL;
+
+    for (uint8_t i = 0U; i < ROUTER_PENDING_LEN && p == NULL; i++) {
+        if (!me->pending[i].busy) {
+            p = &me->pending[i];
+        }
+    }
+    if (p == NULL) {
+        return; /* all slots taken, the neighbors still carry the flood */
+    }
+
+    (void) packet_write(p->req.payload,
+                        packet_view_src(pkt),
+                        packet_view_dest(pkt),
+                        packet_view_flags(pkt),
+                        (uint8_t) (packet_view_max_hops(pkt) - 1U),
+                        packet_view_msg_id(pkt),
+                        packet_view_payload(pkt));
+
+    if (next_hop != MESH_BROADCAST_ID) {
+        packet_set_next_hop(p->req.payload, next_hop);
+        Router_send(&p->req);
+        me->routed++;
+        return;
+    }
+
+    p->src_id = packet_view_src(pkt);
+    p->msg_id = packet_view_msg_id(pkt);
+    p->copies = 1U;
+    p->busy = true;
+    TimeEvent_arm(&p->te, (Router_random(me) % ROUTER_JITTER_SLOTS + 1U) * ROUTER_JITTER_SLOT_MS);
+}
+
+/* a frame of our own, hop by hop when we know a route to dest, else flooded */
+static void Router_originate(Router *const me, uint8_t dest, flags f, uint8_t max_hops, uint8_t const *payload) {
+    if (dest == MESH_BROADCAST_ID) {
+        f.broadcasting = 1U;
+    } else {
+        f.needs_forwarding = 1U; /* relays may flood it when their route is gone */
+    }
+    (void) packet_write(me->tx_req.payload, MESH_NODE_ID, dest, f, max_hops, me->msg_id++, payload);
+    if (dest != MESH_BROADCAST_ID) {
+        packet_set_next_hop(me->tx_req.payload, route_table_next_hop(dest, Router_now_ms()));
+    }
+    Router_send(&me->tx_req);
+}
+
+/* our routes, one hop far; the next one after ROUTER_ADVERT_MS plus jitter */
+static void Router_advert(Router *const me) {
+    flags advert_flags = {0};
+    uint8_t pairs[MESH_MAX_PAYLOAD];
+
+    advert_flags.connected_nodes_info = 1U;
+    route_table_advert_tx(pairs, &me->advert_cursor, Router_now_ms());
+    Router_originate(me, MESH_BROADCAST_ID, advert_flags, 0U, pairs);
+
+    TimeEvent_arm(&me->advert_te, ROUTER_ADVERT_MS + Router_random(me) % (ROUTER_ADVERT_MS / 8U));
+}
+
+static void Router_deliver(Router *const me, uint8_t src_id, uint8_t const *data, uint16_t length) {
+    me->delivered++;
+    if (router_deliver == NULL) {
+        me->undelivered++;
+        return;
+    }
+    router_deliver(src_id, data, length);
+}
+
+/*..........................................................................................*/
+/* ARQ, see Mesh/arq.h */
+
+/* data frame 'seq' of p, with the ack of the opposite direction piggybacked */
+static void Router_arq_data(Router *const me, arq_peer_t *p, uint8_t seq, uint32_t now) {
+    flags f = {0};
+    uint8_t payload[MESH_MAX_PAYLOAD];
+    uint32_t map;
+
+    f.requires_ack = 1U;
+    f.ack = 1U;
+    f.syn = p->tx_synced ? 0U : 1U;
+    payload[0] = seq;
+    arq_ack_take(p, &payload[1], &map);
+    if (map != 0U) {
+        p->ack_pending = true; /* holes, the map follows in a standalone ACK */
+    }
+    memcpy(&payload[2], p->tx[seq % ARQ_WINDOW].data, ARQ_DATA_LEN);
+    Router_originate(me, p->peer, f, MESH_MAX_HOPS, payload);
+    arq_tx_sent(p, seq, now);
+}
+
+/* standalone ACK: [cumulative ack, map LSB first, 0] */
+static void Router_arq_ack(Router *const me, arq_peer_t *p) {
+    flags f = {0};
+    uint8_t payload[MESH_MAX_PAYLOAD] = {0};
+    uint32_t map;
+
+    f.ack = 1U;
+    arq_ack_take(p, &payload[0], &map);
+    for (uint8_t i = 0U; i < 4U; i++) {
+        payload[1U + i] = (uint8_t) (map >> (8U * i));
+    }
+    Router_originate(me, p->peer, f, MESH_MAX_HOPS, payload);
+}
+
+/* move the application's messages into the ARQ windows, in order; stops at the first that does not fit */
+static void Router_drain_outbox(Router *const me, uint32_t now) {
+    Router_outbox *out = &me->outbox;
+    uint8_t tail = atomic_load_explicit(&out->tail, memory_order_relaxed);
+
+    while (tail != atomic_load_explicit(&out->head, memory_order_acquire)) {
+        Router_outboxSlot const *m = &out->slot[tail & (ROUTER_OUTBOX_LEN - 1U)];
+
+        if (m->reliable) {
+            arq_peer_t *p = arq_find(m->dest, true, now);
+            uint8_t seq;
+
+            if (p == NULL || !arq_tx_push(p, m->data, &seq, now)) {
+                break; /* window full, retried once acks come in */
+            }
+        } else {
+            flags f = {0};
+
+            Router_originate(me, m->dest, f, MESH_MAX_HOPS, m->data);
+        }
+        tail++;
+        atomic_store_explicit(&out->tail, tail, memory_order_release);
+    }
+}
+
+/* fragments and status frames that are due, see Mesh/frag.h */
+static void Router_frag_run(Router *const me, uint32_t now) {
+    flags f = {0};
+    uint8_t payload[MESH_MAX_PAYLOAD];
+    uint8_t dest;
+
+    f.fragment = 1U;
+    while (frag_tx_next(&dest, payload, now)) {
+        Router_originate(me, dest, f, MESH_MAX_HOPS, payload);
+    }
+    f.ack = 1U;
+    while (frag_status_take(&dest, payload, now)) {
+        Router_originate(me, dest, f, MESH_MAX_HOPS, payload);
+    }
+}
+
+/* send whatever is due, ARQ and fragments, then sleep until the next deadline */
+static void Router_arq_run(Router *const me) {
+    uint32_t now = Router_now_ms();
+    uint32_t next;
+    uint32_t frag_next;
+
+    Router_drain_outbox(me, now);
+    for (uint8_t i = 0U; i < ARQ_PEERS; i++) {
+        arq_peer_t *p = arq_at(i);
+        uint8_t seq;
+
+        if (p == NULL) {
+            continue;
+        }
+        while (arq_tx_due(p, &seq, now)) {
+            Router_arq_data(me, p, seq, now);
+        }
+        if (p->ack_pending && (int32_t) (now - p->ack_due) >= 0) {
+            Router_arq_ack(me, p);
+        }
+    }
+
+    Router_frag_run(me, now);
+
+    next = arq_next_deadline(now);
+    frag_next = frag_next_deadline(now);
+    if (frag_next < next) {
+        next = frag_next;
+    }
+    TimeEvent_disarm(&me->arq_te);
+    if (next != UINT32_MAX) {
+        TimeEvent_arm(&me->arq_te, next > 0U ? next : 1U);
+    }
+}
+
+/* a fragment or a status frame for us */
+static void Router_frag_rx(Router *const me, packet_view_t const *pkt, uint32_t now) {
+    frag_rx_t const *m;
+
+    if (packet_view_flags(pkt).ack) {
+        frag_tx_status(packet_view_src(pkt), packet_view_payload(pkt), now);
+    } else if ((m = frag_rx(packet_view_src(pkt), packet_view_payload(pkt), now)) != NULL) {
+        Router_deliver(me, m->src, m->data, m->length);
+    }
+    Router_arq_run(me);
+}
+
+/* a unicast frame for us: acks feed our windows, data is delivered once */
+static void Router_arq_rx(Router *const me, packet_view_t const *pkt, uint32_t now) {
+    flags f = packet_view_flags(pkt);
+    uint8_t const *payload = packet_view_payload(pkt);
+    arq_peer_t *p;
+
+    if (!f.requires_ack && !f.ack) {
+        Router_deliver(me, packet_view_src(pkt), payload, MESH_MAX_PAYLOAD);
+        return;
+    }
+
+    p = arq_find(packet_view_src(pkt), f.requires_ack, now);
+    if (p == NULL) {
+        return; /* an ack for a peer we forgot, or no room to ack: the sender retries */
+    }
+    if (f.requires_ack) {
+        if (f.ack) {
+            arq_rx_ack(p, payload[1], 0U, now);
+        }
+        if (arq_rx_data(p, payload[0], f.syn, now)) {
+            Router_deliver(me, packet_view_src(pkt), &payload[2], ARQ_DATA_LEN);
+        }
+    } else {
+        arq_rx_ack(p, payload[0],
+                   (uint32_t) payload[1] | ((uint32_t) payload[2] << 8)
+                   | ((uint32_t) payload[3] << 16) | ((uint32_t) payload[4] << 24),
+                   now);
+    }
+    Router_arq_run(me);
+}
+
+/* one frame from a radio, already checked by packet_decode there */
+static void Router_handle(Router *const me, uint8_t *frame) {
+    packet_view_t const pkt = {.raw = frame};
+    uint8_t dest = packet_view_dest(&pkt);
+    uint8_t next_hop = packet_view_next_hop(&pkt);
+    uint32_t now = Router_now_ms();
+
+    if (packet_view_src(&pkt) == MESH_NODE_ID) {
+        return; /* our own frame, rebroadcast by a neighbor */
+    }
+    /* the wire carried the low byte only */
+    packet_set_msg_id(frame, packet_msg_id_expand(&me->msg_refs, packet_view_src(&pkt),
+                                                  (uint8_t) packet_view_msg_id(&pkt)));
+    if (dup_cache_check(packet_view_src(&pkt), packet_view_msg_id(&pkt), now)) {
+        Router_overheard(me, packet_view_src(&pkt), packet_view_msg_id(&pkt));
+        return;
+    }
+
+    if (packet_view_flags(&pkt).connected_nodes_info) {
+        neighbor_t link;
+        bool heard = neighbor_table_find(packet_view_src(&pkt), &link);
+
+        route_table_advert_rx(packet_view_src(&pkt), neighbor_table_cost(heard ? &link : NULL, now),
+                              packet_view_payload(&pkt), now);
+        return;
+    }
+
+    if (dest == MESH_NODE_ID) {
+        if (packet_view_flags(&pkt).fragment) {
+            Router_frag_rx(me, &pkt, now);
+            return;
+        }
+        Router_arq_rx(me, &pkt, now);
+        return;
+    }
+    if (dest == MESH_BROADCAST_ID) {
+        Router_deliver(me, packet_view_src(&pkt), packet_view_payload(&pkt), MESH_MAX_PAYLOAD);
+    }
+    /* unicast: ours to relay when we are its next hop, or when it is flooded (every unicast frame may be) */
+    if (dest != MESH_BROADCAST_ID && next_hop != MESH_BROADCAST_ID && next_hop != MESH_NODE_ID) {
+        return;
+    }
+    if (packet_view_max_hops(&pkt) == 0U) {
+        me->expired++;
+        return;
+    }
+    /* with a route the frame goes hop by hop from here on, else it keeps flooding */
+    Router_forward(me, &pkt, dest == MESH_BROADCAST_ID ? MESH_BROADCAST_ID : route_table_next_hop(dest, now));
+}
+
+/*..........................................................................................*/
+
+void ROUTER_ACTIVE_STATE(Active *const me, Event const *const e) {
+    Router *const r = (Router *) me;
+
+    switch (e->sig) {
+        case INIT_SIG: {
+            TimeEvent_arm(&r->advert_te, ROUTER_ADVERT_MS / 8U + Router_random(r) % (ROUTER_ADVERT_MS / 8U));
+            break;
+        }
+
+        case ROUTER_RX_EVT: {
+            for (uint8_t i = 0U; i < LORA_RADIO_COUNT; i++) {
+                Router_inbox *in = &r->inbox[i];
+                uint8_t tail = atomic_load_explicit(&in->tail, memory_order_relaxed);
+
+                while (tail != atomic_load_explicit(&in->head, memory_order_acquire)) {
+                    Router_handle(r, in->slot[tail & (ROUTER_INBOX_LEN - 1U)].frame);
+                    tail++;
+                    atomic_store_explicit(&in->tail, tail, memory_order_release);
+                }
+            }
+            break;
+        }
+
+        case ROUTER_FORWARD_EVT: {
+            Router_pending *p = (Router_pending *) e; /* the TimeEvent is its first member */
+
+            /* suppressed after the timer already posted */
+            if (!p->busy) {
+                break;
+            }
+            Router_send(&p->req);
+            p->busy = false;
+            r->forwarded++;
+            break;
+        }
+
+        case ROUTER_ADVERT_EVT: {
+            Router_advert(r);
+            break;
+        }
+
+        case ROUTER_SEND_EVT:
+        case ROUTER_ARQ_EVT: {
+            Router_arq_run(r);
+            break;
+        }
+    }
+}
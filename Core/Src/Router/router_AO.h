@@ -0,0 +1,146 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef ROUTER_AO_H
+#define ROUTER_AO_H
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeAct.h"
+#include "packet_t.h"
+#include "LoRa/LoRa_Startup.h"
+#include "RA-02/ra-02_AO.h"
+
+/*
+ * Below the radios on purpose: a radio AO is always blocked on an empty queue
+ * while the router runs, so a TRANSMISSION_REQ_EVT posted to it is copied into
+ * its TX queues before Active_post returns and the event can live in a reused slot.
+ */
+#define ROUTER_PRIORITY 1
+#define ROUTER_STACK_SIZE 256 /* StackType_t words */
+#define ROUTER_QUEUE_LEN 28U
+
+/* frames handed over by the radios, per radio, power of two */
+#define ROUTER_INBOX_LEN 8U
+/* messages handed over by the application, power of two */
+#define ROUTER_OUTBOX_LEN 4U
+
+/*
+ * Flooding: every new frame that still has hops left is rebroadcast once, after a
+ * random number of slots so neighbors that heard the same frame do not collide.
+ * A node that overhears ROUTER_SUPPRESS_COPIES copies while it waits stays quiet,
+ * its neighborhood is covered already.
+ */
+#define ROUTER_PENDING_LEN 6U /* rebroadcasts waiting for their slot */
+#define ROUTER_JITTER_SLOTS 8U
+#define ROUTER_JITTER_SLOT_MS 60U /* one PACKET_WIRE_MAX SF7 frame plus CAD and turnaround */
+#define ROUTER_SUPPRESS_COPIES 4U /* 3 costs sparse meshes a tenth of their delivery, see test/sim_flood.c */
+
+/*
+ * Route adverts (connected_nodes_info, one hop), see Mesh/route_table.h. A full
+ * table takes ROUTE_TABLE_SIZE / ROUTE_ADVERT_PAIRS adverts, that has to fit in
+ * ROUTE_MAX_AGE_MS. Up to 1/8 of jitter keeps neighbors from staying in step.
+ */
+#define ROUTER_ADVERT_MS 20000UL
+
+typedef enum {
+    ROUTER_RX_EVT = USER_SIG,
+    ROUTER_FORWARD_EVT,
+    ROUTER_ADVERT_EVT,
+    ROUTER_SEND_EVT,
+    ROUTER_ARQ_EVT
+} Router_EventTypes;
+
+typedef struct {
+    uint8_t frame[sizeof(packet_t)];
+} Router_inboxSlot;
+
+/* single producer (one radio AO) / single consumer (router) */
+typedef struct {
+    Router_inboxSlot slot[ROUTER_INBOX_LEN];
+    _Atomic uint8_t head;
+    _Atomic uint8_t tail;
+    uint32_t dropped;
+} Router_inbox;
+
+typedef struct {
+    uint8_t dest;
+    bool reliable;
+    uint8_t data[MESH_MAX_PAYLOAD];
+} Router_outboxSlot;
+
+/* single producer (the application) / single consumer (router) */
+typedef struct {
+    Router_outboxSlot slot[ROUTER_OUTBOX_LEN];
+    _Atomic uint8_t head;
+    _Atomic uint8_t tail;
+} Router_outbox;
+
+/*
+ * a message for this node, called from the router's thread: data is only valid
+ * during the call, copy what is kept and do not block, the radios wait meanwhile.
+ * length is MESH_MAX_PAYLOAD, ARQ_DATA_LEN for reliable data, up to FRAG_MAX_LEN
+ * for a fragmented message.
+ */
+typedef void (*Router_deliverFn)(uint8_t src, uint8_t const *data, uint16_t length);
+
+/* one rebroadcast waiting for its slot, the TX request is built in place */
+typedef struct {
+    TimeEvent te;
+    RA02_TRANSMISSION_REQ_Event_t req;
+    uint8_t src_id;
+    uint16_t msg_id;
+    uint8_t copies; /* copies heard, the first one included */
+    bool busy;
+} Router_pending;
+
+typedef struct Router {
+    Active super;
+    Router_inbox inbox[LORA_RADIO_COUNT];
+    Router_outbox outbox;
+    Router_pending pending[ROUTER_PENDING_LEN];
+    RA02_TRANSMISSION_REQ_Event_t tx_req; /* frames the router originates */
+    TimeEvent advert_te;
+    TimeEvent arq_te; /* next retransmission, standalone ACK, fragment or fragment status */
+    uint8_t advert_cursor; /* next route table entry to advertise */
+    uint16_t msg_id; /* of the frames the router originates */
+    packet_msg_refs_t msg_refs; /* of the frames it hears, for both radios */
+    uint32_t prng; /* xorshift state for the rebroadcast jitter */
+    uint32_t delivered; /* messages for this node */
+    uint32_t undelivered; /* of them, with no Router_deliverFn set */
+    uint32_t forwarded; /* flooded */
+    uint32_t routed; /* unicast, hop by hop */
+    uint32_t suppressed;
+    uint32_t expired; /* no hops left */
+} Router;
+
+void ROUTER_ACTIVE_STATE(Active *const me, Event const *const e);
+
+void Router_ctor(Router *const me);
+
+void Router_start(void);
+
+/* application side: where messages for this node go, set before Router_start */
+void Router_set_delivery(Router_deliverFn deliver);
+
+/* radio AO side: hand over a valid, non-beacon frame heard on 'radio' */
+void Router_post_frame(uint8_t radio, uint8_t const *frame);
+
+/*
+ * application side, one task: send data to dest (MESH_BROADCAST_ID for everybody).
+ * Reliable messages carry ARQ_DATA_LEN bytes and are retried until acked, the
+ * others MESH_MAX_PAYLOAD. False while the outbox is full.
+ */
+bool Router_send_data(uint8_t dest, uint8_t const *data, bool reliable);
+
+/*
+ * application side, same task: send a message of up to FRAG_MAX_LEN bytes to dest,
+ * fragmented, see Mesh/frag.h. One at a time, false while the last one is in flight.
+ */
+bool Router_send_message(uint8_t dest, uint8_t const *data, uint16_t length);
+
+extern Active *const AO_Router;
+
+#endif //ROUTER_AO_H
@@ -23,7 +23,9 @@
 #include "spi.h"
 #include "usart.h"
 #include "gpio.h"
-#include "LoRa/LoRa_Startup.h"
+#include "RA-02/ra-02_AO.h"
+#include "Router/router_AO.h"
+#include "timestamp.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 
@@ -96,7 +98,9 @@ int main(void)
   MX_USART2_UART_Init();
   MX_USART3_UART_Init();
   /* USER CODE BEGIN 2 */
-  LoRa_Startup();
+  timestamp_init();
+  Router_start();
+  RA02_start(); /* radios are brought up by their AOs once the scheduler runs */
 
   /* USER CODE END 2 */
 
@@ -178,6 +182,10 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
     HAL_IncTick();
   }
   /* USER CODE BEGIN Callback 1 */
+  if (htim->Instance == TIM3)
+  {
+    (void) timestamp_now_us(); /* keeps up with CYCCNT wrapping */
+  }
 
   /* USER CODE END Callback 1 */
 }
@@ -4,13 +4,62 @@
 
 #include "packet_t.h"
 
-#include <assert.h>
+#include <stddef.h>
 #include <string.h>
 
-uint16_t crc16(const uint8_t *data, uint16_t length)
+#if CRC16_IMPL == CRC16_TABLE
+/* crc16_table[i] = CRC of the byte i shifted in from the top, 512 B of flash */
+static const uint16_t crc16_table[256] = {
+    0x0000U, 0x1021U, 0x2042U, 0x3063U, 0x4084U, 0x50A5U, 0x60C6U, 0x70E7U,
+    0x8108U, 0x9129U, 0xA14AU, 0xB16BU, 0xC18CU, 0xD1ADU, 0xE1CEU, 0xF1EFU,
+    0x1231U, 0x0210U, 0x3273U, 0x2252U, 0x52B5U, 0x4294U, 0x72F7U, 0x62D6U,
+    0x9339U, 0x8318U, 0xB37BU, 0xA35AU, 0xD3BDU, 0xC39CU, 0xF3FFU, 0xE3DEU,
+    0x2462U, 0x3443U, 0x0420U, 0x1401U, 0x64E6U, 0x74C7U, 0x44A4U, 0x5485U,
+    0xA56AU, 0xB54BU, 0x8528U, 0x9509U, 0xE5EEU, 0xF5CFU, 0xC5ACU, 0xD58DU,
+    0x3653U, 0x2672U, 0x1611U, 0x0630U, 0x76D7U, 0x66F6U, 0x5695U, 0x46B4U,
+    0xB75BU, 0xA77AU, 0x9719U, 0x8738U, 0xF7DFU, 0xE7FEU, 0xD79DU, 0xC7BCU,
+    0x48C4U, 0x58E5U, 0x6886U, 0x78A7U, 0x0840U, 0x1861U, 0x2802U, 0x3823U,
+    0xC9CCU, 0xD9EDU, 0xE98EU, 0xF9AFU, 0x8948U, 0x9969U, 0xA90AU, 0xB92BU,
+    0x5AF5U, 0x4AD4U, 0x7AB7U, 0x6A96U, 0x1A71U, 0x0A50U, 0x3A33U, 0x2A12U,
+    0xDBFDU, 0xCBDCU, 0xFBBFU, 0xEB9EU, 0x9B79U, 0x8B58U, 0xBB3BU, 0xAB1AU,
+    0x6CA6U, 0x7C87U, 0x4CE4U, 0x5CC5U, 0x2C22U, 0x3C03U, 0x0C60U, 0x1C41U,
+    0xEDAEU, 0xFD8FU, 0xCDECU, 0xDDCDU, 0xAD2AU, 0xBD0BU, 0x8D68U, 0x9D49U,
+    0x7E97U, 0x6EB6U, 0x5ED5U, 0x4EF4U, 0x3E13U, 0x2E32U, 0x1E51U, 0x0E70U,
+    0xFF9FU, 0xEFBEU, 0xDFDDU, 0xCFFCU, 0xBF1BU, 0xAF3AU, 0x9F59U, 0x8F78U,
+    0x9188U, 0x81A9U, 0xB1CAU, 0xA1EBU, 0xD10CU, 0xC12DU, 0xF14EU, 0xE16FU,
+    0x1080U, 0x00A1U, 0x30C2U, 0x20E3U, 0x5004U, 0x4025U, 0x7046U, 0x6067U,
+    0x83B9U, 0x9398U, 0xA3FBU, 0xB3DAU, 0xC33DU, 0xD31CU, 0xE37FU, 0xF35EU,
+    0x02B1U, 0x1290U, 0x22F3U, 0x32D2U, 0x4235U, 0x5214U, 0x6277U, 0x7256U,
+    0xB5EAU, 0xA5CBU, 0x95A8U, 0x8589U, 0xF56EU, 0xE54FU, 0xD52CU, 0xC50DU,
+    0x34E2U, 0x24C3U, 0x14A0U, 0x0481U, 0x7466U, 0x6447U, 0x5424U, 0x4405U,
+    0xA7DBU, 0xB7FAU, 0x8799U, 0x97B8U, 0xE75FU, 0xF77EU, 0xC71DU, 0xD73CU,
+    0x26D3U, 0x36F2U, 0x0691U, 0x16B0U, 0x6657U, 0x7676U, 0x4615U, 0x5634U,
+    0xD94CU, 0xC96DU, 0xF90EU, 0xE92FU, 0x99C8U, 0x89E9U, 0xB98AU, 0xA9ABU,
+    0x5844U, 0x4865U, 0x7806U, 0x6827U, 0x18C0U, 0x08E1U, 0x3882U, 0x28A3U,
+    0xCB7DU, 0xDB5CU, 0xEB3FU, 0xFB1EU, 0x8BF9U, 0x9BD8U, 0xABBBU, 0xBB9AU,
+    0x4A75U, 0x5A54U, 0x6A37U, 0x7A16U, 0x0AF1U, 0x1AD0U, 0x2AB3U, 0x3A92U,
+    0xFD2EU, 0xED0FU, 0xDD6CU, 0xCD4DU, 0xBDAAU, 0xAD8BU, 0x9DE8U, 0x8DC9U,
+    0x7C26U, 0x6C07U, 0x5C64U, 0x4C45U, 0x3CA2U, 0x2C83U, 0x1CE0U, 0x0CC1U,
+    0xEF1FU, 0xFF3EU, 0xCF5DU, 0xDF7CU, 0xAF9BU, 0xBFBAU, 0x8FD9U, 0x9FF8U,
+    0x6E17U, 0x7E36U, 0x4E55U, 0x5E74U, 0x2E93U, 0x3EB2U, 0x0ED1U, 0x1EF0U
+};
+#elif CRC16_IMPL == CRC16_NIBBLE
+/* crc16_nibble[i] = CRC of the nibble i shifted in from the top, 32 B of flash */
+static const uint16_t crc16_nibble[16] = {
+    0x0000U, 0x1021U, 0x2042U, 0x3063U, 0x4084U, 0x50A5U, 0x60C6U, 0x70E7U,
+    0x8108U, 0x9129U, 0xA14AU, 0xB16BU, 0xC18CU, 0xD1ADU, 0xE1CEU, 0xF1EFU
+};
+#endif
+
+uint16_t crc16_update(uint16_t crc, const uint8_t *data, uint16_t length)
 {
-    uint16_t crc = 0xFFFFU; // initial value
     for (uint16_t i = 0; i < length; i++) {
+#if CRC16_IMPL == CRC16_TABLE
+        crc = (uint16_t)((crc << 8) ^ crc16_table[(uint8_t)((crc >> 8) ^ data[i])]);
+#elif CRC16_IMPL == CRC16_NIBBLE
+        crc = (uint16_t)((crc << 4) ^ crc16_nibble[(uint8_t)((crc >> 12) ^ (data[i] >> 4))]);
+        crc = (uint16_t)((crc << 4) ^ crc16_nibble[(uint8_t)((crc >> 12) ^ (data[i] & 0x0FU))]);
+#else
         crc ^= ((uint16_t)data[i] << 8);
         for (uint8_t j = 0U; j < 8U; j++) {
             if (crc & 0x8000) {
@@ -19,29 +68,211 @@ uint16_t crc16(const uint8_t *data, uint16_t length)
                 crc <<= 1;
             }
         }
+#endif
     }
     return crc;
 }
 
-int build_packet(packet_t *pkt, const uint8_t src_id,const  uint8_t dest_id, const flags flags,const  uint8_t max_hops,const  uint16_t msg_id,
-               const   uint8_t *payload) {
+uint16_t crc16(const uint8_t *data, uint16_t length)
+{
+    return crc16_update(CRC16_INIT, data, length);
+}
+
+/* bits of the first two wire bytes */
+#define WIRE_VERSION_SHIFT 6U
+#define WIRE_BCAST 0x20U
+#define WIRE_ROUTED 0x10U
+#define WIRE_LENGTH_SHIFT 1U
+#define WIRE_LENGTH_MASK 0x07U
+#define WIRE_KIND_SHIFT 5U
+#define WIRE_SYN 0x10U
+#define WIRE_HOPS_MASK 0x07U
+#define WIRE_RESERVED_0 0x01U
+#define WIRE_RESERVED_1 0x08U
 
+_Static_assert(MESH_MAX_PAYLOAD <= WIRE_LENGTH_MASK, "payload length does not fit its 3 bits");
+_Static_assert(MESH_MAX_HOPS <= WIRE_HOPS_MASK, "max_hops does not fit its 3 bits");
 
-    assert(pkt != NULL);                         // Packet pointer must be valid
-    assert(payload != NULL);                     // Payload pointer must be valid
-    assert(max_hops <= (uint8_t)MESH_MAX_HOPS);                     // Example: max_hops fits in 4 bits
-    assert(src_id != dest_id);                     // Example: src_id != dest_id
+/* the flag combinations the mesh sends, less broadcasting, needs_forwarding and syn; index is the kind */
+static const flags packet_kinds[8] = {
+    {0}, /* data */
+    {.requires_ack = 1U}, /* ARQ data */
+    {.requires_ack = 1U, .ack = 1U}, /* ARQ data with a piggybacked ack */
+    {.ack = 1U}, /* standalone ARQ ack */
+    {.connected_nodes_info = 1U}, /* route advert */
+    {.beacon = 1U}, /* TDMA beacon */
+    {.fragment = 1U},
+    {.fragment = 1U, .ack = 1U} /* fragment status */
+};
+
+static uint8_t packet_flags_byte(flags f)
+{
+    uint8_t b;
+
+    (void)memcpy(&b, &f, sizeof(b));
+    return b;
+}
+
+void packet_msg_refs_init(packet_msg_refs_t *refs)
+{
+    (void)memset(refs->src, MESH_BROADCAST_ID, sizeof(refs->src));
+    refs->next = 0U;
+}
 
+uint16_t packet_msg_id_expand(packet_msg_refs_t *refs, uint8_t src_id, uint8_t low)
+{
+    uint8_t i = 0U;
+    uint8_t ahead;
 
-    pkt->src_id = src_id;
-    pkt->dest_id = dest_id;
-    pkt->flags = flags;
-    pkt->max_hops = max_hops;
-    pkt->msg_id = msg_id;
-    (void)memcpy(pkt->payload, payload, MESH_MAX_PAYLOAD); // (void) => for MISRA
-    pkt->crc = crc16((uint8_t*)pkt,offsetof(packet_t,crc));
+    while (i < PACKET_MSG_REFS && refs->src[i] != src_id) {
+        i++;
+    }
+    if (i == PACKET_MSG_REFS) {
+        i = refs->next;
+        refs->next = (uint8_t)((refs->next + 1U) % PACKET_MSG_REFS);
+        refs->src[i] = src_id;
+        refs->msg_id[i] = low;
+        return low;
+    }
+    ahead = (uint8_t)(low - (uint8_t)refs->msg_id[i]);
+    if (ahead > UINT8_MAX - PACKET_MSG_REORDER) {
+        return (uint16_t)(refs->msg_id[i] - (uint8_t)(0U - ahead)); /* late */
+    }
+    refs->msg_id[i] = (uint16_t)(refs->msg_id[i] + ahead);
+    return refs->msg_id[i];
+}
 
+uint8_t packet_wire_length(const uint8_t *wire)
+{
+    return (uint8_t)(PACKET_WIRE_MIN
+                     + ((wire[0] & WIRE_BCAST) == 0U ? 1U : 0U)
+                     + ((wire[0] & WIRE_ROUTED) != 0U ? 1U : 0U)
+                     + ((wire[0] >> WIRE_LENGTH_SHIFT) & WIRE_LENGTH_MASK));
+}
 
+uint8_t packet_encode(uint8_t *wire, const uint8_t *frame)
+{
+    packet_view_t const view = {.raw = frame};
+    uint8_t const dest = packet_view_dest(&view);
+    uint8_t const next_hop = packet_view_next_hop(&view);
+    uint8_t const *payload = packet_view_payload(&view);
+    flags f = packet_view_flags(&view);
+    uint8_t length = MESH_MAX_PAYLOAD;
+    uint8_t kind = 0U;
+    uint8_t syn = f.syn;
+    uint8_t n = 2U;
+    uint16_t crc;
 
-    return 1;
+    if (f.broadcasting != (dest == MESH_BROADCAST_ID) || f.needs_forwarding != (dest != MESH_BROADCAST_ID)
+        || packet_view_max_hops(&view) > (uint8_t)MESH_MAX_HOPS) {
+        return 0U;
+    }
+    f.broadcasting = 0U;
+    f.needs_forwarding = 0U;
+    f.syn = 0U;
+    while (kind < 8U && packet_flags_byte(packet_kinds[kind]) != packet_flags_byte(f)) {
+        kind++;
+    }
+    if (kind == 8U || (syn && !f.requires_ack)) {
+        return 0U;
+    }
+    while (length > 0U && payload[length - 1U] == 0U) {
+        length--;
+    }
+
+    wire[0] = (uint8_t)((PACKET_WIRE_VERSION << WIRE_VERSION_SHIFT)
+                        | (dest == MESH_BROADCAST_ID ? WIRE_BCAST : 0U)
+                        | (next_hop != MESH_BROADCAST_ID ? WIRE_ROUTED : 0U)
+                        | (length << WIRE_LENGTH_SHIFT));
+    wire[1] = (uint8_t)((kind << WIRE_KIND_SHIFT) | (syn ? WIRE_SYN : 0U) | packet_view_max_hops(&view));
+    wire[n++] = packet_view_src(&view);
+    if (dest != MESH_BROADCAST_ID) {
+        wire[n++] = dest;
+    }
+    wire[n++] = (uint8_t)packet_view_msg_id(&view);
+    if (next_hop != MESH_BROADCAST_ID) {
+        wire[n++] = next_hop;
+    }
+    (void)memcpy(&wire[n], payload, length);
+    n += length;
+    crc = crc16(wire, n);
+    wire[n++] = (uint8_t)crc;
+    wire[n++] = (uint8_t)(crc >> 8);
+    return n;
+}
+
+packet_status_t packet_decode(packet_view_t *view, uint8_t *frame, const uint8_t *wire, uint16_t length)
+{
+    uint8_t payload[MESH_MAX_PAYLOAD] = {0};
+    uint8_t src_id;
+    uint8_t dest_id = MESH_BROADCAST_ID;
+    uint8_t next_hop = MESH_BROADCAST_ID;
+    uint8_t n = 2U;
+    uint8_t msg_id;
+    uint8_t kind;
+    uint8_t payload_length;
+    flags f;
+
+    if (length < PACKET_WIRE_MIN || length != packet_wire_length(wire)) {
+        return PACKET_BAD_LENGTH;
+    }
+    if (crc16(wire, (uint16_t)(length - 2U))
+        != (uint16_t)(wire[length - 2U] | ((uint16_t)wire[length - 1U] << 8))) {
+        return PACKET_BAD_CRC;
+    }
+    if ((wire[0] >> WIRE_VERSION_SHIFT) != PACKET_WIRE_VERSION) {
+        return PACKET_BAD_VERSION;
+    }
+    if ((wire[1] & WIRE_HOPS_MASK) > (uint8_t)MESH_MAX_HOPS) {
+        return PACKET_BAD_HOPS;
+    }
+    payload_length = (uint8_t)((wire[0] >> WIRE_LENGTH_SHIFT) & WIRE_LENGTH_MASK);
+    kind = (uint8_t)(wire[1] >> WIRE_KIND_SHIFT);
+    f = packet_kinds[kind];
+    if ((wire[0] & WIRE_RESERVED_0) != 0U || (wire[1] & WIRE_RESERVED_1) != 0U
+        || payload_length > MESH_MAX_PAYLOAD
+        || ((wire[1] & WIRE_SYN) != 0U && !f.requires_ack)) {
+        return PACKET_BAD_FLAGS;
+    }
+
+    src_id = wire[n++];
+    if ((wire[0] & WIRE_BCAST) == 0U) {
+        dest_id = wire[n++];
+    }
+    if (((f.beacon || f.connected_nodes_info) && dest_id != MESH_BROADCAST_ID)
+        || (f.fragment && dest_id == MESH_BROADCAST_ID)) {
+        return PACKET_BAD_FLAGS;
+    }
+    if (src_id == MESH_BROADCAST_ID || src_id == dest_id) {
+        return PACKET_BAD_ADDRESS;
+    }
+    f.broadcasting = dest_id == MESH_BROADCAST_ID;
+    f.needs_forwarding = dest_id != MESH_BROADCAST_ID;
+    f.syn = (wire[1] & WIRE_SYN) != 0U;
+
+    msg_id = wire[n++];
+    if ((wire[0] & WIRE_ROUTED) != 0U) {
+        next_hop = wire[n++];
+    }
+    (void)memcpy(payload, &wire[n], payload_length);
+
+    (void)packet_write(frame, src_id, dest_id, f, wire[1] & WIRE_HOPS_MASK,
+                       msg_id, payload);
+    packet_set_next_hop(frame, next_hop);
+    view->raw = frame;
+    return PACKET_OK;
+}
+
+uint8_t packet_write(uint8_t *buf, const uint8_t src_id, const uint8_t dest_id, const flags flags,
+                     const uint8_t max_hops, const uint16_t msg_id, const uint8_t *payload)
+{
+    buf[offsetof(packet_t, src_id)] = src_id;
+    buf[offsetof(packet_t, dest_id)] = dest_id;
+    (void)memcpy(&buf[offsetof(packet_t, flags)], &flags, sizeof(flags));
+    buf[offsetof(packet_t, max_hops)] = max_hops;
+    buf[offsetof(packet_t, msg_id)] = (uint8_t)msg_id;
+    buf[offsetof(packet_t, msg_id) + 1U] = (uint8_t)(msg_id >> 8);
+    (void)memcpy(&buf[offsetof(packet_t, payload)], payload, MESH_MAX_PAYLOAD);
+    buf[offsetof(packet_t, next_hop)] = MESH_BROADCAST_ID;
+    return (uint8_t)sizeof(packet_t);
 }
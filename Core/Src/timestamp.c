@@ -0,0 +1,39 @@
+//
+// Created on 10/19/26.
+//
+
+#include "timestamp.h"
+
+#include "main.h"
+
+static uint32_t last_cycles; /* CYCCNT at the previous call */
+static uint32_t rest_cycles; /* cycles not yet worth a whole microsecond */
+static uint32_t now_us;
+
+void timestamp_init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    last_cycles = 0U;
+    rest_cycles = 0U;
+    now_us = 0U;
+}
+
+uint32_t timestamp_now_us(void) {
+    uint32_t cycles_per_us = SystemCoreClock / 1000000UL;
+    uint32_t primask = __get_PRIMASK();
+    uint32_t cycles;
+    uint32_t us;
+
+    __disable_irq();
+    cycles = DWT->CYCCNT;
+    rest_cycles += cycles - last_cycles;
+    last_cycles = cycles;
+    now_us += rest_cycles / cycles_per_us;
+    rest_cycles %= cycles_per_us;
+    us = now_us;
+    __set_PRIMASK(primask);
+
+    return us;
+}
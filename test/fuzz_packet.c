@@ -0,0 +1,34 @@
+//
+// Created on 10/19/26.
+//
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "packet_t.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/*
+ * libFuzzer entry for packet_decode, whatever comes off the air: decode reads no
+ * further than size (the sanitizers watch that), and a frame it accepts encodes back
+ * to one that decodes the same. test_packet feeds it its random frames as well.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    uint8_t frame[sizeof(packet_t)];
+    uint8_t again[sizeof(packet_t)];
+    uint8_t wire[PACKET_WIRE_MAX];
+    packet_view_t view;
+    uint8_t length;
+
+    if (size > UINT16_MAX || packet_decode(&view, frame, data, (uint16_t)size) != PACKET_OK) {
+        return 0;
+    }
+    length = packet_encode(wire, frame);
+    if (length == 0U || packet_decode(&view, again, wire, length) != PACKET_OK
+        || memcmp(frame, again, sizeof(packet_t)) != 0) {
+        abort();
+    }
+    return 0;
+}
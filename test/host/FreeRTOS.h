@@ -0,0 +1,23 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+/* host stand-in for the FreeRTOS kernel headers, scheduler state lives in sx127x_sim.c */
+#include <assert.h>
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef uint32_t TickType_t;
+
+/* storage of the statically allocated kernel objects, never looked into on the host */
+typedef struct { void *dummy[24]; } StaticTask_t;
+typedef struct { void *dummy[20]; } StaticQueue_t;
+typedef struct { void *dummy[8]; } StaticTimer_t;
+
+#define configTICK_RATE_HZ 1000U
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#define configASSERT(x) assert(x)
+
+#endif //HOST_FREERTOS_H
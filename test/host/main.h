@@ -0,0 +1,58 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef HOST_MAIN_H
+#define HOST_MAIN_H
+/*
+ * Host stand-in for Core/Inc/main.h: the bits of the STM32 HAL and CMSIS the LoRa
+ * driver uses, implemented by sx127x_sim.c on top of the simulated chip.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+struct sx127x_sim;
+
+/* a port drives the NSS and NRESET lines of one simulated chip */
+typedef struct {
+    uint16_t odr;
+    struct sx127x_sim *sim;
+} GPIO_TypeDef;
+
+typedef struct {
+    int instance;
+} SPI_HandleTypeDef;
+
+typedef enum { GPIO_PIN_RESET = 0, GPIO_PIN_SET } GPIO_PinState;
+typedef enum { HAL_OK = 0, HAL_ERROR, HAL_BUSY, HAL_TIMEOUT } HAL_StatusTypeDef;
+typedef enum { HAL_SPI_STATE_RESET = 0, HAL_SPI_STATE_READY, HAL_SPI_STATE_BUSY } HAL_SPI_StateTypeDef;
+
+/* STM32F103 numbering of the EXTI lines */
+typedef enum {
+    EXTI0_IRQn = 6,
+    EXTI1_IRQn = 7,
+    EXTI2_IRQn = 8,
+    EXTI3_IRQn = 9,
+    EXTI4_IRQn = 10,
+    EXTI9_5_IRQn = 23,
+    EXTI15_10_IRQn = 40
+} IRQn_Type;
+
+#define GPIO_PIN_0 ((uint16_t)0x0001)
+#define GPIO_PIN_1 ((uint16_t)0x0002)
+#define GPIO_PIN_2 ((uint16_t)0x0004)
+#define GPIO_PIN_3 ((uint16_t)0x0008)
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef *hspi);
+void HAL_Delay(uint32_t ms);
+uint32_t HAL_GetTick(void);
+
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irq);
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+uint32_t __get_IPSR(void);
+
+#endif //HOST_MAIN_H
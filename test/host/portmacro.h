@@ -0,0 +1,11 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef HOST_PORTMACRO_H
+#define HOST_PORTMACRO_H
+#include <stdint.h>
+
+typedef uint32_t StackType_t;
+
+#endif //HOST_PORTMACRO_H
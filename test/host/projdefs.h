@@ -0,0 +1,13 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef HOST_PROJDEFS_H
+#define HOST_PROJDEFS_H
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+
+typedef void (*TaskFunction_t)(void *);
+
+#endif //HOST_PROJDEFS_H
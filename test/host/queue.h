@@ -0,0 +1,11 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef HOST_QUEUE_H
+#define HOST_QUEUE_H
+#include "FreeRTOS.h"
+
+typedef struct QueueDefinition *QueueHandle_t;
+
+#endif //HOST_QUEUE_H
@@ -0,0 +1,11 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef HOST_SEMPHR_H
+#define HOST_SEMPHR_H
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+#endif //HOST_SEMPHR_H
@@ -0,0 +1,20 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef HOST_TASK_H
+#define HOST_TASK_H
+#include "FreeRTOS.h"
+
+typedef struct tskTaskControlBlock *TaskHandle_t;
+
+#define taskSCHEDULER_SUSPENDED ((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING ((BaseType_t)2)
+
+BaseType_t xTaskGetSchedulerState(void);
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+void vTaskDelay(TickType_t ticks);
+
+#endif //HOST_TASK_H
@@ -0,0 +1,11 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef HOST_TIMERS_H
+#define HOST_TIMERS_H
+#include "FreeRTOS.h"
+
+typedef struct tmrTimerControl *TimerHandle_t;
+
+#endif //HOST_TIMERS_H
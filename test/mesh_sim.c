@@ -0,0 +1,281 @@
+//
+// Created on 10/19/26.
+//
+
+#include "mesh_sim.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "LoRa/LoRa.h"
+#include "RA-02/ra-02_AO.h"
+
+/* a simulation outgrew the fixed tables, its figures would be wrong */
+#define MESH_SIM_REQUIRE(cond)                                                   \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            (void)fprintf(stderr, "%s:%d: %s does not hold\n", __FILE__, __LINE__, #cond); \
+            exit(EXIT_FAILURE);                                                  \
+        }                                                                        \
+    } while (0)
+
+typedef struct {
+    uint8_t node;
+    uint64_t start_us;
+    uint64_t end_us;
+} mesh_sim_tx_t;
+
+static mesh_sim_event_t events[MESH_SIM_EVENTS]; /* binary heap */
+static uint32_t event_count;
+static uint32_t event_seq;
+static uint64_t now_us;
+static mesh_sim_tx_t txs[MESH_SIM_TXS]; /* ring, in start order */
+static uint32_t tx_count;
+static uint32_t longest_us;
+
+static void mesh_sim_clear(mesh_sim_topology_t *t, uint32_t count) {
+    MESH_SIM_REQUIRE(count <= MESH_SIM_NODES);
+    (void)memset(t, 0, sizeof(*t));
+    t->count = (uint8_t)count;
+}
+
+static void mesh_sim_link(mesh_sim_topology_t *t, uint8_t a, uint8_t b) {
+    t->link[a][b] = true;
+    t->link[b][a] = true;
+}
+
+void mesh_sim_line(mesh_sim_topology_t *t, uint8_t count) {
+    mesh_sim_clear(t, count);
+    for (uint8_t i = 1U; i < count; i++) {
+        mesh_sim_link(t, (uint8_t)(i - 1U), i);
+    }
+}
+
+void mesh_sim_grid(mesh_sim_topology_t *t, uint8_t width, uint8_t height) {
+    mesh_sim_clear(t, (uint32_t)width * height);
+    for (uint8_t i = 0U; i < t->count; i++) {
+        if (i % width != width - 1U) {
+            mesh_sim_link(t, i, (uint8_t)(i + 1U));
+        }
+        if (i + width < t->count) {
+            mesh_sim_link(t, i, (uint8_t)(i + width));
+        }
+    }
+}
+
+void mesh_sim_full(mesh_sim_topology_t *t, uint8_t count) {
+    mesh_sim_clear(t, count);
+    for (uint8_t a = 0U; a < count; a++) {
+        for (uint8_t b = (uint8_t)(a + 1U); b < count; b++) {
+            mesh_sim_link(t, a, b);
+        }
+    }
+}
+
+void mesh_sim_random(mesh_sim_topology_t *t, uint8_t count, double radius, uint32_t *prng) {
+    double x[MESH_SIM_NODES];
+    double y[MESH_SIM_NODES];
+
+    do {
+        mesh_sim_clear(t, count);
+        for (uint8_t i = 0U; i < count; i++) {
+            x[i] = mesh_sim_uniform(prng, 10000U) / 10000.0;
+            y[i] = mesh_sim_uniform(prng, 10000U) / 10000.0;
+            for (uint8_t j = 0U; j < i; j++) {
+                if (hypot(x[i] - x[j], y[i] - y[j]) <= radius) {
+                    mesh_sim_link(t, i, j);
+                }
+            }
+        }
+    } while (!mesh_sim_connected(t));
+}
+
+void mesh_sim_hops(mesh_sim_topology_t const *t, uint8_t src, uint8_t *hops) {
+    uint8_t queue[MESH_SIM_NODES];
+    uint8_t head = 0U;
+    uint8_t tail = 0U;
+
+    (void)memset(hops, UINT8_MAX, t->count);
+    hops[src] = 0U;
+    queue[tail++] = src;
+    while (head != tail) {
+        uint8_t n = queue[head++];
+
+        for (uint8_t m = 0U; m < t->count; m++) {
+            if (t->link[n][m] && hops[m] == UINT8_MAX) {
+                hops[m] = (uint8_t)(hops[n] + 1U);
+                queue[tail++] = m;
+            }
+        }
+    }
+}
+
+bool mesh_sim_connected(mesh_sim_topology_t const *t) {
+    uint8_t hops[MESH_SIM_NODES];
+
+    mesh_sim_hops(t, 0U, hops);
+    for (uint8_t i = 0U; i < t->count; i++) {
+        if (hops[i] == UINT8_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t mesh_sim_rand(uint32_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+uint32_t mesh_sim_uniform(uint32_t *state, uint32_t n) {
+    return (uint32_t)(((uint64_t)mesh_sim_rand(state) * n) >> 32);
+}
+
+uint64_t mesh_sim_exp_us(uint32_t *state, double mean_us) {
+    return (uint64_t)(-log((mesh_sim_rand(state) + 1.0) / 4294967296.0) * mean_us);
+}
+
+uint32_t mesh_sim_toa_us(uint8_t length) {
+    LoRa lora = newLoRa();
+
+    return LoRa_packetTimeOnAir(&lora, length);
+}
+
+uint32_t mesh_sim_cad_us(void) {
+    return 2U * LoRa_symbolTime(SF_7, BW_125KHz);
+}
+
+uint32_t mesh_sim_backoff_us(uint32_t *prng, uint8_t busy_cads) {
+    uint8_t be = busy_cads < RA02_LBT_MAX_BE ? busy_cads : RA02_LBT_MAX_BE;
+    uint32_t window = 1UL << be;
+
+    return ((mesh_sim_rand(prng) & (window - 1U)) + 1U) * RA02_LBT_SLOT_MS * 1000U;
+}
+
+/*..........................................................................................*/
+static bool mesh_sim_before(mesh_sim_event_t const *a, mesh_sim_event_t const *b) {
+    return a->at_us < b->at_us || (a->at_us == b->at_us && a->seq < b->seq);
+}
+
+static void mesh_sim_swap(uint32_t a, uint32_t b) {
+    mesh_sim_event_t e = events[a];
+
+    events[a] = events[b];
+    events[b] = e;
+}
+
+void mesh_sim_reset(void) {
+    event_count = 0U;
+    event_seq = 0U;
+    now_us = 0U;
+    tx_count = 0U;
+    longest_us = 0U;
+}
+
+void mesh_sim_at(uint64_t at_us, uint8_t node, uint8_t kind, uint32_t arg) {
+    uint32_t i = event_count++;
+
+    MESH_SIM_REQUIRE(event_count <= MESH_SIM_EVENTS);
+    MESH_SIM_REQUIRE(at_us >= now_us);
+    events[i] = (mesh_sim_event_t){at_us, event_seq++, node, kind, arg};
+    while (i > 0U && mesh_sim_before(&events[i], &events[(i - 1U) / 2U])) {
+        mesh_sim_swap(i, (i - 1U) / 2U);
+        i = (i - 1U) / 2U;
+    }
+}
+
+bool mesh_sim_next(mesh_sim_event_t *e) {
+    uint32_t i = 0U;
+
+    if (event_count == 0U) {
+        return false;
+    }
+    *e = events[0];
+    now_us = e->at_us;
+    events[0] = events[--event_count];
+    for (;;) {
+        uint32_t first = i;
+        uint32_t l = 2U * i + 1U;
+        uint32_t r = l + 1U;
+
+        if (l < event_count && mesh_sim_before(&events[l], &events[first])) {
+            first = l;
+        }
+        if (r < event_count && mesh_sim_before(&events[r], &events[first])) {
+            first = r;
+        }
+        if (first == i) {
+            return true;
+        }
+        mesh_sim_swap(i, first);
+        i = first;
+    }
+}
+
+uint64_t mesh_sim_now_us(void) {
+    return now_us;
+}
+
+/*..........................................................................................*/
+uint32_t mesh_sim_send(uint8_t node, uint32_t airtime_us) {
+    txs[tx_count % MESH_SIM_TXS] = (mesh_sim_tx_t){node, now_us, now_us + airtime_us};
+    longest_us = airtime_us > longest_us ? airtime_us : longest_us;
+    return tx_count++;
+}
+
+uint32_t mesh_sim_sent(void) {
+    return tx_count;
+}
+
+/* o is on air while tx is and rx hears it */
+static bool mesh_sim_jams(mesh_sim_topology_t const *t, mesh_sim_tx_t const *tx, mesh_sim_tx_t const *o, uint8_t rx) {
+    return o->start_us < tx->end_us && tx->start_us < o->end_us && (o->node == rx || t->link[o->node][rx]);
+}
+
+bool mesh_sim_heard(mesh_sim_topology_t const *t, uint32_t tx, uint8_t rx) {
+    mesh_sim_tx_t const *e = &txs[tx % MESH_SIM_TXS];
+
+    MESH_SIM_REQUIRE(tx_count - tx <= MESH_SIM_TXS);
+    if (!t->link[e->node][rx]) {
+        return false;
+    }
+    for (uint32_t j = tx; j-- > 0U && tx_count - j <= MESH_SIM_TXS;) {
+        mesh_sim_tx_t const *o = &txs[j % MESH_SIM_TXS];
+
+        if (o->start_us + longest_us <= e->start_us) {
+            break;
+        }
+        if (mesh_sim_jams(t, e, o, rx)) {
+            return false;
+        }
+    }
+    for (uint32_t j = tx + 1U; j < tx_count; j++) {
+        mesh_sim_tx_t const *o = &txs[j % MESH_SIM_TXS];
+
+        if (o->start_us >= e->end_us) {
+            break;
+        }
+        if (mesh_sim_jams(t, e, o, rx)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool mesh_sim_busy(mesh_sim_topology_t const *t, uint8_t node) {
+    for (uint32_t j = tx_count; j-- > 0U && tx_count - j <= MESH_SIM_TXS;) {
+        mesh_sim_tx_t const *o = &txs[j % MESH_SIM_TXS];
+
+        if (o->start_us + longest_us <= now_us) {
+            break;
+        }
+        if (o->end_us > now_us && (o->node == node || t->link[o->node][node])) {
+            return true;
+        }
+    }
+    return false;
+}
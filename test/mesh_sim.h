@@ -0,0 +1,87 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef MESH_SIM_H
+#define MESH_SIM_H
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Common ground of the host network simulations (sim_*.c): node topologies, a
+ * seeded PRNG so every run is the same run, LoRa airtime from the driver's own
+ * formula, a time-ordered event queue and the shared channel. Links are unit-disk
+ * ones, both ways.
+ */
+#define MESH_SIM_NODES 128U
+
+typedef struct {
+    uint8_t count;
+    bool link[MESH_SIM_NODES][MESH_SIM_NODES]; /* no self links */
+} mesh_sim_topology_t;
+
+/* nodes in a row, each hearing the one before and after */
+void mesh_sim_line(mesh_sim_topology_t *t, uint8_t count);
+/* width x height, 4-neighborhood */
+void mesh_sim_grid(mesh_sim_topology_t *t, uint8_t width, uint8_t height);
+/* everybody hears everybody */
+void mesh_sim_full(mesh_sim_topology_t *t, uint8_t count);
+/* uniform in the unit square, linked within radius, redrawn until connected */
+void mesh_sim_random(mesh_sim_topology_t *t, uint8_t count, double radius, uint32_t *prng);
+
+bool mesh_sim_connected(mesh_sim_topology_t const *t);
+/* hops from src to every node, UINT8_MAX where unreachable */
+void mesh_sim_hops(mesh_sim_topology_t const *t, uint8_t src, uint8_t *hops);
+
+/* xorshift32, state never 0 */
+uint32_t mesh_sim_rand(uint32_t *state);
+/* 0 .. n - 1 */
+uint32_t mesh_sim_uniform(uint32_t *state, uint32_t n);
+/* exponentially distributed, the gaps between Poisson arrivals */
+uint64_t mesh_sim_exp_us(uint32_t *state, double mean_us);
+
+/* time on air [us] of length bytes at SF7/125 kHz, CR 4/5, 8-symbol preamble, explicit header, CRC on */
+uint32_t mesh_sim_toa_us(uint8_t length);
+
+/* CAD at SF7/125 kHz: two symbols */
+uint32_t mesh_sim_cad_us(void);
+/* RA02_backoff_ms after the given number of busy CADs, in us */
+uint32_t mesh_sim_backoff_us(uint32_t *prng, uint8_t busy_cads);
+
+/*
+ * Events in time order, equal times in the order they were scheduled. The clock
+ * stands at the last event taken. kind and arg are the simulation's own.
+ */
+#define MESH_SIM_EVENTS 4096U
+
+typedef struct {
+    uint64_t at_us;
+    uint32_t seq;
+    uint8_t node;
+    uint8_t kind;
+    uint32_t arg;
+} mesh_sim_event_t;
+
+/* clock to 0, no events, nothing on air */
+void mesh_sim_reset(void);
+void mesh_sim_at(uint64_t at_us, uint8_t node, uint8_t kind, uint32_t arg);
+/* false once no event is left */
+bool mesh_sim_next(mesh_sim_event_t *e);
+uint64_t mesh_sim_now_us(void);
+
+/*
+ * The channel. A transmission reaches rx if rx is a neighbor of its sender, did
+ * not send itself meanwhile and heard no other neighbor overlap it: no capture.
+ * The last MESH_SIM_TXS transmissions are kept, judge a frame before it falls out.
+ */
+#define MESH_SIM_TXS 4096U
+
+/* node goes on air from now, returns the transmission */
+uint32_t mesh_sim_send(uint8_t node, uint32_t airtime_us);
+bool mesh_sim_heard(mesh_sim_topology_t const *t, uint32_t tx, uint8_t rx);
+/* what a CAD of node's finds now: it or a neighbor on air */
+bool mesh_sim_busy(mesh_sim_topology_t const *t, uint8_t node);
+/* transmissions so far */
+uint32_t mesh_sim_sent(void);
+
+#endif //MESH_SIM_H
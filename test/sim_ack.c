@@ -0,0 +1,248 @@
+//
+// Created on 10/19/26.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mesh_sim.h"
+#include "RA-02/ra-02_AO.h"
+#include "test.h"
+
+/*
+ * How long a standalone ARQ ack waits for the radio while data queues up, with the
+ * AO's per-class queues (RA02_txq_pick and RA02_txq_dequeue of ra-02_txq.c) against
+ * the single RA02_TX_QUEUE_LEN FIFO they replaced. One node sends to LINKS
+ * neighbors: Poisson data, half interactive and half bulk, and Poisson acks, each
+ * for a random one of them. Both schedulers aggregate runs for one neighbor the way
+ * RA02_tx_next does and start every frame with one CAD and
+ * TURNAROUND_US; the channel is otherwise clear and the duty-cycle limit is left out,
+ * so what shows is the queueing alone. An ack's latency runs from its enqueue to its
+ * first symbol on the air.
+ */
+#define DATA_LENGTH PACKET_WIRE_MAX
+#define ACK_LENGTH 8U
+#define LINKS 3U
+#define ACKS_PER_S 0.5
+#define TURNAROUND_US 1000U
+#define SECONDS 3600U
+
+enum { EV_DATA, EV_ACK, EV_AGG_TIMEOUT, EV_TX_START, EV_TX_END };
+
+static RA02_txq_t txq[RA02_TXQ_CLASSES];
+static uint8_t const per_class_depth[RA02_TXQ_CLASSES] = {
+    RA02_TXQ_CONTROL_LEN, RA02_TXQ_INTERACTIVE_LEN, RA02_TXQ_BULK_LEN
+};
+static bool classes; /* false: everything in one FIFO, txq[RA02_TXQ_INTERACTIVE] */
+static uint8_t turn;
+static uint32_t prng;
+static bool busy; /* from the CAD to TxDone */
+static uint8_t tx_class;
+static uint8_t on_air; /* entries at the head of tx_class being sent */
+static uint32_t timer;
+static uint32_t acks;
+static uint32_t acks_dropped;
+static uint64_t ack_wait_us;
+static uint32_t ack_max_us;
+static uint32_t ack_over; /* acks that waited longer than the per-class bound */
+static uint32_t bound_us;
+static uint32_t data_sent;
+static bool is_ack[RA02_TXQ_CLASSES][RA02_TX_QUEUE_LEN];
+static uint64_t queued_us[RA02_TXQ_CLASSES][RA02_TX_QUEUE_LEN];
+
+static void enqueue(uint8_t c, bool ack) {
+    RA02_txq_t *q;
+    uint8_t tail;
+
+    if (!classes) {
+        c = RA02_TXQ_INTERACTIVE;
+    }
+    q = &txq[c];
+    if (q->count >= (classes ? per_class_depth[c] : RA02_TX_QUEUE_LEN)) {
+        uint8_t held = (busy && tx_class == c) ? on_air : 0U;
+
+        /* bulk gives up its oldest entry not on the air, the others refuse */
+        if (!classes || c != RA02_TXQ_BULK || held == q->count) {
+            q->dropped++;
+            acks_dropped += ack ? 1U : 0U;
+            return;
+        }
+        for (uint8_t i = held; i + 1U < q->count; i++) {
+            uint8_t to = RA02_txq_at(q, i);
+            uint8_t from = RA02_txq_at(q, i + 1U);
+
+            q->length[to] = q->length[from];
+            q->link[to] = q->link[from];
+            is_ack[c][to] = is_ack[c][from];
+            queued_us[c][to] = queued_us[c][from];
+        }
+        q->count--;
+        q->dropped++;
+    }
+    tail = RA02_txq_at(q, q->count);
+    q->length[tail] = ack ? ACK_LENGTH : DATA_LENGTH;
+    q->link[tail] = (uint8_t)mesh_sim_uniform(&prng, LINKS);
+    q->queued_ms[tail] = (uint32_t)(mesh_sim_now_us() / 1000U);
+    is_ack[c][tail] = ack;
+    queued_us[c][tail] = mesh_sim_now_us();
+    q->count++;
+}
+
+/* RA02_agg_run */
+static uint8_t agg_run(RA02_txq_t const *q) {
+    uint8_t n = 1U;
+
+    while (n < q->count && q->link[RA02_txq_at(q, n)] == q->link[q->head]) {
+        n++;
+    }
+    return n;
+}
+
+/* RA02_tx_next */
+static void tx_next(void) {
+    uint8_t c = classes ? RA02_txq_pick(txq, &turn)
+                        : (txq[RA02_TXQ_INTERACTIVE].count > 0U ? RA02_TXQ_INTERACTIVE : RA02_TXQ_CLASSES);
+    RA02_txq_t const *q;
+    uint32_t waited;
+    uint8_t length = 1U;
+
+    if (c == RA02_TXQ_CLASSES) {
+        return;
+    }
+    q = &txq[c];
+    waited = (uint32_t)(mesh_sim_now_us() / 1000U) - q->queued_ms[q->head];
+    on_air = agg_run(q);
+    if (c != RA02_TXQ_CONTROL && on_air == RA02_txq_total(txq)
+        && on_air < (classes ? per_class_depth[c] : RA02_TX_QUEUE_LEN) && waited < RA02_AGG_LATENCY_MS) {
+        mesh_sim_at(mesh_sim_now_us() + (RA02_AGG_LATENCY_MS - waited) * 1000ULL, 0U, EV_AGG_TIMEOUT, ++timer);
+        on_air = 0U;
+        return;
+    }
+    timer++;
+    busy = true;
+    tx_class = c;
+    for (uint8_t i = 0U; i < on_air; i++) {
+        length += 1U + q->length[RA02_txq_at(q, i)];
+    }
+    if (on_air == 1U) {
+        length = q->length[q->head];
+    }
+    mesh_sim_at(mesh_sim_now_us() + mesh_sim_cad_us() + TURNAROUND_US, 0U, EV_TX_START, length);
+}
+
+static void simulate(double load, bool per_class) {
+    double data_mean_us = mesh_sim_toa_us(DATA_LENGTH) / load;
+    mesh_sim_event_t e;
+
+    (void)memset(txq, 0, sizeof(txq));
+    classes = per_class;
+    turn = RA02_TXQ_INTERACTIVE;
+    prng = 0xBB67AE85U;
+    busy = false;
+    on_air = 0U;
+    timer = 0U;
+    acks = 0U;
+    acks_dropped = 0U;
+    ack_wait_us = 0U;
+    ack_max_us = 0U;
+    ack_over = 0U;
+    data_sent = 0U;
+    mesh_sim_reset();
+    mesh_sim_at(mesh_sim_exp_us(&prng, data_mean_us), 0U, EV_DATA, 0U);
+    mesh_sim_at(mesh_sim_exp_us(&prng, 1e6 / ACKS_PER_S), 0U, EV_ACK, 0U);
+    while (mesh_sim_next(&e)) {
+        bool running = mesh_sim_now_us() < SECONDS * 1000000ULL;
+
+        switch (e.kind) {
+            case EV_DATA:
+                if (running) {
+                    mesh_sim_at(mesh_sim_now_us() + mesh_sim_exp_us(&prng, data_mean_us), 0U, EV_DATA, 0U);
+                }
+                enqueue((mesh_sim_rand(&prng) & 1U) != 0U ? RA02_TXQ_INTERACTIVE : RA02_TXQ_BULK, false);
+                if (!busy) {
+                    tx_next();
+                }
+                break;
+            case EV_ACK:
+                if (running) {
+                    mesh_sim_at(mesh_sim_now_us() + mesh_sim_exp_us(&prng, 1e6 / ACKS_PER_S), 0U, EV_ACK, 0U);
+                }
+                acks++;
+                enqueue(RA02_TXQ_CONTROL, true);
+                if (!busy) {
+                    tx_next();
+                }
+                break;
+            case EV_AGG_TIMEOUT:
+                if (e.arg == timer && !busy) {
+                    tx_next();
+                }
+                break;
+            case EV_TX_START: {
+                RA02_txq_t const *q = &txq[tx_class];
+
+                for (uint8_t i = 0U; i < on_air; i++) {
+                    uint8_t entry = RA02_txq_at(q, i);
+                    uint32_t wait_us = (uint32_t)(mesh_sim_now_us() - queued_us[tx_class][entry]);
+
+                    if (!is_ack[tx_class][entry]) {
+                        data_sent++;
+                        continue;
+                    }
+                    ack_wait_us += wait_us;
+                    ack_max_us = wait_us > ack_max_us ? wait_us : ack_max_us;
+                    ack_over += wait_us > bound_us ? 1U : 0U;
+                }
+                mesh_sim_at(mesh_sim_now_us() + mesh_sim_toa_us((uint8_t)e.arg), 0U, EV_TX_END, 0U);
+                break;
+            }
+            case EV_TX_END:
+                RA02_txq_dequeue(txq, tx_class, on_air);
+                busy = false;
+                on_air = 0U;
+                tx_next();
+                break;
+        }
+    }
+}
+
+static void row(double load, bool per_class) {
+    uint32_t sent;
+
+    simulate(load, per_class);
+    sent = acks - acks_dropped;
+    (void)printf("%4.2f %-9s %11.1f %11.1f %11.3f %13.3f %7u\n", load, per_class ? "classes" : "FIFO",
+                 ack_wait_us / 1e3 / sent, ack_max_us / 1e3, ack_over / (double)sent, acks_dropped / (double)acks,
+                 data_sent / SECONDS);
+}
+
+int main(void) {
+    static double const loads[] = {0.2, 0.4, 0.6, 0.8, 0.95};
+
+    /* the AO's bound: the longest aggregate already on the way, the acks ahead in the control queue, its own CAD */
+    bound_us = mesh_sim_toa_us(RA02_AGG_MAX) + (RA02_TXQ_CONTROL_LEN - 1U) * mesh_sim_toa_us(ACK_LENGTH)
+               + (RA02_TXQ_CONTROL_LEN + 1U) * (mesh_sim_cad_us() + TURNAROUND_US);
+    (void)printf("%u-byte data (%.1f ms) to %u neighbors, %.1f acks/s, ack bound %.1f ms, %u s\n", DATA_LENGTH,
+                 mesh_sim_toa_us(DATA_LENGTH) / 1e3, LINKS, ACKS_PER_S, bound_us / 1e3, SECONDS);
+    (void)printf("load queues     ack mean ms  ack max ms  over bound  acks dropped  data/s\n");
+    for (uint32_t i = 0U; i < sizeof(loads) / sizeof(loads[0]); i++) {
+        uint32_t max_us;
+        double mean_us;
+
+        row(loads[i], true);
+        max_us = ack_max_us;
+        mean_us = ack_wait_us / (double)(acks - acks_dropped);
+        /* with the control queue an ack waits for one transmission at most, and only a third ack in one is refused */
+        CHECK(ack_max_us <= bound_us);
+        CHECK(acks_dropped <= acks / 500U);
+        row(loads[i], false);
+        /* the FIFO holds acks back for company and behind data for other neighbors */
+        CHECK(ack_wait_us / (double)(acks - acks_dropped) > 2.0 * mean_us);
+        CHECK(ack_max_us > max_us);
+        if (loads[i] >= 0.8) {
+            /* and once data fills it, refuses them */
+            CHECK(acks_dropped > acks / 10U);
+        }
+    }
+    return test_done();
+}
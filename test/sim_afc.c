@@ -0,0 +1,138 @@
+//
+// Created on 10/19/26.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "LoRa/LoRa.h"
+#include "mesh_sim.h"
+#include "ra-02_afc.h"
+#include "test.h"
+
+/*
+ * Frame loss from carrier offsets, with and without the AFC of ra-02_afc.c. Every
+ * node's crystal starts up to CRYSTAL_PPM off and then random-walks WALK_PPM an
+ * hour (temperature); every node broadcasts once a minute and everybody hears
+ * everybody. A frame is lost when sender and receiver are more than a quarter of
+ * the bandwidth apart, the SX127x's tolerance. With AFC each receiver feeds the FEI
+ * of what it heard, give or take FEI_NOISE_HZ, to RA02_afc_sample and retunes as
+ * the AO does after each RX drain.
+ */
+#define NODES 10U
+#define CRYSTAL_PPM 10.0
+#define WALK_PPM 0.3
+#define FEI_NOISE_HZ 100U
+#define BROADCAST_US 60000000ULL
+#define HOUR_US 3600000000ULL
+#define HOURS 48U
+
+enum { EV_BROADCAST, EV_DRIFT };
+
+typedef struct {
+    double crystal_hz; /* uncorrected synthesizer against the nominal carrier */
+    RA02_afc_t afc;
+} node_t;
+
+static uint32_t const bandwidths_hz[] = {125000U, 62500U, 31250U, 20800U, 15600U, 10400U};
+
+static node_t nodes[NODES];
+static uint32_t prng;
+static uint32_t heard;
+static uint32_t lost;
+
+static double ppm_hz(double ppm) {
+    return ppm * 1e-6 * LORA_CH_BASE_HZ;
+}
+
+static double carrier_hz(node_t const *n, bool afc) {
+    return n->crystal_hz + (afc ? n->afc.applied_hz : 0);
+}
+
+/* one frame from tx to everybody else; the second day counts, the first is settling */
+static void broadcast(uint8_t tx, uint32_t bw_hz, bool afc) {
+    bool counted = mesh_sim_now_us() >= HOURS / 2U * HOUR_US;
+
+    for (uint8_t rx = 0U; rx < NODES; rx++) {
+        double offset_hz = carrier_hz(&nodes[tx], afc) - carrier_hz(&nodes[rx], afc);
+
+        if (rx == tx) {
+            continue;
+        }
+        if (fabs(offset_hz) > bw_hz / 4.0) {
+            lost += counted ? 1U : 0U;
+            continue;
+        }
+        heard += counted ? 1U : 0U;
+        if (afc) {
+            int32_t noise = (int32_t)mesh_sim_uniform(&prng, 2U * FEI_NOISE_HZ + 1U) - (int32_t)FEI_NOISE_HZ;
+
+            (void)RA02_afc_sample(&nodes[rx].afc, (int32_t)lround(offset_hz) + noise);
+            (void)RA02_afc_retune(&nodes[rx].afc);
+        }
+    }
+}
+
+/* widest gap between two carriers at the end */
+static double spread_hz(bool afc) {
+    double low = carrier_hz(&nodes[0], afc);
+    double high = low;
+
+    for (uint8_t id = 1U; id < NODES; id++) {
+        low = fmin(low, carrier_hz(&nodes[id], afc));
+        high = fmax(high, carrier_hz(&nodes[id], afc));
+    }
+    return high - low;
+}
+
+static double run(uint32_t bw_hz, bool afc) {
+    mesh_sim_event_t e;
+
+    prng = 0x2545F491U;
+    heard = 0U;
+    lost = 0U;
+    mesh_sim_reset();
+    for (uint8_t id = 0U; id < NODES; id++) {
+        nodes[id].crystal_hz = ppm_hz(((double)mesh_sim_uniform(&prng, 2001U) - 1000.0) * CRYSTAL_PPM / 1000.0);
+        RA02_afc_init(&nodes[id].afc);
+        mesh_sim_at(mesh_sim_uniform(&prng, (uint32_t)BROADCAST_US), id, EV_BROADCAST, 0U);
+        mesh_sim_at(HOUR_US, id, EV_DRIFT, 0U);
+    }
+    while (mesh_sim_next(&e)) {
+        if (mesh_sim_now_us() >= HOURS * HOUR_US) {
+            continue;
+        }
+        if (e.kind == EV_BROADCAST) {
+            broadcast(e.node, bw_hz, afc);
+            mesh_sim_at(mesh_sim_now_us() + BROADCAST_US, e.node, EV_BROADCAST, 0U);
+        } else {
+            nodes[e.node].crystal_hz += ppm_hz(((double)mesh_sim_uniform(&prng, 2001U) - 1000.0) * WALK_PPM / 1000.0);
+            mesh_sim_at(mesh_sim_now_us() + HOUR_US, e.node, EV_DRIFT, 0U);
+        }
+    }
+    return (double)lost / (heard + lost);
+}
+
+int main(void) {
+    (void)printf("%u nodes, crystals within %.0f ppm (%.0f Hz), %.1f ppm/h walk, second of %u hours\n", NODES,
+                 CRYSTAL_PPM, ppm_hz(CRYSTAL_PPM), WALK_PPM, HOURS);
+    (void)printf("BW Hz   tolerance Hz  PER no AFC  spread Hz  PER AFC  spread Hz\n");
+    for (uint32_t i = 0U; i < sizeof(bandwidths_hz) / sizeof(bandwidths_hz[0]); i++) {
+        double off = run(bandwidths_hz[i], false);
+        double off_spread = spread_hz(false);
+        double on = run(bandwidths_hz[i], true);
+
+        (void)printf("%6u %13u %11.3f %10.0f %8.3f %10.0f\n", bandwidths_hz[i], bandwidths_hz[i] / 4U, off,
+                     off_spread, on, spread_hz(true));
+        CHECK(on <= off);
+        /* the crystals alone lose frames below 31.25 kHz, AFC gets them all down to 15.6 kHz */
+        if (bandwidths_hz[i] < 31250U) {
+            CHECK(off > 0.1);
+        }
+        if (bandwidths_hz[i] >= 15600U) {
+            CHECK(on == 0.0);
+        }
+    }
+    return test_done();
+}
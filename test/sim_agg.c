@@ -0,0 +1,249 @@
+//
+// Created on 10/19/26.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mesh_sim.h"
+#include "RA-02/ra-02_AO.h"
+#include "test.h"
+
+/*
+ * Goodput and airtime of one node's bulk traffic with and without aggregation, under
+ * the duty-cycle limit. Messages arrive Poisson, each for one of 'links' receivers,
+ * as one frame or as a burst of fragments, and queue in the AO's bulk queue
+ * (RA02_TXQ_BULK_LEN, head drop). The sender runs
+ * RA02_tx_next's policy: the head waits up to RA02_AGG_LATENCY_MS while everything
+ * queued is for its receiver and the queue has room; then the run of entries for
+ * that receiver goes out as one frame once the budget of RA02_duty_delay_ms, 16
+ * buckets over RA02_DUTY_WINDOW_MS, has room for it. The channel is clear, so every
+ * frame sent is delivered; what aggregation buys is frames per budget.
+ */
+#define FRAME_LENGTH 16U
+#define HOURS 12U
+#define HOUR_US 3600000000ULL
+
+enum { EV_ARRIVAL, EV_AGG_TIMEOUT, EV_DUTY_TIMEOUT, EV_TX_END };
+
+static RA02_txq_t txq[RA02_TXQ_CLASSES];
+static uint32_t duty_bucket[RA02_DUTY_BUCKETS];
+static uint32_t duty_epoch;
+static uint32_t prng;
+static bool aggregate;
+static uint8_t links;
+static uint8_t burst; /* frames per message */
+static bool deferred;
+static uint8_t on_air; /* entries at the head of the bulk queue being sent */
+static uint32_t timer; /* agg_te: only the last one armed fires */
+static uint32_t delivered;
+static uint64_t airtime_us;
+static uint64_t latency_ms;
+
+static uint32_t now_ms(void) {
+    return (uint32_t)(mesh_sim_now_us() / 1000U);
+}
+
+/* RA02_duty_advance */
+static void duty_advance(uint32_t now) {
+    uint32_t epoch = now / RA02_DUTY_BUCKET_MS;
+    uint32_t steps = epoch - duty_epoch;
+
+    if (steps > RA02_DUTY_BUCKETS) {
+        steps = RA02_DUTY_BUCKETS;
+    }
+    for (uint32_t i = 1U; i <= steps; i++) {
+        duty_bucket[(duty_epoch + i) % RA02_DUTY_BUCKETS] = 0U;
+    }
+    duty_epoch = epoch;
+}
+
+/* RA02_duty_delay_ms */
+static uint32_t duty_delay_ms(uint32_t airtime) {
+    uint32_t now = now_ms();
+    uint32_t used = 0U;
+
+    duty_advance(now);
+    for (uint32_t i = 0U; i < RA02_DUTY_BUCKETS; i++) {
+        used += duty_bucket[i];
+    }
+    for (uint32_t i = 1U; used + airtime > RA02_DUTY_BUDGET_MS; i++) {
+        used -= duty_bucket[(duty_epoch + i) % RA02_DUTY_BUCKETS];
+        if (used + airtime <= RA02_DUTY_BUDGET_MS) {
+            return (duty_epoch + i) * RA02_DUTY_BUCKET_MS - now;
+        }
+    }
+    return 0U;
+}
+
+/* RA02_enqueue_tx on the bulk queue: full, the oldest entry not on the air makes room */
+static void enqueue(uint8_t link) {
+    RA02_txq_t *q = &txq[RA02_TXQ_BULK];
+    uint8_t tail;
+
+    if (q->count >= RA02_TXQ_BULK_LEN) {
+        if (on_air == q->count) {
+            q->dropped++;
+            return;
+        }
+        for (uint8_t i = on_air; i + 1U < q->count; i++) {
+            q->link[RA02_txq_at(q, i)] = q->link[RA02_txq_at(q, i + 1U)];
+            q->queued_ms[RA02_txq_at(q, i)] = q->queued_ms[RA02_txq_at(q, i + 1U)];
+        }
+        q->count--;
+        q->dropped++;
+    }
+    tail = RA02_txq_at(q, q->count);
+    q->length[tail] = FRAME_LENGTH;
+    q->link[tail] = link;
+    q->queued_ms[tail] = now_ms();
+    q->count++;
+}
+
+/* RA02_agg_run */
+static uint8_t agg_run(void) {
+    RA02_txq_t const *q = &txq[RA02_TXQ_BULK];
+    uint8_t n = 1U;
+
+    while (aggregate && n < q->count && q->link[RA02_txq_at(q, n)] == q->link[q->head]) {
+        n++;
+    }
+    return n;
+}
+
+/* RA02_tx_next, less LBT */
+static void tx_next(void) {
+    RA02_txq_t *q = &txq[RA02_TXQ_BULK];
+    uint8_t run;
+    uint32_t waited;
+    uint32_t toa;
+    uint32_t delay;
+
+    if (q->count == 0U) {
+        return;
+    }
+    run = agg_run();
+    waited = now_ms() - q->queued_ms[q->head];
+    if (aggregate && run == q->count && run < RA02_TXQ_BULK_LEN && waited < RA02_AGG_LATENCY_MS) {
+        mesh_sim_at(mesh_sim_now_us() + (RA02_AGG_LATENCY_MS - waited) * 1000ULL, 0U, EV_AGG_TIMEOUT, ++timer);
+        return;
+    }
+    toa = mesh_sim_toa_us(run == 1U ? FRAME_LENGTH : (uint8_t)(1U + run * (1U + FRAME_LENGTH)));
+    delay = duty_delay_ms((toa + 999U) / 1000U);
+    if (delay > 0U) {
+        deferred = true;
+        mesh_sim_at(mesh_sim_now_us() + delay * 1000ULL, 0U, EV_DUTY_TIMEOUT, 0U);
+        return;
+    }
+    timer++;
+    duty_advance(now_ms());
+    duty_bucket[duty_epoch % RA02_DUTY_BUCKETS] += (toa + 999U) / 1000U;
+    on_air = run;
+    airtime_us += toa;
+    mesh_sim_at(mesh_sim_now_us() + toa, 0U, EV_TX_END, run);
+}
+
+static void simulate(double per_hour, uint8_t link_count, uint8_t frames, bool agg) {
+    double mean_us = HOUR_US * frames / per_hour;
+    mesh_sim_event_t e;
+
+    (void)memset(txq, 0, sizeof(txq));
+    (void)memset(duty_bucket, 0, sizeof(duty_bucket));
+    duty_epoch = 0U;
+    prng = 0x6A09E667U;
+    aggregate = agg;
+    links = link_count;
+    burst = frames;
+    deferred = false;
+    on_air = 0U;
+    timer = 0U;
+    delivered = 0U;
+    airtime_us = 0U;
+    latency_ms = 0U;
+    mesh_sim_reset();
+    mesh_sim_at(mesh_sim_exp_us(&prng, mean_us), 0U, EV_ARRIVAL, 0U);
+    while (mesh_sim_next(&e)) {
+        RA02_txq_t *q = &txq[RA02_TXQ_BULK];
+
+        switch (e.kind) {
+            case EV_ARRIVAL: {
+                uint8_t link = (uint8_t)mesh_sim_uniform(&prng, links);
+
+                if (mesh_sim_now_us() < HOURS * HOUR_US) {
+                    mesh_sim_at(mesh_sim_now_us() + mesh_sim_exp_us(&prng, mean_us), 0U, EV_ARRIVAL, 0U);
+                }
+                for (uint8_t i = 0U; i < burst; i++) {
+                    enqueue(link);
+                }
+                if (on_air == 0U && !deferred) {
+                    tx_next();
+                }
+                break;
+            }
+            case EV_AGG_TIMEOUT:
+                if (e.arg == timer && on_air == 0U && !deferred) {
+                    tx_next();
+                }
+                break;
+            case EV_DUTY_TIMEOUT:
+                deferred = false;
+                tx_next();
+                break;
+            case EV_TX_END:
+                for (uint8_t i = 0U; i < e.arg; i++) {
+                    latency_ms += now_ms() - q->queued_ms[RA02_txq_at(q, i)];
+                }
+                delivered += e.arg;
+                RA02_txq_dequeue(txq, RA02_TXQ_BULK, (uint8_t)e.arg);
+                on_air = 0U;
+                tx_next();
+                break;
+        }
+    }
+}
+
+static void row(double per_hour, uint8_t link_count, uint8_t frames, bool agg) {
+    simulate(per_hour, link_count, frames, agg);
+    (void)printf("%5u %6u %8.0f %4s %12.0f %14.1f %11.0f %8.3f\n", link_count, frames, per_hour, agg ? "yes" : "no",
+                 delivered / (double)HOURS, airtime_us / 1e3 / delivered, (double)latency_ms / delivered,
+                 txq[RA02_TXQ_BULK].dropped / (double)(delivered + txq[RA02_TXQ_BULK].dropped));
+}
+
+int main(void) {
+    static double const loads[] = {100.0, 300.0, 600.0, 900.0, 1200.0, 2000.0};
+    static uint8_t const traffic[][2] = {{1U, 1U}, {3U, 1U}, {3U, RA02_TXQ_BULK_LEN}}; /* links, frames per message */
+
+    (void)printf("%u-byte frames (%.1f ms alone), %u %% duty cycle, %u hours\n", FRAME_LENGTH,
+                 mesh_sim_toa_us(FRAME_LENGTH) / 1e3, (uint32_t)(RA02_DUTY_PERMILLE / 10U), HOURS);
+    (void)printf("links burst frames/h  agg  delivered/h  airtime/frame  latency ms  dropped\n");
+    for (uint32_t t = 0U; t < sizeof(traffic) / sizeof(traffic[0]); t++) {
+        for (uint32_t i = 0U; i < sizeof(loads) / sizeof(loads[0]); i++) {
+            uint32_t plain_delivered;
+            double plain_airtime;
+            double plain_latency;
+
+            row(loads[i], traffic[t][0], traffic[t][1], false);
+            plain_delivered = delivered;
+            plain_airtime = airtime_us / (double)delivered;
+            plain_latency = (double)latency_ms / delivered;
+            row(loads[i], traffic[t][0], traffic[t][1], true);
+
+            /* never worse, give or take a head drop, and never more airtime per frame */
+            CHECK(delivered >= 0.99 * plain_delivered);
+            CHECK(airtime_us / (double)delivered <= plain_airtime);
+            if (loads[i] <= 300.0) {
+                /* light load: all but a few go out either way, each frame waits at most RA02_AGG_LATENCY_MS more */
+                CHECK(txq[RA02_TXQ_BULK].dropped <= delivered / 100U);
+                CHECK((double)latency_ms / delivered <= plain_latency + RA02_AGG_LATENCY_MS);
+            }
+            if (traffic[t][1] > 1U) {
+                /* fragments queue together: full aggregates, 38 % less airtime each */
+                CHECK(airtime_us / (double)delivered <= 0.65 * plain_airtime);
+                if (loads[i] >= 1200.0) {
+                    CHECK(delivered >= 1.4 * plain_delivered);
+                }
+            }
+        }
+    }
+    return test_done();
+}
@@ -0,0 +1,121 @@
+//
+// Created on 10/19/26.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mesh_sim.h"
+#include "packet_t.h"
+#include "test.h"
+
+/*
+ * One flooded frame over 30 nodes, with and without the duplicate cache. Every
+ * relay rebroadcasts with max_hops - 1 what it hears with hops left; the cache
+ * lets it do so for the first copy only. The channel is ideal (no collisions, every
+ * copy heard), which is the best case for the flood without the cache: on air the
+ * storm also collides with itself.
+ */
+#define NODES 30U
+
+typedef struct {
+    uint8_t reached; /* nodes but the source that got the frame */
+    uint64_t sent; /* transmissions, the source's included */
+} flood_t;
+
+/* copies sent per node and max_hops field, generation after generation */
+static void flood(mesh_sim_topology_t const *t, uint8_t src, bool cache, flood_t *out) {
+    static uint64_t copies[MESH_MAX_HOPS + 1][MESH_SIM_NODES];
+    bool seen[MESH_SIM_NODES] = {false};
+
+    (void)memset(copies, 0, sizeof(copies));
+    (void)memset(out, 0, sizeof(*out));
+    copies[MESH_MAX_HOPS][src] = 1U;
+    seen[src] = true;
+    for (int h = MESH_MAX_HOPS; h >= 0; h--) {
+        for (uint8_t n = 0U; n < t->count; n++) {
+            if (copies[h][n] == 0U) {
+                continue;
+            }
+            out->sent += copies[h][n];
+            for (uint8_t m = 0U; m < t->count; m++) {
+                if (!t->link[n][m] || m == src) {
+                    continue; /* our own frame, rebroadcast by a neighbor */
+                }
+                if (!seen[m]) {
+                    seen[m] = true;
+                    out->reached++;
+                } else if (cache) {
+                    continue;
+                }
+                if (h > 0) {
+                    copies[h - 1][m] += cache ? 1U : copies[h][n];
+                }
+            }
+        }
+    }
+}
+
+/* the node the flood reaches everybody from in the fewest hops */
+static uint8_t center(mesh_sim_topology_t const *t) {
+    uint8_t best = 0U;
+    uint8_t best_ecc = UINT8_MAX;
+
+    for (uint8_t n = 0U; n < t->count; n++) {
+        uint8_t hops[MESH_SIM_NODES];
+        uint8_t ecc = 0U;
+
+        mesh_sim_hops(t, n, hops);
+        for (uint8_t m = 0U; m < t->count; m++) {
+            ecc = hops[m] > ecc ? hops[m] : ecc;
+        }
+        if (ecc < best_ecc) {
+            best = n;
+            best_ecc = ecc;
+        }
+    }
+    return best;
+}
+
+static void run(char const *name, mesh_sim_topology_t const *t, double min_saved) {
+    double toa_s = mesh_sim_toa_us(PACKET_WIRE_MAX) / 1e6;
+    uint8_t src = center(t);
+    flood_t off;
+    flood_t on;
+    double saved;
+
+    flood(t, src, false, &off);
+    flood(t, src, true, &on);
+    saved = 1.0 - (double)on.sent / (double)off.sent;
+    (void)printf("%-10s %7u %10llu %8llu %12.1f %10.2f %6.1f %%\n", name, on.reached,
+                 (unsigned long long)off.sent, (unsigned long long)on.sent, off.sent * toa_s, on.sent * toa_s,
+                 100.0 * saved);
+
+    /* the cache costs no coverage, sends each frame once per node at most, and saves airtime */
+    CHECK_EQ(on.reached, off.reached);
+    CHECK(on.sent <= t->count);
+    CHECK(saved >= min_saved);
+}
+
+int main(void) {
+    mesh_sim_topology_t t;
+    uint32_t prng = 0x2545F491U;
+
+    (void)printf("one %u-byte frame, %u nodes, max_hops %u, %.1f ms on air per copy\n", PACKET_WIRE_MAX, NODES,
+                 MESH_MAX_HOPS, mesh_sim_toa_us(PACKET_WIRE_MAX) / 1e3);
+    (void)printf("topology   reached  sent:none   :cache   airtime:none     :cache  saved\n");
+    mesh_sim_line(&t, NODES);
+    run("line", &t, 0.5);
+    mesh_sim_grid(&t, 6U, 5U);
+    run("grid 6x5", &t, 0.9);
+    for (uint8_t i = 0U; i < 5U; i++) {
+        char name[16];
+
+        mesh_sim_random(&t, NODES, 0.3, &prng);
+        (void)snprintf(name, sizeof(name), "random %u", i);
+        run(name, &t, 0.9);
+    }
+    mesh_sim_full(&t, NODES);
+    run("full", &t, 0.9);
+    return test_done();
+}
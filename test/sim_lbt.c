@@ -0,0 +1,178 @@
+//
+// Created on 10/19/26.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "mesh_sim.h"
+#include "packet_t.h"
+#include "RA-02/ra-02_AO.h"
+#include "test.h"
+
+/*
+ * Goodput of pure ALOHA against the RA02 AO's listen-before-talk (CAD, then
+ * RA02_backoff_ms up to RA02_LBT_MAX_ATTEMPTS times) as the offered load grows.
+ * Every node gets Poisson traffic for one random neighbor and queues up to
+ * RA02_TXQ_INTERACTIVE_LEN frames; a frame counts when that neighbor heard it.
+ * CAD sees whatever is on air when it ends. Between a clear CAD and the first
+ * symbol on air the AO spends TURNAROUND_US (event dispatch, SPI, PLL), which is
+ * when two nodes can both find the channel clear.
+ */
+#define NODES 20U
+#define FRAME_LENGTH PACKET_WIRE_MAX
+#define TURNAROUND_US 1000U
+#define AIRTIMES 3000U /* simulated time, in frame airtimes */
+
+enum { EV_ARRIVAL, EV_CAD_DONE, EV_TX_START, EV_TX_END };
+
+typedef struct {
+    uint8_t dest[RA02_TXQ_INTERACTIVE_LEN];
+    uint8_t queued;
+    bool radio_busy;
+    uint8_t busy_cads;
+} node_t;
+
+static mesh_sim_topology_t topo;
+static node_t nodes[MESH_SIM_NODES];
+static uint32_t prng;
+static uint32_t delivered;
+static uint32_t offered;
+static uint32_t dropped; /* queue full, or the channel never clear */
+
+static void radio_kick(uint8_t n, bool lbt) {
+    if (nodes[n].radio_busy || nodes[n].queued == 0U) {
+        return;
+    }
+    nodes[n].radio_busy = true;
+    nodes[n].busy_cads = 0U;
+    if (lbt) {
+        mesh_sim_at(mesh_sim_now_us() + mesh_sim_cad_us(), n, EV_CAD_DONE, 0U);
+    } else {
+        mesh_sim_at(mesh_sim_now_us(), n, EV_TX_START, 0U);
+    }
+}
+
+static void radio_pop(uint8_t n, bool lbt) {
+    node_t *me = &nodes[n];
+
+    (void)memmove(&me->dest[0], &me->dest[1], (size_t)(me->queued - 1U));
+    me->queued--;
+    me->radio_busy = false;
+    radio_kick(n, lbt);
+}
+
+static uint8_t random_neighbor(uint8_t n) {
+    uint8_t degree = 0U;
+    uint8_t pick;
+
+    for (uint8_t m = 0U; m < topo.count; m++) {
+        degree += topo.link[n][m] ? 1U : 0U;
+    }
+    pick = (uint8_t)mesh_sim_uniform(&prng, degree);
+    for (uint8_t m = 0U;; m++) {
+        if (topo.link[n][m] && pick-- == 0U) {
+            return m;
+        }
+    }
+}
+
+static void step(mesh_sim_event_t const *e, bool lbt, double mean_gap_us) {
+    node_t *me = &nodes[e->node];
+    uint32_t toa = mesh_sim_toa_us(FRAME_LENGTH);
+
+    switch (e->kind) {
+        case EV_ARRIVAL:
+            offered++;
+            if (me->queued == RA02_TXQ_INTERACTIVE_LEN) {
+                dropped++;
+            } else {
+                me->dest[me->queued++] = random_neighbor(e->node);
+                radio_kick(e->node, lbt);
+            }
+            if (mesh_sim_now_us() < (uint64_t)AIRTIMES * toa) {
+                mesh_sim_at(mesh_sim_now_us() + mesh_sim_exp_us(&prng, mean_gap_us), e->node, EV_ARRIVAL, 0U);
+            }
+            break;
+        case EV_CAD_DONE:
+            if (!mesh_sim_busy(&topo, e->node)) {
+                mesh_sim_at(mesh_sim_now_us() + TURNAROUND_US, e->node, EV_TX_START, 0U);
+            } else if (++me->busy_cads >= RA02_LBT_MAX_ATTEMPTS) {
+                dropped++;
+                radio_pop(e->node, lbt);
+            } else {
+                mesh_sim_at(mesh_sim_now_us() + mesh_sim_backoff_us(&prng, me->busy_cads) + mesh_sim_cad_us(),
+                            e->node, EV_CAD_DONE, 0U);
+            }
+            break;
+        case EV_TX_START:
+            mesh_sim_at(mesh_sim_now_us() + toa, e->node, EV_TX_END, mesh_sim_send(e->node, toa));
+            break;
+        case EV_TX_END:
+            delivered += mesh_sim_heard(&topo, e->arg, me->dest[0]) ? 1U : 0U;
+            radio_pop(e->node, lbt);
+            break;
+        default:
+            break;
+    }
+}
+
+typedef struct {
+    double goodput; /* delivered airtime per unit time */
+    double dropped; /* of the offered frames */
+} result_t;
+
+/* load: offered frames per frame airtime, over all nodes */
+static result_t run(bool lbt, double load) {
+    double toa = mesh_sim_toa_us(FRAME_LENGTH);
+    double mean_gap_us = toa * topo.count / load;
+    mesh_sim_event_t e;
+
+    (void)memset(nodes, 0, sizeof(nodes));
+    prng = 0x6A09E667U;
+    delivered = 0U;
+    offered = 0U;
+    dropped = 0U;
+    mesh_sim_reset();
+    for (uint8_t n = 0U; n < topo.count; n++) {
+        mesh_sim_at(mesh_sim_exp_us(&prng, mean_gap_us), n, EV_ARRIVAL, 0U);
+    }
+    while (mesh_sim_next(&e)) {
+        step(&e, lbt, mean_gap_us);
+    }
+    return (result_t){delivered * toa / (double)mesh_sim_now_us(), (double)dropped / offered};
+}
+
+static void sweep(char const *name, double min_gain) {
+    static double const loads[] = {0.1, 0.25, 0.5, 1.0, 2.0, 4.0};
+    double aloha_peak = 0.0;
+    double lbt_peak = 0.0;
+
+    (void)printf("%s\n  load   ALOHA goodput  dropped   LBT goodput  dropped\n", name);
+    for (uint8_t i = 0U; i < sizeof(loads) / sizeof(loads[0]); i++) {
+        result_t aloha = run(false, loads[i]);
+        result_t lbt = run(true, loads[i]);
+
+        (void)printf("  %4.2f   %13.3f  %7.3f   %11.3f  %7.3f\n", loads[i], aloha.goodput, aloha.dropped,
+                     lbt.goodput, lbt.dropped);
+        aloha_peak = aloha.goodput > aloha_peak ? aloha.goodput : aloha_peak;
+        lbt_peak = lbt.goodput > lbt_peak ? lbt.goodput : lbt_peak;
+        if (loads[i] >= 0.5) {
+            CHECK(lbt.goodput > aloha.goodput);
+        }
+    }
+    CHECK(lbt_peak >= min_gain * aloha_peak);
+}
+
+int main(void) {
+    uint32_t seed = 0xBB67AE85U;
+
+    (void)printf("%u nodes, %u-byte frames (%.1f ms), CAD %.2f ms, turnaround %.1f ms; load in frames per airtime\n",
+                 NODES, FRAME_LENGTH, mesh_sim_toa_us(FRAME_LENGTH) / 1e3, mesh_sim_cad_us() / 1e3,
+                 TURNAROUND_US / 1e3);
+    mesh_sim_full(&topo, NODES);
+    sweep("one collision domain", 2.0);
+    mesh_sim_random(&topo, NODES, 0.35, &seed);
+    sweep("random mesh, hidden terminals", 1.2);
+    return test_done();
+}
@@ -0,0 +1,128 @@
+//
+// Created on 10/19/26.
+//
+
+#include <stdio.h>
+
+#include "LoRa/LoRa.h"
+#include "mesh_sim.h"
+#include "RA-02/ra-02_AO.h"
+#include "test.h"
+
+/*
+ * Low-power listening as the RA02 AO runs it: asleep, every wake interval one CAD,
+ * every frame behind a preamble of the wake interval plus 4 symbols. The energy
+ * side takes the SX1278 datasheet currents, the timing side runs receivers with a
+ * random wake phase against senders starting at random and counts the frames whose
+ * preamble no CAD lands in.
+ */
+#define SLEEP_UA 0.2
+#define STANDBY_MA 1.6
+#define RX_MA 10.8 /* CAD draws what RX does */
+#define TX_MA 87.0 /* 17 dBm */
+#define STARTUP_US 250U /* oscillator, sleep to standby, before the CAD */
+#define LATENCY_US 200U /* CadDone to the radio asleep and wake_te armed */
+#define FRAME_LENGTH 16U
+#define DAY_MS 86400000.0
+#define TRIALS 20000U
+
+static uint32_t const wake_ms[] = {100U, 250U, 500U, 1000U, 2000U, 5000U};
+
+/* RA02_lpl_preamble */
+static uint16_t lpl_preamble(uint8_t sf, uint32_t wake) {
+    uint32_t tsym_us = LoRa_symbolTime(sf, BW_125KHz);
+
+    return (uint16_t)((wake * 1000UL + tsym_us - 1U) / tsym_us + 4U);
+}
+
+static uint32_t toa_us(uint8_t sf, uint16_t preamble) {
+    LoRa lora = newLoRa();
+
+    lora.spredingFactor = sf;
+    lora.preamble = preamble;
+    return LoRa_packetTimeOnAir(&lora, FRAME_LENGTH);
+}
+
+/* mAh a day with nothing on the air: one CAD per wake interval, asleep in between */
+static double idle_mah(uint32_t wake) {
+    double cad_ms = mesh_sim_cad_us() / 1e3;
+    double per_wake = STARTUP_US / 1e3 * STANDBY_MA + cad_ms * RX_MA;
+
+    return (DAY_MS / wake * per_wake + DAY_MS * SLEEP_UA / 1e3) / 3.6e6;
+}
+
+/*
+ * Fraction of frames a sleeping receiver wakes up for. Its CADs come a wake interval
+ * apart, give or take a TimeEvent tick early and some dispatch latency late; a CAD
+ * catches the frame if both its symbols fall inside the preamble on air, which is
+ * 4.25 symbols longer than the programmed one.
+ */
+static double caught(uint8_t sf, uint32_t wake, uint16_t preamble) {
+    uint32_t tsym_us = LoRa_symbolTime(sf, BW_125KHz);
+    uint32_t cad_us = 2U * tsym_us;
+    uint64_t air_us = (4U * (uint64_t)preamble + 17U) * tsym_us / 4U;
+    uint32_t prng = 0x9E3779B9U;
+    uint32_t hits = 0U;
+
+    for (uint32_t i = 0U; i < TRIALS; i++) {
+        uint64_t start = (1U + mesh_sim_uniform(&prng, 4U)) * wake * 1000ULL + mesh_sim_uniform(&prng, wake * 1000U);
+        uint64_t cad = mesh_sim_uniform(&prng, wake * 1000U);
+
+        while (cad < start + air_us) {
+            cad += STARTUP_US;
+            if (cad >= start && cad + cad_us <= start + air_us) {
+                hits++;
+                break;
+            }
+            cad += cad_us + mesh_sim_uniform(&prng, LATENCY_US) + wake * 1000U - mesh_sim_uniform(&prng, 1000U);
+        }
+    }
+    return (double)hits / TRIALS;
+}
+
+int main(void) {
+    uint32_t tsym_us = LoRa_symbolTime(SF_7, BW_125KHz);
+    uint16_t shortest;
+
+    (void)printf("%u-byte frames at SF7/125 kHz, RX %.1f mA, standby %.1f mA, sleep %.1f uA, TX %.0f mA\n",
+                 FRAME_LENGTH, RX_MA, STANDBY_MA, SLEEP_UA, TX_MA);
+    (void)printf("wake ms  preamble  idle mAh/day  TX mAh/frame  frames/h at 1 %%  caught SF7  SF12\n");
+    for (uint32_t i = 0U; i < sizeof(wake_ms) / sizeof(wake_ms[0]); i++) {
+        uint16_t preamble = lpl_preamble(SF_7, wake_ms[i]);
+        uint32_t toa = toa_us(SF_7, preamble);
+        double sf7 = caught(SF_7, wake_ms[i], preamble);
+        double sf12 = caught(SF_12, wake_ms[i], lpl_preamble(SF_12, wake_ms[i]));
+
+        (void)printf("%7u %9u %13.2f %13.4f %16u %11.3f %5.3f\n", wake_ms[i], preamble, idle_mah(wake_ms[i]),
+                     toa / 1e3 * TX_MA / 3.6e6, (uint32_t)(RA02_DUTY_WINDOW_MS * RA02_DUTY_PERMILLE / toa),
+                     sf7, sf12);
+        /* a preamble of the wake interval plus 4 symbols never slips between two CADs */
+        CHECK(sf7 == 1.0);
+        CHECK(sf12 == 1.0);
+        /* the longer the interval, the cheaper the idle and the dearer each frame */
+        if (i > 0U) {
+            CHECK(idle_mah(wake_ms[i]) < idle_mah(wake_ms[i - 1U]));
+            CHECK(toa > toa_us(SF_7, lpl_preamble(SF_7, wake_ms[i - 1U])));
+        }
+    }
+    (void)printf("RXCONTIN %.1f mAh/day\n", DAY_MS * RX_MA / 3.6e6);
+    CHECK(idle_mah(RA02_LPL_WAKE_MS) < DAY_MS * RX_MA / 3.6e6 / 100.0);
+
+    /* shorter preambles: half the interval catches about half, the plain 8 symbols next to nothing */
+    (void)printf("wake %u ms, preamble of half of it: %.3f caught, of 8 symbols: %.3f\n", RA02_LPL_WAKE_MS,
+                 caught(SF_7, RA02_LPL_WAKE_MS, (uint16_t)(RA02_LPL_WAKE_MS * 500U / tsym_us)),
+                 caught(SF_7, RA02_LPL_WAKE_MS, 8U));
+    CHECK(caught(SF_7, RA02_LPL_WAKE_MS, (uint16_t)(RA02_LPL_WAKE_MS * 500U / tsym_us)) < 0.6);
+    CHECK(caught(SF_7, RA02_LPL_WAKE_MS, (uint16_t)(RA02_LPL_WAKE_MS * 500U / tsym_us)) > 0.4);
+    CHECK(caught(SF_7, RA02_LPL_WAKE_MS, 8U) < 0.02);
+    /* the shortest preamble that still catches everything: the AO's keeps a margin of a few symbols on it */
+    shortest = lpl_preamble(SF_7, RA02_LPL_WAKE_MS);
+    while (caught(SF_7, RA02_LPL_WAKE_MS, (uint16_t)(shortest - 1U)) == 1.0) {
+        shortest--;
+    }
+    (void)printf("shortest preamble never missed: %u symbols, the AO sends %u\n", shortest,
+                 lpl_preamble(SF_7, RA02_LPL_WAKE_MS));
+    CHECK(shortest < lpl_preamble(SF_7, RA02_LPL_WAKE_MS));
+    CHECK(shortest + 8U >= (uint32_t)lpl_preamble(SF_7, RA02_LPL_WAKE_MS));
+    return test_done();
+}
@@ -0,0 +1,204 @@
+//
+// Created on 10/19/26.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mesh_sim.h"
+#include "packet_t.h"
+#include "ra-02_tdma.h"
+#include "test.h"
+
+/*
+ * The beacon-synchronised TDMA of ra-02_tdma.c against pure ALOHA, with every node
+ * sending one frame per superframe to the coordinator. TDMA nodes run the AO's
+ * slot logic on their own clocks: up to RA02_TDMA_DRIFT_PPM off the coordinator's,
+ * an RxDone stamp up to STAMP_JITTER_US late, a 1 ms TimeEvent tick that can fire
+ * up to a tick early. ALOHA nodes pick a random time in the superframe. Everybody
+ * hears everybody.
+ */
+#define SUPERFRAMES 20U
+#define STAMP_JITTER_US 100U
+#define FRAME_LENGTH PACKET_WIRE_MAX
+
+enum { EV_BEACON, EV_BEACON_END, EV_SLOT, EV_TX_END };
+
+typedef struct {
+    RA02_tdma_t tdma;
+    double ppm;
+    double offset_us;
+} node_t;
+
+static mesh_sim_topology_t topo;
+static node_t nodes[MESH_SIM_NODES];
+static uint32_t prng;
+static uint32_t toa_us;
+static uint32_t sent;
+static uint32_t delivered;
+static uint32_t out_of_slot;
+static uint64_t superframe_start_us; /* coordinator time */
+
+static uint32_t local_us(node_t const *n, uint64_t true_us) {
+    return (uint32_t)llround((double)true_us * (1.0 + n->ppm * 1e-6) + n->offset_us);
+}
+
+static uint64_t true_us(node_t const *n, uint32_t local) {
+    return (uint64_t)llround(((double)local - n->offset_us) / (1.0 + n->ppm * 1e-6));
+}
+
+/* RA02_tdma_schedule: a TimeEvent for the slot, it fires up to a tick early */
+static void slot_arm(uint8_t id) {
+    node_t *me = &nodes[id];
+    uint32_t now = local_us(me, mesh_sim_now_us());
+    uint32_t delay_us;
+
+    if (RA02_tdma_tx_delay_us(&me->tdma, id, toa_us, now, &delay_us)) {
+        uint32_t fire = now + (delay_us + 999U) / 1000U * 1000U - mesh_sim_uniform(&prng, 1000U);
+
+        mesh_sim_at(true_us(me, fire), id, EV_SLOT, 0U);
+    }
+}
+
+static void tdma_step(mesh_sim_event_t const *e) {
+    node_t *me = &nodes[e->node];
+    RA02_tdma_t *coordinator = &nodes[RA02_TDMA_COORDINATOR_ID].tdma;
+    uint32_t guard_us = (coordinator->slot_us - toa_us) / 2U;
+
+    switch (e->kind) {
+        case EV_BEACON:
+            /* centred in slot 0 */
+            superframe_start_us = mesh_sim_now_us() - guard_us;
+            mesh_sim_at(mesh_sim_now_us() + toa_us, e->node, EV_BEACON_END, mesh_sim_send(e->node, toa_us));
+            if (e->arg + 1U < SUPERFRAMES) {
+                mesh_sim_at(mesh_sim_now_us() + RA02_tdma_superframe_us(coordinator), e->node, EV_BEACON,
+                            e->arg + 1U);
+            }
+            break;
+        case EV_BEACON_END:
+            for (uint8_t id = 1U; id < topo.count; id++) {
+                if (mesh_sim_heard(&topo, e->arg, id)) {
+                    uint8_t payload[MESH_MAX_PAYLOAD];
+
+                    RA02_tdma_write_beacon(coordinator, payload);
+                    RA02_tdma_read_beacon(&nodes[id].tdma, payload);
+                    RA02_tdma_sync(&nodes[id].tdma,
+                                   local_us(&nodes[id], mesh_sim_now_us()) + mesh_sim_uniform(&prng, STAMP_JITTER_US),
+                                   toa_us);
+                    slot_arm(id);
+                }
+            }
+            break;
+        case EV_SLOT: {
+            uint32_t delay_us;
+            uint64_t slot_start = superframe_start_us + (uint64_t)(1U + e->node % (coordinator->slot_count - 1U))
+                                                        * coordinator->slot_us;
+
+            /* RA02_SLOT_MODE: only go while the slot lasts */
+            if (RA02_tdma_tx_delay_us(&me->tdma, e->node, toa_us, local_us(me, mesh_sim_now_us()), &delay_us)
+                && delay_us < 1000U) {
+                sent++;
+                if (mesh_sim_now_us() < slot_start
+                    || mesh_sim_now_us() + toa_us > slot_start + coordinator->slot_us) {
+                    out_of_slot++;
+                }
+                mesh_sim_at(mesh_sim_now_us() + toa_us, e->node, EV_TX_END, mesh_sim_send(e->node, toa_us));
+            }
+            break;
+        }
+        case EV_TX_END:
+            delivered += mesh_sim_heard(&topo, e->arg, RA02_TDMA_COORDINATOR_ID) ? 1U : 0U;
+            break;
+        default:
+            break;
+    }
+}
+
+static void reset(uint8_t count) {
+    mesh_sim_full(&topo, (uint8_t)(count + 1U));
+    (void)memset(nodes, 0, sizeof(nodes));
+    prng = 0x3C6EF372U;
+    sent = 0U;
+    delivered = 0U;
+    out_of_slot = 0U;
+    mesh_sim_reset();
+    toa_us = mesh_sim_toa_us(FRAME_LENGTH);
+    RA02_tdma_init(&nodes[RA02_TDMA_COORDINATOR_ID].tdma, toa_us);
+    for (uint8_t id = 1U; id <= count; id++) {
+        nodes[id].ppm = ((double)mesh_sim_uniform(&prng, 2001U) - 1000.0) * RA02_TDMA_DRIFT_PPM / 1000.0;
+        nodes[id].offset_us = mesh_sim_uniform(&prng, 1000000000U);
+    }
+}
+
+static void tdma(uint8_t count) {
+    mesh_sim_event_t e;
+
+    reset(count);
+    mesh_sim_at((nodes[RA02_TDMA_COORDINATOR_ID].tdma.slot_us - toa_us) / 2U, RA02_TDMA_COORDINATOR_ID, EV_BEACON, 0U);
+    while (mesh_sim_next(&e)) {
+        tdma_step(&e);
+    }
+}
+
+static void aloha(uint8_t count) {
+    uint32_t superframe_us;
+    mesh_sim_event_t e;
+
+    reset(count);
+    superframe_us = RA02_tdma_superframe_us(&nodes[RA02_TDMA_COORDINATOR_ID].tdma);
+    for (uint32_t s = 0U; s < SUPERFRAMES; s++) {
+        for (uint8_t id = 1U; id <= count; id++) {
+            mesh_sim_at((uint64_t)s * superframe_us + mesh_sim_uniform(&prng, superframe_us), id, EV_SLOT, 0U);
+        }
+    }
+    while (mesh_sim_next(&e)) {
+        if (e.kind == EV_SLOT) {
+            sent++;
+            mesh_sim_at(mesh_sim_now_us() + toa_us, e.node, EV_TX_END, mesh_sim_send(e.node, toa_us));
+        } else {
+            delivered += mesh_sim_heard(&topo, e.arg, RA02_TDMA_COORDINATOR_ID) ? 1U : 0U;
+        }
+    }
+}
+
+static void row(char const *name, uint8_t count) {
+    uint32_t superframe_us = RA02_tdma_superframe_us(&nodes[RA02_TDMA_COORDINATOR_ID].tdma);
+    double wanted = (double)count * SUPERFRAMES;
+
+    (void)printf("%-6s %5u %9.3f %12.3f %12u\n", name, count, delivered / wanted,
+                 delivered * (double)toa_us / ((double)superframe_us * SUPERFRAMES), out_of_slot);
+}
+
+int main(void) {
+    uint32_t tdma_delivered;
+
+    reset(1U);
+    (void)printf("%u-byte frames (%.1f ms), %u slots of %.1f ms, superframe %.2f s, %u superframes\n",
+                 FRAME_LENGTH, toa_us / 1e3, RA02_TDMA_SLOT_COUNT,
+                 nodes[RA02_TDMA_COORDINATOR_ID].tdma.slot_us / 1e3,
+                 RA02_tdma_superframe_us(&nodes[RA02_TDMA_COORDINATOR_ID].tdma) / 1e6, SUPERFRAMES);
+    (void)printf("MAC    nodes  delivered  utilization  out of slot\n");
+
+    /* 50 nodes: every frame in its own slot, despite drift and tick jitter */
+    tdma(50U);
+    row("TDMA", 50U);
+    CHECK_EQ(sent, 50U * SUPERFRAMES);
+    CHECK_EQ(delivered, sent);
+    CHECK_EQ(out_of_slot, 0U);
+    tdma_delivered = delivered;
+    aloha(50U);
+    row("ALOHA", 50U);
+    CHECK(delivered < 0.7 * tdma_delivered);
+
+    /* every slot taken, the most TDMA carries */
+    tdma(RA02_TDMA_SLOT_COUNT - 1U);
+    row("TDMA", RA02_TDMA_SLOT_COUNT - 1U);
+    CHECK_EQ(delivered, (RA02_TDMA_SLOT_COUNT - 1U) * SUPERFRAMES);
+    CHECK_EQ(out_of_slot, 0U);
+    tdma_delivered = delivered;
+    aloha(RA02_TDMA_SLOT_COUNT - 1U);
+    row("ALOHA", RA02_TDMA_SLOT_COUNT - 1U);
+    CHECK(delivered < 0.5 * tdma_delivered);
+    return test_done();
+}
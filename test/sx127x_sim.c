@@ -0,0 +1,460 @@
+//
+// Created on 10/19/26.
+//
+
+#include "sx127x_sim.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "task.h"
+
+/* SX1276/77/78 datasheet, LoRa register map */
+#define SX_FIFO 0x00U
+#define SX_OP_MODE 0x01U
+#define SX_FRF_MSB 0x06U
+#define SX_FRF_MID 0x07U
+#define SX_FRF_LSB 0x08U
+#define SX_FIFO_ADDR_PTR 0x0DU
+#define SX_FIFO_TX_BASE 0x0EU
+#define SX_FIFO_RX_BASE 0x0FU
+#define SX_FIFO_RX_CURRENT 0x10U
+#define SX_IRQ_FLAGS_MASK 0x11U
+#define SX_IRQ_FLAGS 0x12U
+#define SX_RX_NB_BYTES 0x13U
+#define SX_PKT_SNR 0x19U
+#define SX_PKT_RSSI 0x1AU
+#define SX_MODEM_CONFIG1 0x1DU
+#define SX_MODEM_CONFIG2 0x1EU
+#define SX_PREAMBLE_MSB 0x20U
+#define SX_PREAMBLE_LSB 0x21U
+#define SX_PAYLOAD_LENGTH 0x22U
+#define SX_FIFO_RX_BYTE_ADDR 0x25U
+#define SX_MODEM_CONFIG3 0x26U
+#define SX_FEI_MSB 0x28U
+#define SX_FEI_MID 0x29U
+#define SX_FEI_LSB 0x2AU
+#define SX_RSSI_WIDEBAND 0x2CU
+#define SX_DIO_MAPPING1 0x40U
+#define SX_VERSION 0x42U
+
+#define SX_FXOSC_HZ 32e6
+
+#define SX_LONG_RANGE 0x80U
+#define SX_MODE_MASK 0x07U
+#define SX_MODE_SLEEP 0x00U
+#define SX_MODE_STDBY 0x01U
+#define SX_MODE_TX 0x03U
+#define SX_MODE_RXCONT 0x05U
+#define SX_MODE_RXSINGLE 0x06U
+#define SX_MODE_CAD 0x07U
+
+#define SX_IRQ_RX_DONE 0x40U
+#define SX_IRQ_CRC_ERROR 0x20U
+#define SX_IRQ_VALID_HEADER 0x10U
+#define SX_IRQ_TX_DONE 0x08U
+#define SX_IRQ_CAD_DONE 0x04U
+#define SX_IRQ_CAD_DETECTED 0x01U
+
+/* reset values the driver depends on, the rest of the map resets to 0 here */
+static uint8_t const sx_reset_values[][2] = {
+    {SX_OP_MODE, 0x09U}, /* FSK/OOK, standby */
+    {SX_FRF_MSB, 0x6CU}, {SX_FRF_MID, 0x80U}, {SX_FRF_LSB, 0x00U}, /* 434 MHz */
+    {0x09U, 0x4FU}, {0x0BU, 0x2BU}, {0x0CU, 0x20U},
+    {SX_FIFO_TX_BASE, 0x80U}, {SX_FIFO_RX_BASE, 0x00U},
+    {0x1DU, 0x72U}, {0x1EU, 0x70U}, {0x1FU, 0x64U}, {0x20U, 0x00U}, {0x21U, 0x08U},
+    {SX_PAYLOAD_LENGTH, 0x01U}, {0x26U, 0x04U}, {0x39U, 0x12U},
+    {SX_VERSION, 0x12U},
+};
+
+SPI_HandleTypeDef sx127x_sim_spi;
+
+static sx127x_sim_t *sims[SX127X_SIM_MAX];
+static uint8_t sim_count;
+static uint32_t now_us;
+static uint64_t nvic_enabled; /* bit per IRQn */
+static uint32_t ipsr;
+static BaseType_t scheduler = taskSCHEDULER_RUNNING;
+static uint32_t suspended;
+static uint32_t rssi_noise = 0x2545F491UL;
+
+static bool sim_in_reset(sx127x_sim_t const *sim) {
+    return (sim->port.odr & SX127X_SIM_NRESET) == 0U;
+}
+
+static void sim_power_on(sx127x_sim_t *sim) {
+    (void)memset(sim->reg, 0, sizeof(sim->reg));
+    (void)memset(sim->fifo, 0, sizeof(sim->fifo));
+    for (size_t i = 0U; i < sizeof(sx_reset_values) / sizeof(sx_reset_values[0]); i++) {
+        sim->reg[sx_reset_values[i][0]] = sx_reset_values[i][1];
+    }
+}
+
+void sx127x_sim_init(sx127x_sim_t *sim) {
+    (void)memset(sim, 0, sizeof(*sim));
+    sim->port.sim = sim;
+    sim->port.odr = SX127X_SIM_NSS | SX127X_SIM_NRESET;
+    sim_power_on(sim);
+    if (sim_count < SX127X_SIM_MAX) {
+        sims[sim_count++] = sim;
+    } else {
+        sim->errors++;
+    }
+}
+
+void sx127x_sim_reset_all(void) {
+    sim_count = 0U;
+    now_us = 0U;
+    nvic_enabled = 0U;
+    ipsr = 0U;
+    scheduler = taskSCHEDULER_RUNNING;
+    suspended = 0U;
+}
+
+uint32_t sx127x_sim_now_us(void) {
+    return now_us;
+}
+
+uint8_t sx127x_sim_mode(sx127x_sim_t const *sim) {
+    return sim->reg[SX_OP_MODE] & SX_MODE_MASK;
+}
+
+static bool sim_lora(sx127x_sim_t const *sim) {
+    return (sim->reg[SX_OP_MODE] & SX_LONG_RANGE) != 0U;
+}
+
+static void sim_irq(sx127x_sim_t *sim, uint8_t flags) {
+    sim->reg[SX_IRQ_FLAGS] |= flags & (uint8_t)~sim->reg[SX_IRQ_FLAGS_MASK];
+}
+
+static double sim_bw_hz(sx127x_sim_t const *sim) {
+    static double const bw_hz[10] = {7812.5, 10416.7, 15625.0, 20833.3, 31250.0,
+                                     41666.7, 62500.0, 125000.0, 250000.0, 500000.0};
+    uint8_t bw = sim->reg[SX_MODEM_CONFIG1] >> 4;
+
+    return bw_hz[bw < 10U ? bw : 9U];
+}
+
+static double sim_symbol_us(sx127x_sim_t const *sim) {
+    uint8_t sf = sim->reg[SX_MODEM_CONFIG2] >> 4;
+
+    return ldexp(1.0, sf) * 1e6 / sim_bw_hz(sim);
+}
+
+/* RegFrMsb..Lsb in Hz, Fstep = 32 MHz / 2^19 */
+static double sim_carrier_hz(sx127x_sim_t const *sim) {
+    uint32_t frf = ((uint32_t)sim->reg[SX_FRF_MSB] << 16) | ((uint32_t)sim->reg[SX_FRF_MID] << 8)
+                   | sim->reg[SX_FRF_LSB];
+
+    return ldexp(frf * SX_FXOSC_HZ, -19);
+}
+
+/* Ferr = FreqError * 2^24 / Fxosc * BW / 500 kHz, the other way round */
+int32_t sx127x_sim_fei(sx127x_sim_t const *rx, sx127x_sim_t const *tx) {
+    double ferr = sim_carrier_hz(tx) - sim_carrier_hz(rx);
+
+    return (int32_t)lround(ldexp(ferr * SX_FXOSC_HZ, -24) * 500000.0 / sim_bw_hz(rx));
+}
+
+/* the datasheet formula, from the registers the chip modulates with */
+uint32_t sx127x_sim_toa_us(sx127x_sim_t const *sim, uint8_t length) {
+    uint8_t sf = sim->reg[SX_MODEM_CONFIG2] >> 4;
+    uint8_t cr = (sim->reg[SX_MODEM_CONFIG1] >> 1) & 0x07U;
+    bool implicit = (sim->reg[SX_MODEM_CONFIG1] & 0x01U) != 0U;
+    bool crc = (sim->reg[SX_MODEM_CONFIG2] & 0x04U) != 0U;
+    bool ldro = (sim->reg[SX_MODEM_CONFIG3] & 0x08U) != 0U;
+    uint16_t preamble = (uint16_t)((sim->reg[SX_PREAMBLE_MSB] << 8) | sim->reg[SX_PREAMBLE_LSB]);
+    double payload = ceil((8.0 * length - 4.0 * sf + 28.0 + (crc ? 16.0 : 0.0) - (implicit ? 20.0 : 0.0))
+                          / (4.0 * (sf - (ldro ? 2.0 : 0.0))));
+
+    payload = 8.0 + (payload > 0.0 ? payload * (cr + 4U) : 0.0);
+    return (uint32_t)((preamble + 4.25 + payload) * sim_symbol_us(sim));
+}
+
+bool sx127x_sim_dio0(sx127x_sim_t const *sim) {
+    static uint8_t const source[4] = {SX_IRQ_RX_DONE, SX_IRQ_TX_DONE, SX_IRQ_CAD_DONE, 0U};
+
+    return (sim->reg[SX_IRQ_FLAGS] & source[sim->reg[SX_DIO_MAPPING1] >> 6]) != 0U;
+}
+
+/*..........................................................................................*/
+
+static void sim_op_mode(sx127x_sim_t *sim, uint8_t value) {
+    uint8_t old = sx127x_sim_mode(sim);
+    uint8_t mode = value & SX_MODE_MASK;
+
+    if (old != SX_MODE_SLEEP) {
+        value = (uint8_t)((value & (uint8_t)~SX_LONG_RANGE) | (sim->reg[SX_OP_MODE] & SX_LONG_RANGE));
+    }
+    sim->reg[SX_OP_MODE] = value;
+    if (mode == old) {
+        return;
+    }
+    if (mode == SX_MODE_SLEEP) {
+        (void)memset(sim->fifo, 0, sizeof(sim->fifo));
+    } else if (mode == SX_MODE_RXCONT || mode == SX_MODE_RXSINGLE) {
+        sim->reg[SX_FIFO_RX_BYTE_ADDR] = sim->reg[SX_FIFO_RX_BASE];
+    } else if (mode == SX_MODE_TX) {
+        /* what goes on the air is latched now, the FiFo may change meanwhile */
+        sim->tx_length = sim->reg[SX_PAYLOAD_LENGTH];
+        for (uint16_t i = 0U; i < sim->tx_length; i++) {
+            sim->tx[i] = sim->fifo[(uint8_t)(sim->reg[SX_FIFO_TX_BASE] + i)];
+        }
+        sim->done_us = now_us + sx127x_sim_toa_us(sim, sim->tx_length);
+    } else if (mode == SX_MODE_CAD) {
+        sim->done_us = now_us + (uint32_t)(2.0 * sim_symbol_us(sim));
+    }
+}
+
+static void sim_write(sx127x_sim_t *sim, uint8_t addr, uint8_t value) {
+    switch (addr) {
+        case SX_FIFO:
+            sim->fifo[sim->reg[SX_FIFO_ADDR_PTR]++] = value;
+            break;
+        case SX_OP_MODE:
+            sim_op_mode(sim, value);
+            break;
+        case SX_IRQ_FLAGS:
+            sim->reg[SX_IRQ_FLAGS] &= (uint8_t)~value;
+            break;
+        case SX_FIFO_RX_CURRENT:
+        case SX_RX_NB_BYTES:
+        case SX_PKT_SNR:
+        case SX_PKT_RSSI:
+        case SX_FIFO_RX_BYTE_ADDR:
+        case SX_FEI_MSB:
+        case SX_FEI_MID:
+        case SX_FEI_LSB:
+        case SX_RSSI_WIDEBAND:
+        case SX_VERSION:
+            break; /* read only */
+        default:
+            sim->reg[addr] = value;
+            break;
+    }
+}
+
+static uint8_t sim_read(sx127x_sim_t *sim, uint8_t addr) {
+    if (addr == SX_FIFO) {
+        return sim->fifo[sim->reg[SX_FIFO_ADDR_PTR]++];
+    }
+    if (addr == SX_RSSI_WIDEBAND) {
+        rssi_noise ^= rssi_noise << 13;
+        rssi_noise ^= rssi_noise >> 17;
+        rssi_noise ^= rssi_noise << 5;
+        return (uint8_t)rssi_noise;
+    }
+    return sim->reg[addr];
+}
+
+bool sx127x_sim_receive(sx127x_sim_t *sim, uint8_t const *data, uint8_t length, sx127x_sim_rx_t const *rx) {
+    static sx127x_sim_rx_t const clean = {40, 100, 0, false}; /* +10 dB, -64 dBm */
+    uint8_t mode = sx127x_sim_mode(sim);
+    uint8_t start = sim->reg[SX_FIFO_RX_BYTE_ADDR];
+
+    if (rx == NULL) {
+        rx = &clean;
+    }
+    if (sim_in_reset(sim) || !sim_lora(sim) || (mode != SX_MODE_RXCONT && mode != SX_MODE_RXSINGLE)) {
+        return false;
+    }
+    for (uint8_t i = 0U; i < length; i++) {
+        sim->fifo[(uint8_t)(start + i)] = data[i];
+    }
+    sim->reg[SX_FIFO_RX_BYTE_ADDR] = (uint8_t)(start + length);
+    sim->reg[SX_FIFO_RX_CURRENT] = start;
+    sim->reg[SX_RX_NB_BYTES] = length;
+    sim->reg[SX_PKT_SNR] = (uint8_t)rx->snr;
+    sim->reg[SX_PKT_RSSI] = rx->rssi;
+    sim->reg[SX_FEI_MSB] = (uint8_t)(((uint32_t)rx->fei >> 16) & 0x0FU);
+    sim->reg[SX_FEI_MID] = (uint8_t)((uint32_t)rx->fei >> 8);
+    sim->reg[SX_FEI_LSB] = (uint8_t)rx->fei;
+    sim_irq(sim, SX_IRQ_RX_DONE | SX_IRQ_VALID_HEADER | (rx->crc_error ? SX_IRQ_CRC_ERROR : 0U));
+    if (mode == SX_MODE_RXSINGLE) {
+        sim->reg[SX_OP_MODE] = (uint8_t)((sim->reg[SX_OP_MODE] & (uint8_t)~SX_MODE_MASK) | SX_MODE_STDBY);
+    }
+    return true;
+}
+
+void sx127x_sim_advance(uint32_t us) {
+    now_us += us;
+    for (uint8_t i = 0U; i < sim_count; i++) {
+        sx127x_sim_t *sim = sims[i];
+        uint8_t mode = sx127x_sim_mode(sim);
+
+        if (sim_in_reset(sim) || !sim_lora(sim) || (int32_t)(now_us - sim->done_us) < 0) {
+            continue;
+        }
+        if (mode == SX_MODE_TX) {
+            sim->tx_count++;
+            sim_irq(sim, SX_IRQ_TX_DONE);
+        } else if (mode == SX_MODE_CAD) {
+            sim_irq(sim, SX_IRQ_CAD_DONE | (sim->busy_channel ? SX_IRQ_CAD_DETECTED : 0U));
+        } else {
+            continue;
+        }
+        sim->reg[SX_OP_MODE] = (uint8_t)((sim->reg[SX_OP_MODE] & (uint8_t)~SX_MODE_MASK) | SX_MODE_STDBY);
+    }
+}
+
+/*..........................................................................................*/
+/* HAL */
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state) {
+    sx127x_sim_t *sim = port->sim;
+    bool was_selected = (port->odr & SX127X_SIM_NSS) == 0U;
+    bool was_reset = (port->odr & SX127X_SIM_NRESET) == 0U;
+
+    if (state == GPIO_PIN_SET) {
+        port->odr |= pin;
+    } else {
+        port->odr &= (uint16_t)~pin;
+    }
+    if (sim == NULL) {
+        return;
+    }
+
+    if (!was_reset && sim_in_reset(sim)) {
+        sim_power_on(sim);
+    }
+    sim->selected = (port->odr & SX127X_SIM_NSS) == 0U;
+    if (sim->selected && !was_selected) {
+        sim->addressed = false;
+        sim->transfers++;
+        /* the lock: radio IRQs off and, in a task, the scheduler suspended */
+        if (nvic_enabled != 0U || (ipsr == 0U && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)) {
+            sim->unlocked++;
+        }
+        for (uint8_t i = 0U; i < sim_count; i++) {
+            if (sims[i] != sim && sims[i]->selected) {
+                sim->collisions++;
+            }
+        }
+    }
+}
+
+static sx127x_sim_t *sim_selected(void) {
+    for (uint8_t i = 0U; i < sim_count; i++) {
+        if (sims[i]->selected) {
+            return sims[i];
+        }
+    }
+    return NULL;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size, uint32_t timeout) {
+    sx127x_sim_t *sim = sim_selected();
+
+    (void)hspi;
+    (void)timeout;
+    if (sim == NULL || sim_in_reset(sim)) {
+        return HAL_OK; /* nobody listens */
+    }
+    sim->bytes += size;
+    for (uint16_t i = 0U; i < size; i++) {
+        if (!sim->addressed) {
+            sim->addressed = true;
+            sim->writing = (data[i] & 0x80U) != 0U;
+            sim->addr = data[i] & 0x7FU;
+        } else if (sim->writing) {
+            sim_write(sim, sim->addr, data[i]);
+            if (sim->addr != SX_FIFO) {
+                sim->addr = (sim->addr + 1U) & 0x7FU;
+            }
+        } else {
+            sim->errors++; /* data out in a read transaction */
+        }
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size, uint32_t timeout) {
+    sx127x_sim_t *sim = sim_selected();
+
+    (void)hspi;
+    (void)timeout;
+    if (sim == NULL || sim_in_reset(sim)) {
+        (void)memset(data, 0, size); /* MISO pulled low */
+        return HAL_OK;
+    }
+    sim->bytes += size;
+    if (!sim->addressed || sim->writing) {
+        sim->errors++;
+        (void)memset(data, 0, size);
+        return HAL_OK;
+    }
+    for (uint16_t i = 0U; i < size; i++) {
+        data[i] = sim_read(sim, sim->addr);
+        if (sim->addr != SX_FIFO) {
+            sim->addr = (sim->addr + 1U) & 0x7FU;
+        }
+    }
+    return HAL_OK;
+}
+
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef *hspi) {
+    (void)hspi;
+    return HAL_SPI_STATE_READY;
+}
+
+void HAL_Delay(uint32_t ms) {
+    sx127x_sim_advance(ms * 1000UL);
+}
+
+uint32_t HAL_GetTick(void) {
+    return now_us / 1000UL;
+}
+
+/*..........................................................................................*/
+/* CMSIS and FreeRTOS */
+
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irq) {
+    return (uint32_t)((nvic_enabled >> irq) & 1U);
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq) {
+    nvic_enabled |= 1ULL << irq;
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq) {
+    nvic_enabled &= ~(1ULL << irq);
+}
+
+uint32_t __get_IPSR(void) {
+    return ipsr;
+}
+
+void sx127x_sim_isr_enter(void) {
+    ipsr = 16U; /* any external interrupt */
+}
+
+void sx127x_sim_isr_exit(void) {
+    ipsr = 0U;
+}
+
+void sx127x_sim_scheduler(BaseType_t state) {
+    scheduler = state;
+}
+
+uint32_t sx127x_sim_suspended(void) {
+    return suspended;
+}
+
+BaseType_t xTaskGetSchedulerState(void) {
+    return suspended != 0U ? taskSCHEDULER_SUSPENDED : scheduler;
+}
+
+void vTaskSuspendAll(void) {
+    suspended++;
+}
+
+BaseType_t xTaskResumeAll(void) {
+    if (suspended > 0U) {
+        suspended--;
+    }
+    return 0;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    sx127x_sim_advance(ticks * (1000000UL / configTICK_RATE_HZ));
+}
@@ -0,0 +1,95 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef SX127X_SIM_H
+#define SX127X_SIM_H
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "main.h"
+
+/*
+ * Register-level SX127x (LoRa mode) behind the HAL calls of LoRa_spiTransfer, so the
+ * driver runs on the host unchanged. Up to SX127X_SIM_MAX chips share one SPI bus,
+ * each selected by the NSS line of its own port. Modelled:
+ *   - the register map with its reset values, burst access with address
+ *     auto-increment, RegFiFo through RegFiFoAddPtr;
+ *   - op modes: LongRangeMode only changes in sleep, sleep clears the FiFo, RX
+ *     restarts at RegFiFoRxBaseAddr, RXCONTINUOUS appends packets around the
+ *     256 byte FiFo, RXSINGLE, TX and CAD fall back to standby when done;
+ *   - RegIrqFlags set by the modem (unless masked) and cleared by writing 1,
+ *     DIO0 as RegDioMapping1 routes it;
+ *   - NRESET: registers and FiFo back to their reset values, no SPI meanwhile.
+ * The clock only moves with sx127x_sim_advance (HAL_Delay and vTaskDelay call it),
+ * TX completes after its time on air, CAD after two symbols, both from the modem
+ * registers. SPI bytes and transactions are counted per chip, so a driver change
+ * can be measured in bytes and simulated us.
+ * The host half of the kernel lives here too: NVIC enables, ISR context and the
+ * scheduler state, with every NSS low period checked against the SPI lock.
+ */
+#define SX127X_SIM_MAX 2U
+#define SX127X_SIM_NSS GPIO_PIN_0
+#define SX127X_SIM_NRESET GPIO_PIN_1
+
+typedef struct sx127x_sim {
+    GPIO_TypeDef port; /* NSS on SX127X_SIM_NSS, NRESET on SX127X_SIM_NRESET */
+    uint8_t reg[0x80];
+    uint8_t fifo[256];
+    bool selected; /* NSS low */
+    bool addressed; /* address byte of the running transaction seen */
+    bool writing;
+    uint8_t addr;
+    bool busy_channel; /* the next CAD detects a preamble */
+    uint32_t done_us; /* end of the running TX or CAD */
+    uint8_t tx[256]; /* last packet sent */
+    uint8_t tx_length;
+    uint32_t tx_count;
+    uint32_t transfers; /* NSS low periods */
+    uint32_t bytes; /* clocked, address bytes included */
+    uint32_t unlocked; /* of them without the SPI lock held */
+    uint32_t collisions; /* of them with another chip selected too */
+    uint32_t errors; /* SPI use the chip cannot make sense of */
+} sx127x_sim_t;
+
+/* link quality of an injected packet, raw register values */
+typedef struct sx127x_sim_rx {
+    int8_t snr; /* RegPktSnrValue, 0.25 dB steps */
+    uint8_t rssi; /* RegPktRssiValue */
+    int32_t fei; /* RegFeiMsb..Lsb, 20 bit */
+    bool crc_error;
+} sx127x_sim_rx_t;
+
+/* power up a chip out of reset, NSS and NRESET high, and put it on the bus */
+void sx127x_sim_init(sx127x_sim_t *sim);
+/* take every chip off the bus, clock to 0, no IRQ enabled, scheduler running */
+void sx127x_sim_reset_all(void);
+
+/* a packet on the air: false if the chip was not listening */
+bool sx127x_sim_receive(sx127x_sim_t *sim, uint8_t const *data, uint8_t length, sx127x_sim_rx_t const *rx);
+/* level of DIO0 */
+bool sx127x_sim_dio0(sx127x_sim_t const *sim);
+/* op mode bits of RegOpMode */
+uint8_t sx127x_sim_mode(sx127x_sim_t const *sim);
+/*
+ * RegFei of a packet from tx as rx demodulates it, both tuned by their RegFr: the
+ * received carrier minus rx's own, the sign the datasheet gives FreqError
+ */
+int32_t sx127x_sim_fei(sx127x_sim_t const *rx, sx127x_sim_t const *tx);
+/* time on air of a packet with the current modem settings */
+uint32_t sx127x_sim_toa_us(sx127x_sim_t const *sim, uint8_t length);
+/* run the clock, completes TX and CAD that are due */
+void sx127x_sim_advance(uint32_t us);
+uint32_t sx127x_sim_now_us(void);
+
+/* kernel side */
+void sx127x_sim_isr_enter(void);
+void sx127x_sim_isr_exit(void);
+void sx127x_sim_scheduler(BaseType_t state);
+/* vTaskSuspendAll not resumed yet */
+uint32_t sx127x_sim_suspended(void);
+
+extern SPI_HandleTypeDef sx127x_sim_spi;
+
+#endif //SX127X_SIM_H
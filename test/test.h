@@ -0,0 +1,40 @@
+//
+// Created on 10/19/26.
+//
+
+#ifndef TEST_H
+#define TEST_H
+#include <stdio.h>
+#include <stdlib.h>
+
+/* minimal host test harness: CHECK reports and counts, test_done() is the exit code */
+static int test_failures;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            (void)fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                                        \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                              \
+    do {                                                                            \
+        long long const a_ = (long long)(a);                                        \
+        long long const b_ = (long long)(b);                                        \
+        if (a_ != b_) {                                                             \
+            (void)fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", \
+                          __FILE__, __LINE__, #a, #b, a_, b_);                      \
+            test_failures++;                                                        \
+        }                                                                           \
+    } while (0)
+
+static inline int test_done(void) {
+    if (test_failures != 0) {
+        (void)fprintf(stderr, "%d check(s) failed\n", test_failures);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+#endif //TEST_H
@@ -0,0 +1,113 @@
+//
+// Created on 10/19/26.
+//
+
+#include "LoRa/LoRa.h"
+#include "ra-02_afc.h"
+#include "sx127x_sim.h"
+#include "test.h"
+
+#define DIO0_IRQ EXTI2_IRQn
+#define FSTEP_HZ 62 /* 32 MHz / 2^19, rounded up */
+
+static sx127x_sim_t tx_sim, rx_sim;
+static LoRa tx_lora, rx_lora;
+
+static void chip(sx127x_sim_t *sim, LoRa *lora) {
+    sx127x_sim_init(sim);
+    *lora = newLoRa();
+    lora->CS_port = &sim->port;
+    lora->CS_pin = SX127X_SIM_NSS;
+    lora->reset_port = &sim->port;
+    lora->reset_pin = SX127X_SIM_NRESET;
+    lora->DIO0_port = &sim->port;
+    lora->DIO0_pin = GPIO_PIN_2;
+    lora->hSPIx = &sx127x_sim_spi;
+    LoRa_reset(lora);
+    CHECK_EQ(LoRa_init(lora), LORA_OK);
+}
+
+/* two chips on the same channel, the transmitter's crystal off by offset_hz */
+static void setup(int32_t offset_hz) {
+    sx127x_sim_reset_all();
+    LoRa_spiLockIrq(DIO0_IRQ);
+    NVIC_EnableIRQ(DIO0_IRQ);
+    chip(&tx_sim, &tx_lora);
+    chip(&rx_sim, &rx_lora);
+    LoRa_setFrequencyOffset(&tx_lora, offset_hz);
+    LoRa_startReceiving(&rx_lora);
+}
+
+/* one broadcast from tx, the FEI rx reads with it */
+static int32_t hear(void) {
+    uint8_t const data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    sx127x_sim_rx_t rx = {40, 100, sx127x_sim_fei(&rx_sim, &tx_sim), false};
+    uint8_t out[16];
+    LoRa_pktStatus status;
+
+    CHECK(sx127x_sim_receive(&rx_sim, data, sizeof(data), &rx));
+    CHECK_EQ(LoRa_receive(&rx_lora, out, sizeof(out)), sizeof(data));
+    LoRa_getPacketStatus(&rx_lora, &status);
+    return status.fei;
+}
+
+static bool near(int32_t hz, int32_t target, int32_t tolerance) {
+    return hz >= target - tolerance && hz <= target + tolerance;
+}
+
+/* a sender above us reads as a positive FEI, below as a negative one */
+static void test_fei_sign(void) {
+    setup(3000);
+    CHECK(near(hear(), 3000, FSTEP_HZ));
+    setup(-3000);
+    CHECK(near(hear(), -3000, FSTEP_HZ));
+}
+
+/* the receiver's AFC lands on the sender's carrier and stays there, whichever side it is on */
+static void check_converges(int32_t offset_hz) {
+    RA02_afc_t afc;
+    int32_t fei = 0;
+
+    setup(offset_hz);
+    RA02_afc_init(&afc);
+    for (uint32_t i = 0U; i < 64U; i++) {
+        fei = hear();
+        (void)RA02_afc_sample(&afc, fei);
+        if (RA02_afc_retune(&afc)) {
+            LoRa_gotoMode(&rx_lora, STNBY_MODE);
+            LoRa_setFrequencyOffset(&rx_lora, afc.applied_hz);
+            LoRa_startReceiving(&rx_lora);
+        }
+        /* moves towards the sender, never past it */
+        CHECK(offset_hz > 0 ? afc.applied_hz <= offset_hz + FSTEP_HZ : afc.applied_hz >= offset_hz - FSTEP_HZ);
+    }
+    CHECK(near(fei, 0, RA02_AFC_STEP_HZ + FSTEP_HZ));
+    CHECK(near(afc.applied_hz, offset_hz, RA02_AFC_STEP_HZ + FSTEP_HZ));
+}
+
+static void test_converges(void) {
+    check_converges(4000);
+    check_converges(-4000);
+}
+
+/* a sender further out than RA02_AFC_MAX_HZ only drags us that far */
+static void test_clamped(void) {
+    RA02_afc_t afc;
+
+    setup(2 * RA02_AFC_MAX_HZ);
+    RA02_afc_init(&afc);
+    for (uint32_t i = 0U; i < 64U; i++) {
+        (void)RA02_afc_sample(&afc, hear());
+        if (RA02_afc_retune(&afc)) {
+            LoRa_setFrequencyOffset(&rx_lora, afc.applied_hz);
+        }
+    }
+    CHECK_EQ(afc.hz, RA02_AFC_MAX_HZ);
+}
+
+int main(void) {
+    test_fei_sign();
+    test_converges();
+    test_clamped();
+    return test_done();
+}
@@ -0,0 +1,119 @@
+//
+// Created on 10/19/26.
+//
+
+#include <string.h>
+
+#include "Mesh/arq.h"
+#include "test.h"
+
+static uint8_t const data[ARQ_DATA_LEN] = {1, 2, 3, 4};
+
+static void test_window(void) {
+    arq_peer_t *p;
+    uint8_t seq;
+
+    arq_init();
+    p = arq_find(2U, true, 0U);
+    CHECK(p != NULL);
+    CHECK(arq_find(MESH_BROADCAST_ID, true, 0U) == NULL);
+    for (uint8_t i = 0U; i < ARQ_WINDOW; i++) {
+        CHECK(arq_tx_push(p, data, &seq, 0U));
+        CHECK_EQ(seq, i);
+    }
+    CHECK(!arq_tx_push(p, data, &seq, 0U));
+
+    for (uint8_t i = 0U; i < ARQ_WINDOW; i++) {
+        CHECK(arq_tx_due(p, &seq, 0U));
+        CHECK_EQ(seq, i);
+        arq_tx_sent(p, seq, 0U);
+    }
+    CHECK(!arq_tx_due(p, &seq, 1U));
+
+    /* 0 and 1 acked cumulatively, 3 selectively: the window moves by two */
+    arq_rx_ack(p, 2U, 0x2U, 100U);
+    CHECK_EQ(p->tx_base, 2U);
+    CHECK(arq_tx_push(p, data, &seq, 100U));
+    CHECK(arq_tx_push(p, data, &seq, 100U));
+    CHECK(!arq_tx_push(p, data, &seq, 100U));
+    /* an RTT sample came in */
+    CHECK(p->srtt != 0U);
+    CHECK_EQ(p->rto, ARQ_RTO_MIN_MS);
+}
+
+static void test_retransmit(void) {
+    arq_peer_t *p;
+    uint8_t seq;
+    uint32_t now = 0U;
+
+    arq_init();
+    p = arq_find(2U, true, now);
+    CHECK(arq_tx_push(p, data, &seq, now));
+    for (uint8_t i = 0U; i < ARQ_MAX_TRIES; i++) {
+        CHECK(arq_tx_due(p, &seq, now));
+        CHECK_EQ(seq, 0U);
+        arq_tx_sent(p, seq, now);
+        CHECK(!arq_tx_due(p, &seq, now + p->rto - 1U));
+        now += p->rto;
+    }
+    /* given up: counted, and the window is free again */
+    CHECK(!arq_tx_due(p, &seq, now));
+    CHECK_EQ(p->failed, 1U);
+    CHECK_EQ(p->tx_base, p->tx_next);
+    CHECK_EQ(p->rto, ARQ_RTO_MAX_MS);
+}
+
+static void test_receive(void) {
+    arq_peer_t *p;
+    uint8_t cum;
+    uint32_t map;
+
+    arq_init();
+    p = arq_find(2U, true, 0U);
+    CHECK(arq_rx_data(p, 0U, true, 0U));
+    CHECK(!arq_rx_data(p, 0U, true, 0U));
+    CHECK(arq_rx_data(p, 2U, true, 0U));
+    CHECK(!arq_rx_data(p, 2U, true, 0U));
+    CHECK(p->ack_pending);
+    CHECK_EQ(p->ack_due, ARQ_ACK_DELAY_MS);
+    arq_ack_take(p, &cum, &map);
+    CHECK_EQ(cum, 1U);
+    CHECK_EQ(map, 0x1U);
+    CHECK(!p->ack_pending);
+
+    CHECK(arq_rx_data(p, 1U, false, 10U));
+    arq_ack_take(p, &cum, &map);
+    CHECK_EQ(cum, 3U);
+    CHECK_EQ(map, 0U);
+
+    /* the peer rebooted and starts over with syn */
+    CHECK(arq_rx_data(p, 0U, true, 20U));
+    arq_ack_take(p, &cum, &map);
+    CHECK_EQ(cum, 1U);
+}
+
+/* peers with frames in flight are never replaced */
+static void test_peers(void) {
+    uint8_t seq;
+
+    arq_init();
+    for (uint8_t i = 0U; i < ARQ_PEERS; i++) {
+        arq_peer_t *p = arq_find((uint8_t)(10U + i), true, i);
+
+        CHECK(p != NULL);
+        CHECK(arq_tx_push(p, data, &seq, i));
+    }
+    CHECK(arq_find(20U, true, 100U) == NULL);
+    arq_tx_sent(arq_find(10U, false, 100U), 0U, 100U);
+    arq_rx_ack(arq_find(10U, false, 100U), 1U, 0U, 100U);
+    CHECK(arq_find(20U, true, 200U) != NULL);
+    CHECK(arq_find(10U, false, 200U) == NULL);
+}
+
+int main(void) {
+    test_window();
+    test_retransmit();
+    test_receive();
+    test_peers();
+    return test_done();
+}
@@ -0,0 +1,62 @@
+//
+// Created on 10/19/26.
+//
+
+#include "packet_t.h"
+#include "test.h"
+
+/* CRC-16/CCITT-FALSE, straight from the definition */
+static uint16_t crc16_reference(uint8_t const *data, uint16_t length) {
+    uint16_t crc = CRC16_INIT;
+
+    for (uint16_t i = 0U; i < length; i++) {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (uint8_t bit = 0U; bit < 8U; bit++) {
+            crc = (crc & 0x8000U) != 0U ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void test_check_value(void) {
+    static uint8_t const check[] = "123456789";
+
+    CHECK_EQ(crc16(check, 9U), 0x29B1U);
+    CHECK_EQ(crc16(check, 0U), CRC16_INIT);
+}
+
+/* fed in two pieces, split anywhere, it is the same CRC */
+static void test_chunked(void) {
+    uint8_t data[64];
+
+    for (uint16_t i = 0U; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 37U + 11U);
+    }
+    for (uint16_t split = 0U; split <= sizeof(data); split++) {
+        uint16_t crc = crc16_update(CRC16_INIT, data, split);
+
+        CHECK_EQ(crc16_update(crc, &data[split], (uint16_t)(sizeof(data) - split)), crc16(data, sizeof(data)));
+    }
+}
+
+static void test_against_reference(void) {
+    uint8_t data[256];
+    uint32_t x = 0x12345678UL;
+
+    for (uint16_t i = 0U; i < sizeof(data); i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        data[i] = (uint8_t)x;
+    }
+    for (uint16_t length = 0U; length <= sizeof(data); length++) {
+        CHECK_EQ(crc16(data, length), crc16_reference(data, length));
+    }
+}
+
+int main(void) {
+    test_check_value();
+    test_chunked();
+    test_against_reference();
+    return test_done();
+}
@@ -0,0 +1,54 @@
+//
+// Created on 10/19/26.
+//
+
+#include "Mesh/dup_cache.h"
+#include "test.h"
+
+static void test_seen_once(void) {
+    dup_cache_init();
+    CHECK(!dup_cache_check(7U, 42U, 1000U));
+    CHECK(dup_cache_check(7U, 42U, 1001U));
+    CHECK(dup_cache_check(7U, 42U, 1000U + DUP_CACHE_AGE_MS - 1U));
+    /* another source or another id is another frame */
+    CHECK(!dup_cache_check(8U, 42U, 1002U));
+    CHECK(!dup_cache_check(7U, 43U, 1003U));
+    /* the same low byte 256 frames later, once packet_msg_id_expand put the high one back */
+    CHECK(!dup_cache_check(7U, 42U + 256U, 1004U));
+}
+
+static void test_ages_out(void) {
+    dup_cache_init();
+    CHECK(!dup_cache_check(7U, 42U, 0U));
+    CHECK(!dup_cache_check(7U, 42U, DUP_CACHE_AGE_MS));
+    CHECK(dup_cache_check(7U, 42U, DUP_CACHE_AGE_MS + 1U));
+}
+
+static void test_timer_wraps(void) {
+    uint32_t const t = UINT32_MAX - 10U;
+
+    dup_cache_init();
+    CHECK(!dup_cache_check(3U, 1U, t));
+    CHECK(dup_cache_check(3U, 1U, t + 20U));
+}
+
+/* a full table makes room with the oldest entry of the probe window, so the last few always stay */
+static void test_full(void) {
+    uint32_t now = 0U;
+
+    dup_cache_init();
+    for (uint16_t i = 0U; i < 4U * DUP_CACHE_SIZE; i++, now++) {
+        CHECK(!dup_cache_check((uint8_t)(i % 8U), (uint8_t)(i / 8U), now));
+    }
+    for (uint16_t i = 4U * DUP_CACHE_SIZE - (DUP_CACHE_PROBES - 1U); i < 4U * DUP_CACHE_SIZE; i++) {
+        CHECK(dup_cache_check((uint8_t)(i % 8U), (uint8_t)(i / 8U), now));
+    }
+}
+
+int main(void) {
+    test_seen_once();
+    test_ages_out();
+    test_timer_wraps();
+    test_full();
+    return test_done();
+}
@@ -0,0 +1,116 @@
+//
+// Created on 10/19/26.
+//
+
+#include <string.h>
+
+#include "Mesh/frag.h"
+#include "test.h"
+
+#define SENDER 5U
+#define RECEIVER 2U
+
+/*
+ * runs one message through frag_tx and frag_rx, the same module plays both ends;
+ * 'lose' is a fragment index dropped the first time it goes out, 0xFF for none
+ */
+static bool transfer(uint8_t const *msg, uint16_t length, uint8_t lose, uint32_t *now) {
+    uint8_t payload[MESH_MAX_PAYLOAD];
+    uint8_t dest;
+    bool delivered = false;
+
+    CHECK(frag_tx_start(RECEIVER, msg, length, *now));
+    for (uint16_t step = 0U; step < 1000U; step++, *now += 50U) {
+        frag_rx_t const *m;
+
+        while (frag_tx_next(&dest, payload, *now)) {
+            CHECK_EQ(dest, RECEIVER);
+            if (payload[1] == lose) {
+                lose = 0xFFU;
+                continue;
+            }
+            m = frag_rx(SENDER, payload, *now);
+            if (m != NULL) {
+                CHECK(!delivered);
+                CHECK_EQ(m->length, length);
+                CHECK(memcmp(m->data, msg, length) == 0);
+                delivered = true;
+            }
+        }
+        while (frag_status_take(&dest, payload, *now)) {
+            CHECK_EQ(dest, SENDER);
+            frag_tx_status(RECEIVER, payload, *now);
+        }
+        /* acked: a new message may start */
+        if (frag_tx_start(RECEIVER, msg, 1U, *now)) {
+            return delivered;
+        }
+    }
+    return false;
+}
+
+static void test_whole(void) {
+    uint8_t msg[FRAG_MAX_LEN];
+    uint32_t now = 0U;
+
+    for (uint16_t i = 0U; i < sizeof(msg); i++) {
+        msg[i] = (uint8_t)(i * 7U + 1U);
+    }
+    frag_init();
+    CHECK(transfer(msg, 100U, 0xFFU, &now));
+    frag_init();
+    CHECK(transfer(msg, FRAG_DATA_LEN, 0xFFU, &now));
+    frag_init();
+    CHECK(transfer(msg, 101U, 0xFFU, &now));
+}
+
+static void test_lost(void) {
+    uint8_t msg[100];
+    uint32_t now = 0U;
+
+    for (uint16_t i = 0U; i < sizeof(msg); i++) {
+        msg[i] = (uint8_t)(255U - i);
+    }
+    frag_init();
+    CHECK(transfer(msg, sizeof(msg), 3U, &now));
+    frag_init();
+    CHECK(transfer(msg, sizeof(msg), 0U, &now)); /* the header */
+    frag_init();
+    CHECK(transfer(msg, sizeof(msg), (uint8_t)((sizeof(msg) + FRAG_DATA_LEN - 1U) / FRAG_DATA_LEN), &now));
+}
+
+static void test_refused(void) {
+    uint8_t msg[FRAG_MAX_LEN + 1U] = {0};
+
+    frag_init();
+    CHECK(!frag_tx_start(MESH_BROADCAST_ID, msg, 10U, 0U));
+    CHECK(!frag_tx_start(RECEIVER, msg, 0U, 0U));
+    CHECK(!frag_tx_start(RECEIVER, msg, FRAG_MAX_LEN + 1U, 0U));
+    CHECK(frag_tx_start(RECEIVER, msg, FRAG_MAX_LEN, 0U));
+    CHECK(!frag_tx_start(RECEIVER, msg, 10U, 0U)); /* one at a time */
+}
+
+/* a sender that never hears a status gives up after FRAG_MAX_PROBES */
+static void test_no_answer(void) {
+    uint8_t msg[20] = {0};
+    uint8_t payload[MESH_MAX_PAYLOAD];
+    uint8_t dest;
+    uint32_t now = 0U;
+
+    frag_init();
+    CHECK(frag_tx_start(RECEIVER, msg, sizeof(msg), now));
+    for (uint16_t step = 0U; step < 1000U; step++, now += 100U) {
+        while (frag_tx_next(&dest, payload, now)) {
+        }
+    }
+    CHECK(frag_tx_start(RECEIVER, msg, sizeof(msg), now));
+    CHECK_EQ(frag_next_deadline(now), 0U);
+}
+
+int main(void) {
+    test_whole();
+    test_lost();
+    test_refused();
+    test_no_answer();
+    return test_done();
+}
@@ -0,0 +1,482 @@
+//
+// Created on 10/19/26.
+//
+
+#include <string.h>
+
+#include "LoRa/LoRa.h"
+#include "sx127x_sim.h"
+#include "task.h"
+#include "test.h"
+
+#define DIO0_PIN GPIO_PIN_2
+#define DIO0_IRQ EXTI2_IRQn
+
+static sx127x_sim_t sim;
+static LoRa lora;
+static LoRa_rxRing ring;
+static bool dio0_level;
+
+/* a fresh chip and a driver bound to it, initialised, the radio IRQ enabled and registered */
+static void setup(void) {
+    sx127x_sim_reset_all();
+    sx127x_sim_init(&sim);
+    lora = newLoRa();
+    lora.CS_port = &sim.port;
+    lora.CS_pin = SX127X_SIM_NSS;
+    lora.reset_port = &sim.port;
+    lora.reset_pin = SX127X_SIM_NRESET;
+    lora.DIO0_port = &sim.port;
+    lora.DIO0_pin = DIO0_PIN;
+    lora.hSPIx = &sx127x_sim_spi;
+    LoRa_spiLockIrq(DIO0_IRQ);
+    NVIC_EnableIRQ(DIO0_IRQ);
+    LoRa_reset(&lora);
+    CHECK_EQ(LoRa_init(&lora), LORA_OK);
+}
+
+/* every transaction whole and under the lock, nothing the chip could not parse */
+static void check_bus(void) {
+    CHECK_EQ(sim.unlocked, 0U);
+    CHECK_EQ(sim.errors, 0U);
+    CHECK_EQ(sx127x_sim_suspended(), 0U);
+    CHECK(NVIC_GetEnableIRQ(DIO0_IRQ));
+}
+
+/* the EXTI: the DIO0 ISR runs on a rising edge only and, like the RA02 one, leaves CadDone and TxDone to the task */
+static bool dio0_edge(void) {
+    bool level = sx127x_sim_dio0(&sim);
+    bool rising = level && !dio0_level;
+
+    dio0_level = level;
+    if (rising && lora.current_mode != CAD_MODE && lora.current_mode != TRANSMIT_MODE) {
+        sx127x_sim_isr_enter();
+        (void)LoRa_receiveToRing(&lora, &ring, sx127x_sim_now_us());
+        sx127x_sim_isr_exit();
+        dio0_level = sx127x_sim_dio0(&sim);
+    }
+    return rising;
+}
+
+/* on the air and through the ISR */
+static bool air(uint8_t const *data, uint8_t length) {
+    return sx127x_sim_receive(&sim, data, length, NULL) && dio0_edge();
+}
+
+static void fill(uint8_t *data, uint8_t length, uint8_t seed) {
+    for (uint8_t i = 0U; i < length; i++) {
+        data[i] = (uint8_t)(seed + 7U * i);
+    }
+}
+
+/* setup, then receiving into the ring */
+static void setup_rx(void) {
+    setup();
+    (void)memset(&ring, 0, sizeof(ring));
+    lora.rxRing = &ring;
+    dio0_level = false;
+    LoRa_startReceiving(&lora);
+}
+
+static void test_init(void) {
+    setup();
+    CHECK_EQ(sim.reg[RegOpMode] & 0x87, 0x81); /* LoRa, standby, LowFrequencyModeOn kept */
+    CHECK_EQ(lora.current_mode, STNBY_MODE);
+    CHECK_EQ(((uint32_t)sim.reg[RegFrMsb] << 16) | ((uint32_t)sim.reg[RegFrMid] << 8) | sim.reg[RegFrLsb],
+             LORA_FRF(433000000UL));
+    CHECK_EQ(sim.reg[RegModemConfig1], (BW_125KHz << 4) | (CR_4_5 << 1));
+    CHECK_EQ(sim.reg[RegModemConfig2] >> 4, SF_7);
+    CHECK_EQ(sim.reg[RegModemConfig3] & 0x08, 0); /* no LDRO at SF7 / 125 kHz */
+    CHECK_EQ(sim.reg[RegModemConfig3] & 0x04, 0x04); /* AgcAutoOn left alone */
+    CHECK_EQ(sim.reg[RegPreambleLsb], 8);
+    check_bus();
+}
+
+/* a chip held in reset answers 0x00 */
+static void test_init_not_found(void) {
+    setup();
+    LoRa_resetAssert(&lora);
+    CHECK_EQ(LoRa_init(&lora), LORA_NOT_FOUND);
+    LoRa_resetRelease(&lora);
+    CHECK_EQ(LoRa_init(&lora), LORA_OK);
+    check_bus();
+}
+
+static void test_transmit(void) {
+    uint8_t data[20];
+    uint32_t start;
+
+    for (uint8_t i = 0U; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(0xA0U + i);
+    }
+    setup();
+    start = sx127x_sim_now_us();
+    CHECK_EQ(LoRa_transmit(&lora, data, sizeof(data), 100), 1);
+    CHECK_EQ(sim.tx_count, 1U);
+    CHECK_EQ(sim.tx_length, sizeof(data));
+    CHECK(memcmp(sim.tx, data, sizeof(data)) == 0);
+    /* polled in 1 ms steps until the time on air passed */
+    CHECK(sx127x_sim_now_us() - start >= sx127x_sim_toa_us(&sim, sizeof(data)));
+    CHECK(sx127x_sim_now_us() - start < sx127x_sim_toa_us(&sim, sizeof(data)) + 1000U);
+    CHECK_EQ(sim.reg[RegIrqFlags], 0);
+    check_bus();
+}
+
+static void test_start_transmit(void) {
+    uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    setup();
+    LoRa_startTransmit(&lora, data, sizeof(data));
+    CHECK_EQ(sx127x_sim_mode(&sim), TRANSMIT_MODE);
+    sx127x_sim_advance(sx127x_sim_toa_us(&sim, sizeof(data)) - 1U);
+    CHECK(!sx127x_sim_dio0(&sim));
+    sx127x_sim_advance(1U);
+    CHECK(sx127x_sim_dio0(&sim));
+    CHECK_EQ(sx127x_sim_mode(&sim), STNBY_MODE);
+    CHECK(memcmp(sim.tx, data, sizeof(data)) == 0);
+    LoRa_clearIrqFlags(&lora, IRQ_TX_DONE);
+    CHECK(!sx127x_sim_dio0(&sim));
+    check_bus();
+}
+
+/* the driver's airtime, used for the duty cycle and TX timeouts, against the chip's */
+static void test_time_on_air(void) {
+    static uint8_t const sf[] = {SF_7, SF_9, SF_12};
+    static uint8_t const bw[] = {BW_125KHz, BW_250KHz, BW_500KHz};
+
+    for (uint8_t i = 0U; i < sizeof(sf); i++) {
+        for (uint8_t j = 0U; j < sizeof(bw); j++) {
+            setup();
+            lora.spredingFactor = sf[i];
+            lora.bandWidth = bw[j];
+            LoRa_applyConfig(&lora);
+            for (uint16_t length = 1U; length <= 255U; length += 127U) {
+                CHECK_EQ(LoRa_packetTimeOnAir(&lora, (uint8_t)length), sx127x_sim_toa_us(&sim, (uint8_t)length));
+            }
+        }
+    }
+}
+
+static void test_receive(void) {
+    static sx127x_sim_rx_t const rx = {-22, 60, -0x2000, false}; /* -5.5 dB, 0x2000 FEI steps low */
+    uint8_t data[12] = {9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 0xFF, 0x55};
+    uint8_t out[16];
+    LoRa_pktStatus status;
+
+    setup();
+    CHECK(!sx127x_sim_receive(&sim, data, sizeof(data), NULL)); /* standby, deaf */
+    LoRa_startReceiving(&lora);
+    CHECK(sx127x_sim_receive(&sim, data, sizeof(data), &rx));
+    CHECK(sx127x_sim_dio0(&sim));
+    CHECK_EQ(LoRa_receive(&lora, out, sizeof(out)), sizeof(data));
+    CHECK(memcmp(out, data, sizeof(data)) == 0);
+    CHECK_EQ(out[sizeof(data)], 0);
+    CHECK(!sx127x_sim_dio0(&sim));
+    CHECK_EQ(sx127x_sim_mode(&sim), RXCONTIN_MODE);
+
+    LoRa_getPacketStatus(&lora, &status);
+    CHECK_EQ(status.length, sizeof(data));
+    CHECK_EQ(status.snr, -5);
+    CHECK_EQ(status.rssi, -164 + 60 - 5);
+    /* -0x2000 * 2^24 / 32 MHz * 125 kHz / 500 kHz */
+    CHECK_EQ(status.fei, -1073);
+
+    /* a CRC error is taken and dropped */
+    CHECK(sx127x_sim_receive(&sim, data, sizeof(data), &(sx127x_sim_rx_t){40, 100, 0, true}));
+    CHECK_EQ(LoRa_receive(&lora, out, sizeof(out)), 0);
+    CHECK(!sx127x_sim_dio0(&sim));
+    check_bus();
+}
+
+static void test_cad(void) {
+    setup();
+    LoRa_startCAD(&lora);
+    CHECK(!sx127x_sim_dio0(&sim));
+    sx127x_sim_advance(2U * LoRa_symbolTime(SF_7, BW_125KHz));
+    CHECK(sx127x_sim_dio0(&sim));
+    CHECK_EQ(LoRa_getIrqFlags(&lora) & IRQ_CAD_DETECTED, 0);
+
+    sim.busy_channel = true;
+    LoRa_startCAD(&lora);
+    sx127x_sim_advance(2U * LoRa_symbolTime(SF_7, BW_125KHz));
+    CHECK_EQ(LoRa_getIrqFlags(&lora) & (IRQ_CAD_DONE | IRQ_CAD_DETECTED), IRQ_CAD_DONE | IRQ_CAD_DETECTED);
+    check_bus();
+}
+
+/* what one register access costs on the bus, the base of every count */
+static void test_spi_cost(void) {
+    uint8_t data[32] = {0};
+
+    setup();
+    sim.transfers = 0U;
+    sim.bytes = 0U;
+    (void)LoRa_read(&lora, RegVersion);
+    LoRa_write(&lora, RegSyncWord, 0x34);
+    CHECK_EQ(sim.transfers, 2U);
+    CHECK_EQ(sim.bytes, 4U);
+
+    sim.transfers = 0U;
+    sim.bytes = 0U;
+    LoRa_BurstWrite(&lora, RegFiFo, data, sizeof(data));
+    CHECK_EQ(sim.transfers, 1U);
+    CHECK_EQ(sim.bytes, 1U + sizeof(data));
+    check_bus();
+}
+
+/* the ISR only takes the status, the payload stays in the FiFo until the task fetches it */
+static void test_ring_order(void) {
+    uint8_t data[3][LORA_RX_SLOT_SIZE];
+    LoRa_rxSlot *slot;
+    uint32_t start;
+
+    setup_rx();
+    start = sx127x_sim_now_us();
+    for (uint8_t i = 0U; i < 3U; i++) {
+        fill(data[i], sizeof(data[i]), (uint8_t)(i * 50U));
+        sx127x_sim_advance(1000U);
+        CHECK(air(data[i], (uint8_t)(40U + i)));
+    }
+    CHECK(LoRa_rxRingFront(&ring) == NULL);
+
+    LoRa_rxRingFetch(&lora, &ring);
+    for (uint8_t i = 0U; i < 3U; i++) {
+        slot = LoRa_rxRingFront(&ring);
+        CHECK(slot != NULL);
+        if (slot == NULL) {
+            return;
+        }
+        CHECK_EQ(slot->length, 40U + i);
+        CHECK_EQ(slot->status.length, 40U + i);
+        CHECK_EQ(slot->status.snr, 10);
+        CHECK_EQ(slot->timestamp, start + 1000U * (i + 1U));
+        CHECK(memcmp(slot->data, data[i], slot->length) == 0);
+        LoRa_rxRingPop(&ring);
+    }
+    CHECK(LoRa_rxRingFront(&ring) == NULL);
+    CHECK_EQ(ring.dropped, 0U);
+    CHECK_EQ(sx127x_sim_mode(&sim), RXCONTIN_MODE);
+    check_bus();
+}
+
+/* packets are appended around the 256 byte FiFo, the ring follows them across the end */
+static void test_ring_fifo_wrap(void) {
+    uint8_t data[LORA_RX_SLOT_SIZE];
+    LoRa_rxSlot *slot;
+
+    setup_rx();
+    for (uint16_t n = 0U; n < 40U; n++) {
+        fill(data, sizeof(data), (uint8_t)n);
+        CHECK(air(data, 50U));
+        LoRa_rxRingFetch(&lora, &ring);
+        slot = LoRa_rxRingFront(&ring);
+        CHECK(slot != NULL);
+        if (slot == NULL) {
+            return;
+        }
+        CHECK(memcmp(slot->data, data, 50U) == 0);
+        LoRa_rxRingPop(&ring);
+    }
+    check_bus();
+}
+
+/* longer than a slot: the slot keeps what fits, the status the length on air */
+static void test_ring_long(void) {
+    uint8_t data[100];
+    LoRa_rxSlot *slot;
+
+    fill(data, sizeof(data), 3U);
+    setup_rx();
+    CHECK(air(data, sizeof(data)));
+    LoRa_rxRingFetch(&lora, &ring);
+    slot = LoRa_rxRingFront(&ring);
+    CHECK(slot != NULL);
+    if (slot != NULL) {
+        CHECK_EQ(slot->length, LORA_RX_SLOT_SIZE);
+        CHECK_EQ(slot->status.length, sizeof(data));
+        CHECK(memcmp(slot->data, data, LORA_RX_SLOT_SIZE) == 0);
+    }
+    check_bus();
+}
+
+/* full: dropped and counted, RxDone cleared anyway so DIO0 falls and the next edge comes */
+static void test_ring_full(void) {
+    uint8_t data[16];
+    LoRa_rxSlot *slot;
+
+    setup_rx();
+    for (uint8_t i = 0U; i < LORA_RX_RING_LEN + 2U; i++) {
+        fill(data, sizeof(data), i);
+        CHECK(air(data, sizeof(data)));
+        CHECK(!sx127x_sim_dio0(&sim));
+    }
+    CHECK_EQ(ring.dropped, 2U);
+
+    LoRa_rxRingFetch(&lora, &ring);
+    for (uint8_t i = 0U; i < LORA_RX_RING_LEN; i++) {
+        slot = LoRa_rxRingFront(&ring);
+        CHECK(slot != NULL);
+        if (slot == NULL) {
+            return;
+        }
+        fill(data, sizeof(data), i);
+        CHECK(memcmp(slot->data, data, sizeof(data)) == 0);
+        LoRa_rxRingPop(&ring);
+    }
+
+    fill(data, sizeof(data), 99U);
+    CHECK(air(data, sizeof(data)));
+    LoRa_rxRingFetch(&lora, &ring);
+    slot = LoRa_rxRingFront(&ring);
+    CHECK(slot != NULL && memcmp(slot->data, data, sizeof(data)) == 0);
+    CHECK_EQ(ring.dropped, 2U);
+    check_bus();
+}
+
+/*
+ * RxDone latched while DIO0 pointed elsewhere (TX) holds DIO0 high once it points
+ * back, no rising edge would ever come again: startReceiving clears every flag.
+ */
+static void test_latched_rx_done(void) {
+    uint8_t data[16];
+
+    fill(data, sizeof(data), 1U);
+    setup_rx();
+    CHECK(sx127x_sim_receive(&sim, data, sizeof(data), NULL)); /* its edge comes while the task starts a TX */
+    LoRa_startTransmit(&lora, data, sizeof(data));
+    sx127x_sim_advance(sx127x_sim_toa_us(&sim, sizeof(data)));
+    CHECK(dio0_edge()); /* TxDone */
+    LoRa_clearIrqFlags(&lora, IRQ_TX_DONE);
+    CHECK(!dio0_edge());
+    LoRa_startReceiving(&lora);
+    CHECK(!sx127x_sim_dio0(&sim));
+
+    fill(data, sizeof(data), 2U);
+    CHECK(air(data, sizeof(data)));
+    CHECK_EQ(atomic_load(&ring.head), 1U);
+
+    /* the ISR outside RXCONTINUOUS takes nothing but still lets DIO0 fall */
+    CHECK(sx127x_sim_receive(&sim, data, sizeof(data), NULL));
+    lora.current_mode = STNBY_MODE;
+    CHECK(dio0_edge());
+    CHECK(!sx127x_sim_dio0(&sim));
+    CHECK_EQ(atomic_load(&ring.head), 1U);
+    check_bus();
+}
+
+/* leaving RX fetches first: TX writes its payload over the FiFo the frames still sit in */
+static void test_goto_mode_fetch(void) {
+    uint8_t data[2][LORA_RX_SLOT_SIZE];
+    uint8_t tx[LORA_RX_SLOT_SIZE];
+    LoRa_rxSlot *slot;
+
+    setup_rx();
+    for (uint8_t i = 0U; i < 2U; i++) {
+        fill(data[i], sizeof(data[i]), (uint8_t)(10U + i));
+        CHECK(air(data[i], sizeof(data[i]))); /* the second one ends up at 0x40..0x7F */
+    }
+    (void)memset(tx, 0xEE, sizeof(tx));
+    sim.reg[RegFiFoTxBaseAddr] = 0x40;
+    LoRa_startTransmit(&lora, tx, sizeof(tx));
+
+    for (uint8_t i = 0U; i < 2U; i++) {
+        slot = LoRa_rxRingFront(&ring);
+        CHECK(slot != NULL);
+        if (slot == NULL) {
+            return;
+        }
+        CHECK(memcmp(slot->data, data[i], sizeof(data[i])) == 0);
+        LoRa_rxRingPop(&ring);
+    }
+    check_bus();
+}
+
+/*
+ * RxDone right before the task starts a CAD: the event reaches the AO in CAD mode,
+ * the frame was fetched on the way out of RX and waits in the ring. A CAD hears no
+ * payload. Back in RX the frame is still there, followed by the next one.
+ */
+static void test_rx_done_before_cad(void) {
+    uint8_t data[2][24];
+    LoRa_rxSlot *slot;
+
+    fill(data[0], sizeof(data[0]), 40U);
+    fill(data[1], sizeof(data[1]), 41U);
+    setup_rx();
+    CHECK(air(data[0], sizeof(data[0])));
+    LoRa_startCAD(&lora);
+    CHECK_EQ(sx127x_sim_mode(&sim), CAD_MODE);
+    CHECK(!sx127x_sim_receive(&sim, data[1], sizeof(data[1]), NULL));
+    sx127x_sim_advance(2U * LoRa_symbolTime(SF_7, BW_125KHz));
+    CHECK(dio0_edge()); /* CadDone, left to the task */
+    CHECK_EQ(LoRa_getIrqFlags(&lora), IRQ_CAD_DONE);
+    LoRa_clearIrqFlags(&lora, IRQ_CAD_DONE | IRQ_CAD_DETECTED);
+    CHECK(!dio0_edge());
+    lora.current_mode = STNBY_MODE;
+
+    LoRa_startReceiving(&lora);
+    CHECK(air(data[1], sizeof(data[1])));
+    LoRa_rxRingFetch(&lora, &ring);
+    for (uint8_t i = 0U; i < 2U; i++) {
+        slot = LoRa_rxRingFront(&ring);
+        CHECK(slot != NULL);
+        if (slot == NULL) {
+            return;
+        }
+        CHECK_EQ(slot->length, sizeof(data[i]));
+        CHECK(memcmp(slot->data, data[i], sizeof(data[i])) == 0);
+        LoRa_rxRingPop(&ring);
+    }
+    CHECK(LoRa_rxRingFront(&ring) == NULL);
+    check_bus();
+}
+
+/* the ISR cost does not grow with the packet, the payload moves in task context */
+static void test_isr_cost(void) {
+    uint8_t data[LORA_RX_SLOT_SIZE] = {0};
+    uint32_t bytes[2];
+
+    setup_rx();
+    for (uint8_t i = 0U; i < 2U; i++) {
+        sim.bytes = 0U;
+        CHECK(air(data, i == 0U ? 8U : LORA_RX_SLOT_SIZE));
+        bytes[i] = sim.bytes;
+        LoRa_rxRingFetch(&lora, &ring);
+        LoRa_rxRingPop(&ring);
+    }
+    CHECK_EQ(bytes[0], bytes[1]);
+    CHECK_EQ(bytes[0], 18U); /* status burst 12, clear RxDone 2, FEI 4 */
+    check_bus();
+}
+
+/* before the scheduler starts the lock holds off the radio IRQs alone */
+static void test_lock_before_scheduler(void) {
+    uint8_t data[8] = {0};
+
+    setup_rx();
+    sx127x_sim_scheduler(taskSCHEDULER_NOT_STARTED);
+    CHECK(air(data, sizeof(data)));
+    LoRa_rxRingFetch(&lora, &ring);
+    CHECK(LoRa_rxRingFront(&ring) != NULL);
+    check_bus();
+}
+
+int main(void) {
+    test_init();
+    test_init_not_found();
+    test_transmit();
+    test_start_transmit();
+    test_time_on_air();
+    test_receive();
+    test_cad();
+    test_spi_cost();
+    test_ring_order();
+    test_ring_fifo_wrap();
+    test_ring_long();
+    test_ring_full();
+    test_latched_rx_done();
+    test_goto_mode_fetch();
+    test_rx_done_before_cad();
+    test_isr_cost();
+    test_lock_before_scheduler();
+    return test_done();
+}
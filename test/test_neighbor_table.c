@@ -0,0 +1,103 @@
+//
+// Created on 10/19/26.
+//
+
+#include "Mesh/neighbor_table.h"
+#include "packet_t.h"
+#include "ra-02_adr.h"
+#include "test.h"
+
+#define PEER 5U
+
+static neighbor_t entry(void) {
+    neighbor_t n = {0};
+
+    CHECK(neighbor_table_find(PEER, &n));
+    return n;
+}
+
+static void test_unknown(void) {
+    neighbor_t n;
+
+    neighbor_table_init();
+    CHECK(!neighbor_table_find(PEER, &n));
+    CHECK(!neighbor_table_update(MESH_BROADCAST_ID, -80, 10, true, 0U));
+    CHECK_EQ(neighbor_table_cost(NULL, 0U), NEIGHBOR_COST_UNUSABLE);
+}
+
+/* a trimmed frame seeds a new entry, the first full-power one replaces it */
+static void test_seed(void) {
+    neighbor_table_init();
+    CHECK(neighbor_table_update(PEER, -110, -5, false, 0U));
+    CHECK_EQ(entry().snr, -5 * 16);
+    CHECK_EQ(entry().link_count, 0U);
+    CHECK(neighbor_table_update(PEER, -90, 10, true, 1U));
+    CHECK_EQ(entry().snr, 10 * 16);
+    CHECK_EQ(entry().rssi, -90 * 16);
+    CHECK_EQ(entry().rx_count, 2U);
+    CHECK_EQ(entry().link_count, 1U);
+}
+
+/* routing and ADR wait for NEIGHBOR_MIN_FRAMES full-power frames, trimmed ones only keep the link alive */
+static void test_cost(void) {
+    neighbor_t n;
+
+    neighbor_table_init();
+    for (uint32_t i = 0U; i < 10U; i++) {
+        CHECK(neighbor_table_update(PEER, -90, 10, false, i));
+    }
+    n = entry();
+    CHECK_EQ(neighbor_table_cost(&n, 10U), NEIGHBOR_COST_UNUSABLE);
+    for (uint32_t i = 0U; i < NEIGHBOR_MIN_FRAMES; i++) {
+        CHECK(neighbor_table_update(PEER, -90, 10, true, 10U + i));
+    }
+    n = entry();
+    CHECK_EQ(neighbor_table_cost(&n, 20U), 1U);
+    CHECK_EQ(neighbor_table_cost(&n, 20U + NEIGHBOR_MAX_AGE_MS), NEIGHBOR_COST_UNUSABLE);
+    CHECK(neighbor_table_update(PEER, -120, -20, false, NEIGHBOR_MAX_AGE_MS));
+    n = entry();
+    CHECK_EQ(neighbor_table_cost(&n, 20U + NEIGHBOR_MAX_AGE_MS), 1U);
+}
+
+/*
+ * ADR closed loop over one symmetric link: each end trims its frames by what it
+ * measured on the other one's. Both ends broadcast at full power now and then. The
+ * trim must settle on the link's headroom and stay there.
+ */
+static void test_adr_steady(void) {
+    int8_t const link_snr = 12; /* at full power */
+    RA02_adr_t adr;
+    uint8_t first = 0U;
+
+    neighbor_table_init();
+    for (uint32_t i = 0U; i < 200U; i++) {
+        neighbor_t n;
+        bool broadcast = (i % 4U) == 0U;
+        uint8_t power = RA02_ADR_MAX_POWER_DBM;
+
+        /* the peer runs the same ADR on the same link, so it trims by what we would */
+        if (!broadcast && neighbor_table_find(PEER, &n)) {
+            RA02_adr_select(&n, 7U, &adr);
+            power = adr.power_dbm;
+        }
+        CHECK(neighbor_table_update(PEER, -100, (int8_t)(link_snr - (RA02_ADR_MAX_POWER_DBM - power)), broadcast, i));
+
+        n = entry();
+        RA02_adr_select(&n, 7U, &adr);
+        if (i == 20U) {
+            first = adr.power_dbm;
+        } else if (i > 20U) {
+            CHECK_EQ(adr.power_dbm, first);
+        }
+    }
+    /* 12 dB against the SF7 floor of -7.5 dB, 10 dB margin kept: 9 dB to spare */
+    CHECK_EQ(first, RA02_ADR_MAX_POWER_DBM - 9U);
+}
+
+int main(void) {
+    test_unknown();
+    test_seed();
+    test_cost();
+    test_adr_steady();
+    return test_done();
+}
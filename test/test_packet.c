@@ -0,0 +1,245 @@
+//
+// Created on 10/19/26.
+//
+
+#include <string.h>
+
+#include "packet_t.h"
+#include "test.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size); /* fuzz_packet.c */
+
+/* the frames the mesh sends, one per kind of wire header */
+static uint8_t frames[8][sizeof(packet_t)];
+static uint8_t frame_count;
+
+static void frame_add(uint8_t src, uint8_t dest, flags f, uint8_t hops, uint16_t msg_id, uint8_t next_hop,
+                      uint8_t const *payload) {
+    f.broadcasting = dest == MESH_BROADCAST_ID;
+    f.needs_forwarding = dest != MESH_BROADCAST_ID;
+    (void)packet_write(frames[frame_count], src, dest, f, hops, msg_id, payload);
+    packet_set_next_hop(frames[frame_count], next_hop);
+    frame_count++;
+}
+
+static void frames_init(void) {
+    static uint8_t const full[MESH_MAX_PAYLOAD] = {1, 2, 3, 4, 5, 6};
+    static uint8_t const tail0[MESH_MAX_PAYLOAD] = {9, 0, 7, 0, 0, 0};
+    static uint8_t const empty[MESH_MAX_PAYLOAD] = {0};
+    flags f = {0};
+
+    frame_count = 0U;
+    frame_add(3U, MESH_BROADCAST_ID, f, MESH_MAX_HOPS, 0x1234U, MESH_BROADCAST_ID, full);
+    frame_add(3U, 4U, f, 2U, 0x00FFU, 7U, tail0);
+    f.requires_ack = 1U;
+    f.syn = 1U;
+    frame_add(4U, 3U, f, MESH_MAX_HOPS, 1U, MESH_BROADCAST_ID, full);
+    f = (flags){0};
+    f.ack = 1U;
+    frame_add(4U, 3U, f, MESH_MAX_HOPS, 2U, 9U, empty);
+    f = (flags){0};
+    f.connected_nodes_info = 1U;
+    frame_add(5U, MESH_BROADCAST_ID, f, 0U, 3U, MESH_BROADCAST_ID, tail0);
+    f = (flags){0};
+    f.fragment = 1U;
+    f.ack = 1U;
+    frame_add(5U, 6U, f, 1U, 4U, MESH_BROADCAST_ID, full);
+}
+
+/* decoded frames keep msg_id's low byte only, the rest is the frame sent */
+static void check_same(uint8_t const *sent, uint8_t const *decoded) {
+    CHECK(memcmp(sent, decoded, offsetof(packet_t, msg_id)) == 0);
+    CHECK_EQ(decoded[offsetof(packet_t, msg_id)], sent[offsetof(packet_t, msg_id)]);
+    CHECK_EQ(decoded[offsetof(packet_t, msg_id) + 1U], 0U);
+    CHECK(memcmp(&sent[offsetof(packet_t, payload)], &decoded[offsetof(packet_t, payload)],
+                 sizeof(packet_t) - offsetof(packet_t, payload)) == 0);
+}
+
+static void test_round_trip(void) {
+    for (uint8_t i = 0U; i < frame_count; i++) {
+        uint8_t wire[PACKET_WIRE_MAX];
+        uint8_t frame[sizeof(packet_t)];
+        packet_view_t view;
+        uint8_t length = packet_encode(wire, frames[i]);
+
+        CHECK(length >= PACKET_WIRE_MIN && length <= PACKET_WIRE_MAX);
+        CHECK_EQ(packet_wire_length(wire), length);
+        CHECK_EQ(packet_decode(&view, frame, wire, length), PACKET_OK);
+        CHECK(view.raw == frame);
+        check_same(frames[i], frame);
+    }
+}
+
+static void test_truncated(void) {
+    for (uint8_t i = 0U; i < frame_count; i++) {
+        uint8_t wire[PACKET_WIRE_MAX];
+        uint8_t frame[sizeof(packet_t)];
+        packet_view_t view;
+        uint8_t length = packet_encode(wire, frames[i]);
+
+        for (uint8_t cut = 0U; cut < length; cut++) {
+            CHECK_EQ(packet_decode(&view, frame, wire, cut), PACKET_BAD_LENGTH);
+        }
+    }
+}
+
+static void test_oversize(void) {
+    for (uint8_t i = 0U; i < frame_count; i++) {
+        uint8_t wire[256] = {0};
+        uint8_t frame[sizeof(packet_t)];
+        packet_view_t view;
+        uint8_t length = packet_encode(wire, frames[i]);
+
+        for (uint16_t longer = length + 1U; longer <= sizeof(wire); longer++) {
+            CHECK_EQ(packet_decode(&view, frame, wire, longer), PACKET_BAD_LENGTH);
+        }
+    }
+}
+
+/* every single bit error is caught: by the length it implies, else by the CRC */
+static void test_bad_crc(void) {
+    for (uint8_t i = 0U; i < frame_count; i++) {
+        uint8_t wire[PACKET_WIRE_MAX];
+        uint8_t frame[sizeof(packet_t)];
+        packet_view_t view;
+        uint8_t length = packet_encode(wire, frames[i]);
+
+        for (uint8_t bit = 0U; bit < length * 8U; bit++) {
+            packet_status_t status;
+
+            wire[bit / 8U] ^= (uint8_t)(1U << (bit % 8U));
+            status = packet_decode(&view, frame, wire, length);
+            CHECK(status == PACKET_BAD_CRC || (bit < 8U && status == PACKET_BAD_LENGTH));
+            wire[bit / 8U] ^= (uint8_t)(1U << (bit % 8U));
+        }
+    }
+}
+
+/* a header the CRC vouches for but the format rejects */
+static void test_bad_header(void) {
+    uint8_t wire[PACKET_WIRE_MAX];
+    uint8_t frame[sizeof(packet_t)];
+    packet_view_t view;
+    uint8_t length = packet_encode(wire, frames[0]);
+    uint16_t crc;
+
+    wire[0] ^= 0xC0U; /* version 2 */
+    crc = crc16(wire, (uint16_t)(length - 2U));
+    wire[length - 2U] = (uint8_t)crc;
+    wire[length - 1U] = (uint8_t)(crc >> 8);
+    CHECK_EQ(packet_decode(&view, frame, wire, length), PACKET_BAD_VERSION);
+}
+
+/* frames the wire format has no kind for are refused, not sent wrong */
+static void test_no_kind(void) {
+    uint8_t wire[PACKET_WIRE_MAX];
+    uint8_t frame[sizeof(packet_t)];
+    uint8_t const payload[MESH_MAX_PAYLOAD] = {0};
+    flags f = {0};
+
+    f.beacon = 1U;
+    f.fragment = 1U;
+    f.needs_forwarding = 1U;
+    (void)packet_write(frame, 3U, 4U, f, 1U, 0U, payload);
+    CHECK_EQ(packet_encode(wire, frame), 0U);
+    f = (flags){0};
+    f.broadcasting = 1U;
+    (void)packet_write(frame, 3U, 4U, f, 1U, 0U, payload); /* broadcasting to a unicast dest */
+    CHECK_EQ(packet_encode(wire, frame), 0U);
+    f = (flags){0};
+    f.needs_forwarding = 1U;
+    (void)packet_write(frame, 3U, 4U, f, MESH_MAX_HOPS + 1U, 0U, payload);
+    CHECK_EQ(packet_encode(wire, frame), 0U);
+}
+
+/* random bytes, a valid CRC on half of them, through the libFuzzer harness */
+static void test_fuzz(void) {
+    uint32_t x = 0xC0FFEEUL;
+    uint32_t accepted = 0U;
+
+    for (uint32_t round = 0U; round < 200000UL; round++) {
+        uint8_t wire[PACKET_WIRE_MAX + 2U];
+        uint8_t frame[sizeof(packet_t)];
+        packet_view_t view;
+        uint8_t length;
+
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        length = (uint8_t)(x % sizeof(wire));
+        for (uint8_t i = 0U; i < length; i++) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            wire[i] = (uint8_t)x;
+        }
+        if (length >= 2U && (x & 0x100U) != 0U) {
+            uint16_t crc = crc16(wire, (uint16_t)(length - 2U));
+
+            wire[length - 2U] = (uint8_t)crc;
+            wire[length - 1U] = (uint8_t)(crc >> 8);
+        }
+        if (packet_decode(&view, frame, wire, length) == PACKET_OK) {
+            accepted++;
+        }
+        (void)LLVMFuzzerTestOneInput(wire, length); /* aborts on a broken round trip */
+    }
+    CHECK(accepted > 0U);
+}
+
+/* ids only grow, some get lost, a few come late */
+static void test_msg_id_expand(void) {
+    packet_msg_refs_t refs;
+
+    packet_msg_refs_init(&refs);
+    CHECK_EQ(packet_msg_id_expand(&refs, 1U, 0xF0U), 0xF0U);
+    CHECK_EQ(packet_msg_id_expand(&refs, 1U, 0xF1U), 0xF1U);
+    CHECK_EQ(packet_msg_id_expand(&refs, 1U, 0x10U), 0x110U); /* past the wrap, 30 lost */
+    CHECK_EQ(packet_msg_id_expand(&refs, 1U, 0xF2U), 0xF2U); /* late, back over the wrap */
+    CHECK_EQ(packet_msg_id_expand(&refs, 1U, 0x11U), 0x111U); /* the late one left the reference alone */
+    CHECK_EQ(packet_msg_id_expand(&refs, 1U, 0x11U), 0x111U); /* a copy */
+    CHECK_EQ(packet_msg_id_expand(&refs, 1U, 0xF1U), 0xF1U); /* PACKET_MSG_REORDER behind */
+    CHECK_EQ(packet_msg_id_expand(&refs, 1U, 0xF0U), 0x1F0U); /* one more is ahead */
+
+    /* every source counts on its own */
+    CHECK_EQ(packet_msg_id_expand(&refs, 2U, 0x05U), 0x05U);
+    CHECK_EQ(packet_msg_id_expand(&refs, 1U, 0xF2U), 0x1F2U);
+
+    /* a source heard continuously keeps distinct ids long past 256 frames */
+    for (uint16_t id = 0x1F3U; id < 0x1F3U + 1000U; id++) {
+        CHECK_EQ(packet_msg_id_expand(&refs, 1U, (uint8_t) id), id);
+    }
+
+    /* PACKET_MSG_REFS more sources push the first one out, it starts over from its low byte */
+    for (uint8_t src = 10U; src < 10U + PACKET_MSG_REFS; src++) {
+        (void) packet_msg_id_expand(&refs, src, 0U);
+    }
+    CHECK_EQ(packet_msg_id_expand(&refs, 1U, 0x40U), 0x40U);
+}
+
+/* the router writes the expanded id back into the decoded frame */
+static void test_set_msg_id(void) {
+    uint8_t const payload[MESH_MAX_PAYLOAD] = {0};
+    uint8_t frame[sizeof(packet_t)];
+    packet_view_t view = {.raw = frame};
+
+    (void) packet_write(frame, 1U, 2U, (flags){0}, 3U, 0x12U, payload);
+    packet_set_msg_id(frame, 0x3412U);
+    CHECK_EQ(packet_view_msg_id(&view), 0x3412U);
+    CHECK_EQ(packet_view_src(&view), 1U);
+    CHECK_EQ(packet_view_dest(&view), 2U);
+}
+
+int main(void) {
+    frames_init();
+    test_round_trip();
+    test_truncated();
+    test_oversize();
+    test_bad_crc();
+    test_bad_header();
+    test_no_kind();
+    test_fuzz();
+    test_msg_id_expand();
+    test_set_msg_id();
+    return test_done();
+}
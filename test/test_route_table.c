@@ -0,0 +1,127 @@
+//
+// Created on 10/19/26.
+//
+
+#include "Mesh/route_table.h"
+#include "test.h"
+
+/* advert payload with one (dest, cost) pair */
+static void advert(uint8_t payload[MESH_MAX_PAYLOAD], uint8_t dest, uint8_t cost) {
+    for (uint8_t i = 0U; i < MESH_MAX_PAYLOAD; i++) {
+        payload[i] = MESH_BROADCAST_ID;
+    }
+    payload[0] = dest;
+    payload[1] = cost;
+}
+
+/* cost of dest in a full advert round, 0 if it is not advertised */
+static uint8_t advertised(uint8_t dest, uint32_t now) {
+    uint8_t payload[MESH_MAX_PAYLOAD];
+    uint8_t cursor = 0U;
+    uint8_t cost = 0U;
+
+    for (uint8_t round = 0U; round < (ROUTE_TABLE_SIZE + ROUTE_ADVERT_PAIRS - 1U) / ROUTE_ADVERT_PAIRS; round++) {
+        route_table_advert_tx(payload, &cursor, now);
+        for (uint8_t i = 0U; i < ROUTE_ADVERT_PAIRS; i++) {
+            if (payload[2U * i] == dest) {
+                cost = payload[2U * i + 1U];
+            }
+        }
+    }
+    return cost;
+}
+
+static void test_learn(void) {
+    uint8_t payload[MESH_MAX_PAYLOAD];
+
+    route_table_init();
+    CHECK_EQ(route_table_next_hop(3U, 0U), MESH_BROADCAST_ID);
+    advert(payload, 3U, 1U);
+    route_table_advert_rx(2U, 1U, payload, 0U);
+    CHECK_EQ(route_table_next_hop(2U, 0U), 2U);
+    CHECK_EQ(route_table_next_hop(3U, 0U), 2U);
+    CHECK_EQ(advertised(3U, 0U), 2U);
+    /* no route to ourselves */
+    advert(payload, MESH_NODE_ID, 1U);
+    route_table_advert_rx(2U, 1U, payload, 0U);
+    CHECK_EQ(route_table_next_hop(MESH_NODE_ID, 0U), MESH_BROADCAST_ID);
+}
+
+static void test_cheaper_takes_over(void) {
+    uint8_t payload[MESH_MAX_PAYLOAD];
+
+    route_table_init();
+    advert(payload, 3U, 4U);
+    route_table_advert_rx(2U, 1U, payload, 0U);
+    /* as expensive: ours stays */
+    advert(payload, 3U, 3U);
+    route_table_advert_rx(4U, 2U, payload, 0U);
+    CHECK_EQ(route_table_next_hop(3U, 0U), 2U);
+    advert(payload, 3U, 1U);
+    route_table_advert_rx(4U, 2U, payload, 0U);
+    CHECK_EQ(route_table_next_hop(3U, 0U), 4U);
+    /* the next hop's own adverts are followed, up as well */
+    advert(payload, 3U, 6U);
+    route_table_advert_rx(4U, 2U, payload, 0U);
+    CHECK_EQ(route_table_next_hop(3U, 0U), 4U);
+    CHECK_EQ(advertised(3U, 0U), 8U);
+}
+
+/* a lost route is advertised unreachable and not bought back from a neighbor meanwhile */
+static void test_poisoned(void) {
+    uint8_t payload[MESH_MAX_PAYLOAD];
+
+    route_table_init();
+    advert(payload, 3U, 1U);
+    route_table_advert_rx(2U, 1U, payload, 0U);
+    advert(payload, 3U, ROUTE_COST_INFINITE);
+    route_table_advert_rx(2U, 1U, payload, 100U);
+    CHECK_EQ(route_table_next_hop(3U, 100U), MESH_BROADCAST_ID);
+    CHECK_EQ(advertised(3U, 100U), ROUTE_COST_INFINITE);
+
+    /* 4 still has the old route, through us */
+    advert(payload, 3U, 3U);
+    route_table_advert_rx(4U, 1U, payload, 200U);
+    CHECK_EQ(route_table_next_hop(3U, 200U), MESH_BROADCAST_ID);
+
+    /* after the hold-down the route is forgotten and may be learnt again */
+    CHECK_EQ(advertised(3U, 100U + ROUTE_HOLDDOWN_MS + 1U), 0U);
+    route_table_advert_rx(4U, 1U, payload, 100U + ROUTE_HOLDDOWN_MS + 2U);
+    CHECK_EQ(route_table_next_hop(3U, 100U + ROUTE_HOLDDOWN_MS + 2U), 4U);
+}
+
+/* a direct link is no loop, it replaces a held down route at once */
+static void test_poisoned_direct(void) {
+    uint8_t payload[MESH_MAX_PAYLOAD];
+
+    route_table_init();
+    advert(payload, 3U, 1U);
+    route_table_advert_rx(2U, 1U, payload, 0U);
+    advert(payload, 3U, ROUTE_COST_INFINITE);
+    route_table_advert_rx(2U, 1U, payload, 100U);
+    advert(payload, MESH_BROADCAST_ID, 0U);
+    route_table_advert_rx(3U, 2U, payload, 200U);
+    CHECK_EQ(route_table_next_hop(3U, 200U), 3U);
+}
+
+/* a route nobody refreshes is poisoned, then forgotten */
+static void test_ages_out(void) {
+    uint8_t payload[MESH_MAX_PAYLOAD];
+
+    route_table_init();
+    advert(payload, 3U, 1U);
+    route_table_advert_rx(2U, 1U, payload, 0U);
+    CHECK_EQ(route_table_next_hop(3U, ROUTE_MAX_AGE_MS), 2U);
+    CHECK_EQ(route_table_next_hop(3U, ROUTE_MAX_AGE_MS + 1U), MESH_BROADCAST_ID);
+    CHECK_EQ(advertised(3U, ROUTE_MAX_AGE_MS + 1U), ROUTE_COST_INFINITE);
+    CHECK_EQ(advertised(3U, ROUTE_MAX_AGE_MS + ROUTE_HOLDDOWN_MS + 1U), 0U);
+}
+
+int main(void) {
+    test_learn();
+    test_cheaper_takes_over();
+    test_poisoned();
+    test_poisoned_direct();
+    test_ages_out();
+    return test_done();
+}
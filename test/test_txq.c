@@ -0,0 +1,95 @@
+//
+// Created on 10/19/26.
+//
+
+#include <string.h>
+
+#include "ra-02_txq.h"
+#include "test.h"
+
+static void push(RA02_txq_t *q, uint8_t length) {
+    q->length[RA02_txq_at(q, q->count)] = length;
+    q->count++;
+}
+
+static void test_empty(void) {
+    RA02_txq_t txq[RA02_TXQ_CLASSES];
+    uint8_t turn = RA02_TXQ_INTERACTIVE;
+
+    (void)memset(txq, 0, sizeof(txq));
+    CHECK_EQ(RA02_txq_pick(txq, &turn), RA02_TXQ_CLASSES);
+    CHECK_EQ(RA02_txq_total(txq), 0U);
+}
+
+/* control goes first, whatever the others hold */
+static void test_control_first(void) {
+    RA02_txq_t txq[RA02_TXQ_CLASSES];
+    uint8_t turn = RA02_TXQ_INTERACTIVE;
+
+    (void)memset(txq, 0, sizeof(txq));
+    push(&txq[RA02_TXQ_BULK], PACKET_WIRE_MAX);
+    push(&txq[RA02_TXQ_INTERACTIVE], PACKET_WIRE_MAX);
+    push(&txq[RA02_TXQ_CONTROL], 8U);
+    push(&txq[RA02_TXQ_CONTROL], 8U);
+    CHECK_EQ(RA02_txq_total(txq), 4U);
+    for (uint8_t i = 0U; i < 2U; i++) {
+        CHECK_EQ(RA02_txq_pick(txq, &turn), RA02_TXQ_CONTROL);
+        RA02_txq_dequeue(txq, RA02_TXQ_CONTROL, 1U);
+    }
+    CHECK(RA02_txq_pick(txq, &turn) != RA02_TXQ_CONTROL);
+}
+
+/* both backlogged: the airtime splits by the quanta */
+static void test_drr_share(void) {
+    RA02_txq_t txq[RA02_TXQ_CLASSES];
+    uint8_t turn = RA02_TXQ_INTERACTIVE;
+    uint16_t sent[RA02_TXQ_CLASSES] = {0};
+
+    (void)memset(txq, 0, sizeof(txq));
+    for (uint16_t i = 0U; i < 400U; i++) {
+        uint8_t c;
+
+        while (txq[RA02_TXQ_INTERACTIVE].count < RA02_TXQ_INTERACTIVE_LEN) {
+            push(&txq[RA02_TXQ_INTERACTIVE], PACKET_WIRE_MAX);
+        }
+        while (txq[RA02_TXQ_BULK].count < RA02_TXQ_BULK_LEN) {
+            push(&txq[RA02_TXQ_BULK], PACKET_WIRE_MAX);
+        }
+        c = RA02_txq_pick(txq, &turn);
+        CHECK(c == RA02_TXQ_INTERACTIVE || c == RA02_TXQ_BULK);
+        sent[c]++;
+        RA02_txq_dequeue(txq, c, 1U);
+    }
+    CHECK_EQ(sent[RA02_TXQ_INTERACTIVE] * RA02_TXQ_BULK_QUANTUM,
+             sent[RA02_TXQ_BULK] * RA02_TXQ_INTERACTIVE_QUANTUM);
+}
+
+/* an aggregate overdraws the credit, the queue waits rounds until it paid it back */
+static void test_overdraw(void) {
+    RA02_txq_t txq[RA02_TXQ_CLASSES];
+    uint8_t turn = RA02_TXQ_INTERACTIVE;
+
+    (void)memset(txq, 0, sizeof(txq));
+    for (uint8_t i = 0U; i < 4U; i++) {
+        push(&txq[RA02_TXQ_BULK], PACKET_WIRE_MAX);
+    }
+    push(&txq[RA02_TXQ_INTERACTIVE], PACKET_WIRE_MAX);
+    CHECK_EQ(RA02_txq_pick(txq, &turn), RA02_TXQ_BULK);
+    RA02_txq_dequeue(txq, RA02_TXQ_BULK, 3U);
+    CHECK(txq[RA02_TXQ_BULK].deficit < 0);
+    CHECK_EQ(RA02_txq_pick(txq, &turn), RA02_TXQ_INTERACTIVE);
+    RA02_txq_dequeue(txq, RA02_TXQ_INTERACTIVE, 1U);
+    CHECK_EQ(txq[RA02_TXQ_INTERACTIVE].deficit, 0);
+    /* alone now: it gets its turns again, no credit saved while idle */
+    CHECK_EQ(RA02_txq_pick(txq, &turn), RA02_TXQ_BULK);
+    RA02_txq_dequeue(txq, RA02_TXQ_BULK, 1U);
+    CHECK_EQ(txq[RA02_TXQ_BULK].deficit, 0);
+}
+
+int main(void) {
+    test_empty();
+    test_control_first();
+    test_drr_share();
+    test_overdraw();
+    return test_done();
+}